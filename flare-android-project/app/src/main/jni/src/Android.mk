@@ -34,8 +34,10 @@ LOCAL_SRC_FILES := $(SDL_PATH)/src/main/android/SDL_android_main.c \
 	../../../../../../src/EngineSettings.cpp \
 	../../../../../../src/EventManager.cpp \
 	../../../../../../src/FileParser.cpp \
+	../../../../../../src/FileParserCache.cpp \
 	../../../../../../src/FogOfWar.cpp \
 	../../../../../../src/FontEngine.cpp \
+	../../../../../../src/FramePacer.cpp \
 	../../../../../../src/GameSlotPreview.cpp \
 	../../../../../../src/GameState.cpp \
 	../../../../../../src/GameStateConfig.cpp \
@@ -49,15 +51,21 @@ LOCAL_SRC_FILES := $(SDL_PATH)/src/main/android/SDL_android_main.c \
 	../../../../../../src/Hazard.cpp \
 	../../../../../../src/HazardManager.cpp \
 	../../../../../../src/IconManager.cpp \
+	../../../../../../src/ImageLoader.cpp \
 	../../../../../../src/InputState.cpp \
 	../../../../../../src/ItemManager.cpp \
 	../../../../../../src/ItemStorage.cpp \
+	../../../../../../src/LayerCompositor.cpp \
 	../../../../../../src/Loot.cpp \
 	../../../../../../src/LootManager.cpp \
 	../../../../../../src/Map.cpp \
+	../../../../../../src/MapBinary.cpp \
 	../../../../../../src/MapParallax.cpp \
 	../../../../../../src/MapCollision.cpp \
+	../../../../../../src/MapManifest.cpp \
 	../../../../../../src/MapRenderer.cpp \
+	../../../../../../src/MapStreamer.cpp \
+	../../../../../../src/MappedFile.cpp \
 	../../../../../../src/Menu.cpp \
 	../../../../../../src/MenuActionBar.cpp \
 	../../../../../../src/MenuActiveEffects.cpp \
@@ -85,14 +93,20 @@ LOCAL_SRC_FILES := $(SDL_PATH)/src/main/android/SDL_android_main.c \
 	../../../../../../src/MenuVendor.cpp \
 	../../../../../../src/MessageEngine.cpp \
 	../../../../../../src/ModManager.cpp \
+	../../../../../../src/ModPack.cpp \
 	../../../../../../src/NPC.cpp \
 	../../../../../../src/NPCManager.cpp \
+	../../../../../../src/NullRenderDevice.cpp \
+	../../../../../../src/NullSoundManager.cpp \
 	../../../../../../src/PowerManager.cpp \
+	../../../../../../src/Profiler.cpp \
 	../../../../../../src/QuestLog.cpp \
 	../../../../../../src/RenderDevice.cpp \
 	../../../../../../src/SaveLoad.cpp \
 	../../../../../../src/SDLInputState.cpp \
 	../../../../../../src/SDLHardwareRenderDevice.cpp \
+	../../../../../../src/SDLSoftwareBlit.cpp \
+	../../../../../../src/SDLSoftwareDrawList.cpp \
 	../../../../../../src/SDLSoftwareRenderDevice.cpp \
 	../../../../../../src/SDLSoundManager.cpp \
 	../../../../../../src/SDLFontEngine.cpp \
@@ -103,6 +117,8 @@ LOCAL_SRC_FILES := $(SDL_PATH)/src/main/android/SDL_android_main.c \
 	../../../../../../src/StatBlock.cpp \
 	../../../../../../src/Stats.cpp \
 	../../../../../../src/Subtitles.cpp \
+	../../../../../../src/TaskGraph.cpp \
+	../../../../../../src/TextCache.cpp \
 	../../../../../../src/TileSet.cpp \
 	../../../../../../src/TooltipData.cpp \
 	../../../../../../src/TooltipManager.cpp \
@@ -1555,7 +1555,7 @@ std::string Avatar::getGfxFromType(const std::string& gfx_type) {
 
 	// fall back to default if it exists
 	if (gfx.empty()) {
-		if (Filesystem::fileExists(mods->locate("animations/avatar/" + stats.gfx_base + "/default_" + gfx_type + ".txt")))
+		if (!mods->locate("animations/avatar/" + stats.gfx_base + "/default_" + gfx_type + ".txt").empty())
 			gfx = "default_" + gfx_type;
 	}
 
@@ -34,6 +34,7 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 Camera::Camera()
 	: pos()
 	, shake()
+	, prev_frame_shake()
 	, target()
 	, prev_cam_target()
 	, prev_cam_dx(0)
@@ -127,7 +128,7 @@ void Camera::setTarget(const FPoint& _target) {
 }
 
 void Camera::warpTo(const FPoint& _target) {
-	pos = shake = target = prev_cam_target = _target;
+	pos = shake = prev_frame_shake = target = prev_cam_target = _target;
 	shake_timer.reset(Timer::END);
 	prev_cam_dx = 0;
 	prev_cam_dy = 0;
@@ -42,6 +42,9 @@ public:
 	FPoint shake;
 	Timer shake_timer;
 
+	// shake at the start of the last logic frame, used to interpolate rendering between logic frames
+	FPoint prev_frame_shake;
+
 private:
 	FPoint target;
 	FPoint prev_cam_target;
@@ -41,6 +41,7 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 
 CampaignManager::CampaignManager()
 	: bonus_xp(0.0)
+	, status_mutex(SDL_CreateMutex())
 	, random_status(0) {
 }
 
@@ -50,15 +51,18 @@ StatusID CampaignManager::registerStatus(const std::string& s) {
 
 	StatusID new_id = Utils::hashString(s);
 
+	SDL_LockMutex(status_mutex);
+
 	// check if this status was already registered
 	StatusMap::iterator it;
 	it = status.find(new_id);
-	if (it != status.end())
-		return it->first;
+	if (it == status.end()) {
+		// register a new status
+		status[new_id].first = false;
+		status[new_id].second = s;
+	}
 
-	// register a new status
-	status[new_id].first = false;
-	status[new_id].second = s;
+	SDL_UnlockMutex(status_mutex);
 	return new_id;
 }
 
@@ -359,4 +363,6 @@ void CampaignManager::randomStatusUnset() {
 }
 
 CampaignManager::~CampaignManager() {
+	if (status_mutex)
+		SDL_DestroyMutex(status_mutex);
 }
@@ -74,6 +74,9 @@ public:
 private:
 	StatusMap status;
 
+	// statuses are registered by loaders that may run on worker threads
+	SDL_mutex* status_mutex;
+
 	std::vector<StatusID> random_status_pool;
 	StatusID random_status;
 };
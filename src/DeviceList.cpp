@@ -22,12 +22,16 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 
 #include "MessageEngine.h"
 #include "RenderDevice.h"
+#include "Settings.h"
+#include "SharedResources.h"
 
 #include "SDLSoftwareRenderDevice.h"
 #include "SDLHardwareRenderDevice.h"
+#include "NullRenderDevice.h"
 
 #include "SDLFontEngine.h"
 #include "SDLSoundManager.h"
+#include "NullSoundManager.h"
 #include "SDLInputState.h"
 
 RenderDevice* getRenderDevice(const std::string& name) {
@@ -35,6 +39,7 @@ RenderDevice* getRenderDevice(const std::string& name) {
 	if (name != "") {
 		if (name == "sdl") return new SDLSoftwareRenderDevice();
 		else if (name == "sdl_hardware") return new SDLHardwareRenderDevice();
+		else if (name == "null") return new NullRenderDevice();
 		else {
 			Utils::logError("DeviceList: Render device '%s' not found. Falling back to the default.", name.c_str());
 			return new SDLHardwareRenderDevice();
@@ -45,7 +50,7 @@ RenderDevice* getRenderDevice(const std::string& name) {
 	}
 }
 
-void createRenderDeviceList(MessageEngine* msg, std::vector<std::string> &rd_name, std::vector<std::string> &rd_desc) {
+void createRenderDeviceList(MessageEngine* _msg, std::vector<std::string> &rd_name, std::vector<std::string> &rd_desc) {
 	rd_name.clear();
 	rd_desc.clear();
 
@@ -53,10 +58,10 @@ void createRenderDeviceList(MessageEngine* msg, std::vector<std::string> &rd_nam
 	rd_desc.resize(2);
 
 	rd_name[0] = "sdl";
-	rd_desc[0] = msg->get("SDL software renderer\n\nOften slower, but less likely to have issues.");
+	rd_desc[0] = _msg->get("SDL software renderer\n\nOften slower, but less likely to have issues.");
 
 	rd_name[1] = "sdl_hardware";
-	rd_desc[1] = msg->get("SDL hardware renderer\n\nThe default renderer that is often faster than the SDL software renderer.");
+	rd_desc[1] = _msg->get("SDL hardware renderer\n\nThe default renderer that is often faster than the SDL software renderer.");
 }
 
 FontEngine* getFontEngine() {
@@ -64,6 +69,9 @@ FontEngine* getFontEngine() {
 }
 
 SoundManager* getSoundManager() {
+	if (!settings->audio)
+		return new NullSoundManager();
+
 	return new SDLSoundManager();
 }
 
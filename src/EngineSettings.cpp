@@ -85,7 +85,7 @@ void EngineSettings::Misc::load() {
 
 	FileParser infile;
 	// @CLASS EngineSettings: Misc|Description of engine/misc.txt
-	if (infile.open("engine/misc.txt", FileParser::MOD_FILE, FileParser::ERROR_NORMAL)) {
+	if (infile.open("engine/misc.txt", FileParser::MOD_FILE, FileParser::ERROR_NORMAL, FileParser::USE_CACHE)) {
 		while (infile.next()) {
 			// @ATTR save_hpmp|bool|When saving the game, keep the hero's current HP and MP.
 			if (infile.key == "save_hpmp")
@@ -224,7 +224,7 @@ void EngineSettings::Resolutions::load() {
 
 	FileParser infile;
 	// @CLASS EngineSettings: Resolution|Description of engine/resolutions.txt
-	if (infile.open("engine/resolutions.txt", FileParser::MOD_FILE, FileParser::ERROR_NORMAL)) {
+	if (infile.open("engine/resolutions.txt", FileParser::MOD_FILE, FileParser::ERROR_NORMAL, FileParser::USE_CACHE)) {
 		while (infile.next()) {
 			// @ATTR menu_frame_width|int|Width of frame for New Game, Configuration, etc. menus.
 			if (infile.key == "menu_frame_width")
@@ -296,7 +296,7 @@ void EngineSettings::Gameplay::load() {
 
 	FileParser infile;
 	// @CLASS EngineSettings: Gameplay|Description of engine/gameplay.txt
-	if (infile.open("engine/gameplay.txt", FileParser::MOD_FILE, FileParser::ERROR_NORMAL)) {
+	if (infile.open("engine/gameplay.txt", FileParser::MOD_FILE, FileParser::ERROR_NORMAL, FileParser::USE_CACHE)) {
 		while (infile.next()) {
 			if (infile.key == "enable_playgame") {
 				// @ATTR enable_playgame|bool|Enables the "Play Game" button on the main menu.
@@ -328,7 +328,7 @@ void EngineSettings::Combat::load() {
 
 	FileParser infile;
 	// @CLASS EngineSettings: Combat|Description of engine/combat.txt
-	if (infile.open("engine/combat.txt", FileParser::MOD_FILE, FileParser::ERROR_NORMAL)) {
+	if (infile.open("engine/combat.txt", FileParser::MOD_FILE, FileParser::ERROR_NORMAL, FileParser::USE_CACHE)) {
 		while (infile.next()) {
 			if (infile.key == "absorb_percent") {
 				// @ATTR absorb_percent|float, float : Minimum, Maximum|Limits the percentage of damage that can be absorbed. A max value less than 100 will ensure that the target always takes at least 1 damage from non-elemental attacks.
@@ -414,7 +414,7 @@ void EngineSettings::Elements::load() {
 
 	FileParser infile;
 	// @CLASS EngineSettings: Elements|Description of engine/elements.txt
-	if (infile.open("engine/elements.txt", FileParser::MOD_FILE, FileParser::ERROR_NORMAL)) {
+	if (infile.open("engine/elements.txt", FileParser::MOD_FILE, FileParser::ERROR_NORMAL, FileParser::USE_CACHE)) {
 		while (infile.next()) {
 			if (infile.new_section) {
 				if (infile.section == "element") {
@@ -454,7 +454,7 @@ void EngineSettings::EquipFlags::load() {
 
 	FileParser infile;
 	// @CLASS EngineSettings: Equip flags|Description of engine/equip_flags.txt
-	if (infile.open("engine/equip_flags.txt", FileParser::MOD_FILE, FileParser::ERROR_NORMAL)) {
+	if (infile.open("engine/equip_flags.txt", FileParser::MOD_FILE, FileParser::ERROR_NORMAL, FileParser::USE_CACHE)) {
 		while (infile.next()) {
 			if (infile.new_section) {
 				if (infile.section == "flag") {
@@ -491,7 +491,7 @@ void EngineSettings::PrimaryStats::load() {
 
 	FileParser infile;
 	// @CLASS EngineSettings: Primary Stats|Description of engine/primary_stats.txt
-	if (infile.open("engine/primary_stats.txt", FileParser::MOD_FILE, FileParser::ERROR_NORMAL)) {
+	if (infile.open("engine/primary_stats.txt", FileParser::MOD_FILE, FileParser::ERROR_NORMAL, FileParser::USE_CACHE)) {
 		while (infile.next()) {
 			if (infile.new_section) {
 				if (infile.section == "stat") {
@@ -550,7 +550,7 @@ void EngineSettings::HeroClasses::load() {
 
 	FileParser infile;
 	// @CLASS EngineSettings: Classes|Description of engine/classes.txt
-	if (infile.open("engine/classes.txt", FileParser::MOD_FILE, FileParser::ERROR_NORMAL)) {
+	if (infile.open("engine/classes.txt", FileParser::MOD_FILE, FileParser::ERROR_NORMAL, FileParser::USE_CACHE)) {
 		while (infile.next()) {
 			if (infile.new_section) {
 				if (infile.section == "class") {
@@ -664,7 +664,7 @@ void EngineSettings::DamageTypes::load() {
 
 	FileParser infile;
 	// @CLASS EngineSettings: Damage Types|Description of engine/damage_types.txt
-	if (infile.open("engine/damage_types.txt", FileParser::MOD_FILE, FileParser::ERROR_NORMAL)) {
+	if (infile.open("engine/damage_types.txt", FileParser::MOD_FILE, FileParser::ERROR_NORMAL, FileParser::USE_CACHE)) {
 		while (infile.next()) {
 			if (infile.new_section) {
 				if (infile.section == "damage_type") {
@@ -721,7 +721,7 @@ void EngineSettings::DeathPenalty::load() {
 
 	FileParser infile;
 	// @CLASS EngineSettings: Death penalty|Description of engine/death_penalty.txt
-	if (infile.open("engine/death_penalty.txt", FileParser::MOD_FILE, FileParser::ERROR_NORMAL)) {
+	if (infile.open("engine/death_penalty.txt", FileParser::MOD_FILE, FileParser::ERROR_NORMAL, FileParser::USE_CACHE)) {
 		while (infile.next()) {
 			// @ATTR enable|bool|Enable the death penalty.
 			if (infile.key == "enable") enabled = Parse::toBool(infile.val);
@@ -754,7 +754,7 @@ void EngineSettings::Tooltips::load() {
 
 	FileParser infile;
 	// @CLASS EngineSettings: Tooltips|Description of engine/tooltips.txt
-	if (infile.open("engine/tooltips.txt", FileParser::MOD_FILE, FileParser::ERROR_NORMAL)) {
+	if (infile.open("engine/tooltips.txt", FileParser::MOD_FILE, FileParser::ERROR_NORMAL, FileParser::USE_CACHE)) {
 		while (infile.next()) {
 			// @ATTR tooltip_offset|int|Offset in pixels from the origin point (usually mouse cursor).
 			if (infile.key == "tooltip_offset")
@@ -804,7 +804,7 @@ void EngineSettings::Loot::load() {
 
 	FileParser infile;
 	// @CLASS EngineSettings: Loot|Description of engine/loot.txt
-	if (infile.open("engine/loot.txt", FileParser::MOD_FILE, FileParser::ERROR_NORMAL)) {
+	if (infile.open("engine/loot.txt", FileParser::MOD_FILE, FileParser::ERROR_NORMAL, FileParser::USE_CACHE)) {
 		while (infile.next()) {
 			if (infile.key == "tooltip_margin") {
 				// @ATTR tooltip_margin|int|Vertical offset of the loot tooltip from the loot itself.
@@ -884,7 +884,7 @@ void EngineSettings::Tileset::load() {
 
 	FileParser infile;
 	// @CLASS EngineSettings: Tileset config|Description of engine/tileset_config.txt
-	if (infile.open("engine/tileset_config.txt", FileParser::MOD_FILE, FileParser::ERROR_NORMAL)) {
+	if (infile.open("engine/tileset_config.txt", FileParser::MOD_FILE, FileParser::ERROR_NORMAL, FileParser::USE_CACHE)) {
 		while (infile.next()) {
 			if (infile.key == "tile_size") {
 				// @ATTR tile_size|int, int : Width, Height|The width and height of a tile.
@@ -965,7 +965,7 @@ void EngineSettings::Widgets::load() {
 
 	FileParser infile;
 	// @CLASS EngineSettings: Widgets|Description of engine/widget_settings.txt
-	if (infile.open("engine/widget_settings.txt", FileParser::MOD_FILE, FileParser::ERROR_NONE)) {
+	if (infile.open("engine/widget_settings.txt", FileParser::MOD_FILE, FileParser::ERROR_NONE, FileParser::USE_CACHE)) {
 		while (infile.next()) {
 			if (infile.section == "misc") {
 				if (infile.key == "selection_rect_color") {
@@ -1040,7 +1040,7 @@ void EngineSettings::XPTable::load() {
 
 	FileParser infile;
 	// @CLASS EngineSettings: XP table|Description of engine/xp_table.txt
-	if (infile.open("engine/xp_table.txt", FileParser::MOD_FILE, FileParser::ERROR_NORMAL)) {
+	if (infile.open("engine/xp_table.txt", FileParser::MOD_FILE, FileParser::ERROR_NORMAL, FileParser::USE_CACHE)) {
 		while(infile.next()) {
 			if (infile.key == "level") {
 				// @ATTR level|int, int : Level, XP|The amount of XP required for this level.
@@ -1099,7 +1099,7 @@ void EngineSettings::NumberFormat::load() {
 
 	FileParser infile;
 	// @CLASS EngineSettings: Number Format|Description of engine/number_format.txt
-	if (infile.open("engine/number_format.txt", FileParser::MOD_FILE, FileParser::ERROR_NONE)) {
+	if (infile.open("engine/number_format.txt", FileParser::MOD_FILE, FileParser::ERROR_NONE, FileParser::USE_CACHE)) {
 		while (infile.next()) {
 			// @ATTR player_statbar|int|Number of digits after the decimal place to display for values in the player's statbars (HP/MP).
 			if (infile.key == "player_statbar")
@@ -1143,7 +1143,7 @@ void EngineSettings::ResourceStats::load() {
 
 	FileParser infile;
 	// @CLASS EngineSettings: Resource Stats|Description of engine/resource_stats.txt
-	if (infile.open("engine/resource_stats.txt", FileParser::MOD_FILE, FileParser::ERROR_NORMAL)) {
+	if (infile.open("engine/resource_stats.txt", FileParser::MOD_FILE, FileParser::ERROR_NORMAL, FileParser::USE_CACHE)) {
 		while (infile.next()) {
 			if (infile.new_section) {
 				if (infile.section == "resource_stat") {
@@ -49,6 +49,8 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 
 Entity::Entity()
 	: sprites(NULL)
+	, compositor()
+	, layer_renders()
 	, sound_attack()
 	, sound_hit()
 	, sound_die()
@@ -59,6 +61,7 @@ Entity::Entity()
 	, activeAnimation(NULL)
 	, animationSet(NULL)
 	, stats()
+	, prev_frame_pos()
 	, type_filename("")
 {
 	// MSVC complains if you use 'this' in the init list
@@ -83,6 +86,7 @@ Entity& Entity::operator=(const Entity& e) {
 	sound_lowhp = e.sound_lowhp;
 
 	stats = StatBlock(e.stats);
+	prev_frame_pos = e.prev_frame_pos;
 
 	activeAnimation = NULL;
 	animationSet = NULL;
@@ -838,27 +842,27 @@ Rect Entity::getRenderBounds(const FPoint& cam) const {
 
 void Entity::addRenders(std::vector<Renderable> &r) {
 	if (!stats.layer_reference_order.empty()) {
+		layer_renders.clear();
 		for (unsigned i = 0; i < stats.layer_def[stats.direction].size(); ++i) {
 			unsigned index = stats.layer_def[stats.direction][i];
 			if (anims[index]) {
 				Renderable ren = anims[index]->getCurrentFrame(stats.direction);
-				ren.map_pos = stats.pos;
 				ren.prio = i+1;
+				layer_renders.push_back(ren);
+			}
+		}
 
-				stats.effects.getCurrentColor(ren.color_mod);
-				stats.effects.getCurrentAlpha(ren.alpha_mod);
-
-				// fade out corpses
-				if (!stats.hero && stats.corpse) {
-					unsigned fade_time = (eset->misc.corpse_timeout > settings->max_frames_per_sec) ? settings->max_frames_per_sec : eset->misc.corpse_timeout;
-					if (fade_time != 0 && stats.corpse_timer.getCurrent() <= fade_time) {
-						ren.alpha_mod = static_cast<uint8_t>(static_cast<float>(stats.corpse_timer.getCurrent()) * (ren.alpha_mod / static_cast<float>(fade_time)));
-					}
-				}
-
-				ren.type = getRenderableType();
-
-				r.push_back(ren);
+		// a translucent character would show its inner layers, so it can't use a baked image
+		Renderable composite;
+		applyRenderMods(composite);
+		if (composite.alpha_mod == 255 && LayerCompositor::isEnabled() && compositor.compose(layer_renders, composite)) {
+			composite.prio = 1;
+			r.push_back(composite);
+		}
+		else {
+			for (size_t i = 0; i < layer_renders.size(); ++i) {
+				applyRenderMods(layer_renders[i]);
+				r.push_back(layer_renders[i]);
 			}
 		}
 	}
@@ -866,21 +870,9 @@ void Entity::addRenders(std::vector<Renderable> &r) {
 		Renderable ren;
 		if (activeAnimation)
 			ren = activeAnimation->getCurrentFrame(stats.direction);
-		ren.map_pos = stats.pos;
 		ren.prio = 1;
 
-		stats.effects.getCurrentColor(ren.color_mod);
-		stats.effects.getCurrentAlpha(ren.alpha_mod);
-
-		// fade out corpses
-		if (!stats.hero && stats.corpse) {
-			unsigned fade_time = (eset->misc.corpse_timeout > settings->max_frames_per_sec) ? settings->max_frames_per_sec : eset->misc.corpse_timeout;
-			if (fade_time != 0 && stats.corpse_timer.getCurrent() <= fade_time) {
-				ren.alpha_mod = static_cast<uint8_t>(static_cast<float>(stats.corpse_timer.getCurrent()) * (ren.alpha_mod / static_cast<float>(fade_time)));
-			}
-		}
-
-		ren.type = getRenderableType();
+		applyRenderMods(ren);
 
 		r.push_back(ren);
 	}
@@ -904,6 +896,26 @@ void Entity::addRenders(std::vector<Renderable> &r) {
 	}
 }
 
+/**
+ * Sets the position, effect modifiers and type of one of this entity's renderables
+ */
+void Entity::applyRenderMods(Renderable& ren) {
+	ren.map_pos = stats.pos;
+
+	stats.effects.getCurrentColor(ren.color_mod);
+	stats.effects.getCurrentAlpha(ren.alpha_mod);
+
+	// fade out corpses
+	if (!stats.hero && stats.corpse) {
+		unsigned fade_time = (eset->misc.corpse_timeout > settings->max_frames_per_sec) ? settings->max_frames_per_sec : eset->misc.corpse_timeout;
+		if (fade_time != 0 && stats.corpse_timer.getCurrent() <= fade_time) {
+			ren.alpha_mod = static_cast<uint8_t>(static_cast<float>(stats.corpse_timer.getCurrent()) * (ren.alpha_mod / static_cast<float>(fade_time)));
+		}
+	}
+
+	ren.type = getRenderableType();
+}
+
 uint8_t Entity::getRenderableType() {
 	if (stats.hp > 0) {
 		if (stats.hero)
@@ -936,6 +948,7 @@ void Entity::loadAnimations() {
 	}
 	animsets.clear();
 	anims.clear();
+	compositor.clear();
 
 	std::vector<Entity::Layer_gfx> img_gfx;
 
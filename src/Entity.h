@@ -28,6 +28,7 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 #define ENTITY_H
 
 #include "CommonIncludes.h"
+#include "LayerCompositor.h"
 #include "StatBlock.h"
 #include "Utils.h"
 
@@ -39,8 +40,13 @@ class Entity {
 protected:
 	Image *sprites;
 
+	// bakes the equipment layers into one image per frame
+	LayerCompositor compositor;
+	std::vector<Renderable> layer_renders;
+
 	void move_from_offending_tile();
 	void resetActiveAnimation();
+	void applyRenderMods(Renderable& ren);
 	uint8_t getRenderableType();
 
 public:
@@ -88,6 +94,9 @@ public:
 
 	StatBlock stats;
 
+	// stats.pos at the start of the last logic frame, used to interpolate rendering between logic frames
+	FPoint prev_frame_pos;
+
 	unsigned char faceNextBest(float mapx, float mapy);
 	Rect getRenderBounds(const FPoint& cam) const;
 
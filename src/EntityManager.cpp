@@ -35,6 +35,7 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 #include "MapRenderer.h"
 #include "MenuActionBar.h"
 #include "PowerManager.h"
+#include "Profiler.h"
 #include "RenderDevice.h"
 #include "Settings.h"
 #include "SharedGameResources.h"
@@ -398,6 +399,7 @@ void EntityManager::logic() {
 		(*it)->stats.hero_stealth = hero_stealth;
 		if (!(*it)->stats.npc) {
 			(*it)->logic();
+			Profiler::addCount(Profiler::COUNTER_ENTITIES);
 		}
 	}
 }
@@ -832,7 +832,7 @@ bool EventManager::executeEventInternal(Event &ev, bool skip_delay) {
 				ec->data[1].Int = random_ec.data[1].Int;
 			}
 
-			if (Filesystem::fileExists(mods->locate(ec->s))) {
+			if (!mods->locate(ec->s).empty()) {
 				mapr->teleportation = true;
 				mapr->teleport_mapname = ec->s;
 
@@ -862,7 +862,7 @@ bool EventManager::executeEventInternal(Event &ev, bool skip_delay) {
 			if (ec->s == "collision") {
 				if (ec->data[0].Int >= 0 && ec->data[0].Int < mapr->w && ec->data[1].Int >= 0 && ec->data[1].Int < mapr->h) {
 					mapr->collider.colmap[ec->data[0].Int][ec->data[1].Int] = static_cast<unsigned short>(ec->data[2].Int);
-					mapr->map_change = true;
+					mapr->setMapChange(ec->data[0].Int, ec->data[1].Int);
 				}
 				else
 					Utils::logError("EventManager: Mapmod at position (%d, %d) is out of bounds 0-255.", ec->data[0].Int, ec->data[1].Int);
@@ -873,8 +873,10 @@ bool EventManager::executeEventInternal(Event &ev, bool skip_delay) {
 					Utils::logError("EventManager: Mapmod at position (%d, %d) contains invalid tile id (%d).", ec->data[0].Int, ec->data[1].Int, ec->data[2].Int);
 				else if (index >= mapr->layers.size())
 					Utils::logError("EventManager: Mapmod at position (%d, %d) is on an invalid layer.", ec->data[0].Int, ec->data[1].Int);
-				else if (ec->data[0].Int >= 0 && ec->data[0].Int < mapr->w && ec->data[1].Int >= 0 && ec->data[1].Int < mapr->h)
+				else if (ec->data[0].Int >= 0 && ec->data[0].Int < mapr->w && ec->data[1].Int >= 0 && ec->data[1].Int < mapr->h) {
 					mapr->layers[index][ec->data[0].Int][ec->data[1].Int] = static_cast<unsigned short>(ec->data[2].Int);
+					mapr->updateFogOfWarCoverage(ec->data[0].Int, ec->data[1].Int, ec->data[0].Int, ec->data[1].Int);
+				}
 				else
 					Utils::logError("EventManager: Mapmod at position (%d, %d) is out of bounds 0-255.", ec->data[0].Int, ec->data[1].Int);
 			}
@@ -17,6 +17,7 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 */
 
 #include "FileParser.h"
+#include "FileParserCache.h"
 #include "ModManager.h"
 #include "SharedResources.h"
 #include "UtilsFileSystem.h"
@@ -29,21 +30,27 @@ FileParser::FileParser()
 	, is_mod_file(false)
 	, error_mode(ERROR_NORMAL)
 	, requested_filename("")
-	, line("")
+	, file_pos(0)
 	, line_number(0)
 	, include_fp(NULL)
+	, cache(NULL)
+	, recorder(NULL)
 	, new_section(false)
 	, section("")
 	, key("")
 	, val("") {
 }
 
-bool FileParser::open(const std::string& _filename, bool _is_mod_file, int _error_mode) {
+bool FileParser::open(const std::string& _filename, bool _is_mod_file, int _error_mode, bool _use_cache) {
+	delete cache;
+	cache = NULL;
+
 	is_mod_file = _is_mod_file;
 	error_mode = _error_mode;
 	requested_filename = _filename;
 
 	filenames.clear();
+	includes.clear();
 	if (is_mod_file) {
 		filenames = mods->list(Filesystem::convertSlashes(_filename), ModManager::LIST_FULL_PATHS);
 	}
@@ -59,51 +66,60 @@ bool FileParser::open(const std::string& _filename, bool _is_mod_file, int _erro
 		return false;
 	}
 
+	if (_use_cache && is_mod_file) {
+		cache = new FileParserCache();
+		if (cache->load(_filename, filenames))
+			return true;
+
+		cache->startRecording(_filename, filenames);
+		recorder = cache;
+	}
+
 	bool ret = false;
 
 	// Cycle through all filenames from the end, stopping when a file is to overwrite all further files.
 	for (size_t i=filenames.size(); i>0; i--) {
-		infile.open(filenames[i-1].c_str(), std::ios::in);
-		ret = infile.is_open();
+		ret = openFile(filenames[i-1]);
 
 		if (ret) {
 			// This will be the first file to be parsed. Seek to the start of the file and leave it open.
-			if (infile.good() && Parse::trim(Parse::getLine(infile)) != "APPEND") {
-				std::string test_line;
-
+			std::string_view test_line;
+			readLine(test_line);
+			if (Parse::trimView(test_line) != "APPEND") {
 				// get the first non-comment, non blank line
-				while (infile.good()) {
-					test_line = Parse::trim(Parse::getLine(infile));
-					if (Parse::skipLine(test_line))
-						continue;
-					else
+				test_line = std::string_view();
+				std::string_view next_line;
+				while (readLine(next_line)) {
+					test_line = Parse::trimView(next_line);
+					if (!Parse::skipLine(test_line))
 						break;
 				}
 
 				if (test_line != "APPEND") {
 					current_index = static_cast<unsigned>(i)-1;
-					infile.clear(); // reset flags
-					infile.seekg(0, std::ios::beg);
+					file_pos = 0;
 					break;
 				}
 			}
 
 			// don't close the final file if it's the only one with an "APPEND" line
 			if (i > 1) {
-				infile.close();
-				infile.clear();
+				closeFile();
 			}
 		}
 		else {
 			if (error_mode != ERROR_NONE)
 				Utils::logError("FileParser: Could not open text file: %s", filenames[i-1].c_str());
-			infile.clear();
 		}
 	}
 
 	return ret;
 }
 
+const std::vector<std::string>& FileParser::getIncludes() const {
+	return includes;
+}
+
 void FileParser::close() {
 	if (include_fp) {
 		include_fp->close();
@@ -111,9 +127,66 @@ void FileParser::close() {
 		include_fp = NULL;
 	}
 
-	if (infile.is_open())
-		infile.close();
-	infile.clear();
+	delete cache;
+	cache = NULL;
+	recorder = NULL;
+
+	closeFile();
+}
+
+bool FileParser::openData(const std::string& _filename, std::string_view data, int _error_mode) {
+	close();
+
+	is_mod_file = false;
+	error_mode = _error_mode;
+	requested_filename = _filename;
+
+	filenames.clear();
+	filenames.push_back(_filename);
+	current_index = 0;
+	line_number = 0;
+
+	file_data.assign(data);
+	file_pos = 0;
+	return true;
+}
+
+bool FileParser::openFile(const std::string& filename) {
+	file_pos = 0;
+	if (!mods->readFile(filename, file_data)) {
+		file_data.clear();
+		return false;
+	}
+	return true;
+}
+
+void FileParser::closeFile() {
+	file_data.clear();
+	file_pos = 0;
+}
+
+/**
+ * Returns the next line of the current file as a view into the file data, without the line ending
+ *
+ * @return false if there are no lines left
+ */
+bool FileParser::readLine(std::string_view& out) {
+	if (file_pos >= file_data.size()) {
+		out = std::string_view();
+		return false;
+	}
+
+	size_t eol = file_data.find('\n', file_pos);
+	if (eol == std::string::npos)
+		eol = file_data.size();
+
+	out = std::string_view(file_data).substr(file_pos, eol - file_pos);
+	file_pos = std::min(eol + 1, file_data.size());
+
+	if (!out.empty() && out.back() == '\r')
+		out.remove_suffix(1);
+
+	return true;
 }
 
 /**
@@ -124,20 +197,25 @@ void FileParser::close() {
  */
 bool FileParser::next() {
 
-	std::string starts_with;
+	if (cache && cache->isLoaded())
+		return cache->next(new_section, section, key, val);
+
+	std::string_view cur_line;
 	new_section = false;
 
 	while (current_index < filenames.size()) {
-		while (infile.good()) {
+		while (include_fp || file_pos < file_data.size()) {
 			if (include_fp) {
 				if (include_fp->next()) {
 					new_section = include_fp->new_section;
 					section = include_fp->section;
 					key = include_fp->key;
 					val = include_fp->val;
+					recordPair();
 					return true;
 				}
 				else {
+					includes.insert(includes.end(), include_fp->includes.begin(), include_fp->includes.end());
 					include_fp->close();
 					delete include_fp;
 					include_fp = NULL;
@@ -145,38 +223,45 @@ bool FileParser::next() {
 				}
 			}
 
-			line = Parse::trim(Parse::getLine(infile));
+			readLine(cur_line);
+			cur_line = Parse::trimView(cur_line);
 			line_number++;
 
-			if (Parse::skipLine(line))
+			if (Parse::skipLine(cur_line))
 				continue;
 
-			starts_with = line.at(0);
-
 			// set new section if this line is a section declaration
-			if (starts_with == "[") {
+			if (cur_line[0] == '[') {
 				new_section = true;
-				section = Parse::getSectionTitle(line);
+				section.assign(Parse::getSectionTitle(cur_line));
 
 				// keep searching for a key-pair
 				continue;
 			}
 
 			// skip the string used to combine files
-			if (line == "APPEND") continue;
+			if (cur_line == "APPEND") continue;
 
 			// read from a separate file
-			std::size_t first_space = line.find(' ');
+			std::size_t first_space = cur_line.find(' ');
 
-			if (first_space != std::string::npos) {
-				std::string directive = line.substr(0, first_space);
+			if (first_space != std::string_view::npos) {
+				std::string_view directive = cur_line.substr(0, first_space);
 
 				if (directive == "INCLUDE") {
-					std::string tmp = line.substr(first_space+1);
+					std::string tmp(cur_line.substr(first_space+1));
 
 					if (requested_filename != tmp) {
+						includes.push_back(tmp);
 						include_fp = new FileParser();
-						if (!include_fp || !include_fp->open(tmp, is_mod_file, error_mode)) {
+						include_fp->recorder = recorder;
+						bool include_opened = include_fp->open(tmp, is_mod_file, error_mode);
+
+						// a cache has to notice when the included files change, too
+						if (recorder)
+							recorder->addSource(tmp, include_fp->filenames);
+
+						if (!include_opened) {
 							delete include_fp;
 							include_fp = NULL;
 						}
@@ -195,23 +280,26 @@ bool FileParser::next() {
 			}
 
 			// this is a keypair. Perform basic parsing and return
-			Parse::getKeyPair(line, key, val);
+			Parse::getKeyPair(cur_line, key, val);
+			recordPair();
 			return true;
 		}
 
-		infile.close();
-		infile.clear();
+		closeFile();
 
 		current_index++;
-		if (current_index == filenames.size()) return false;
+		if (current_index == filenames.size()) {
+			// everything was parsed, so the cache is complete
+			if (cache && cache->isRecording())
+				cache->save();
+			return false;
+		}
 
 		line_number = 0;
 		const std::string current_filename = filenames[current_index];
-		infile.open(current_filename.c_str(), std::ios::in);
-		if (!infile.is_open()) {
+		if (!openFile(current_filename)) {
 			if (error_mode != ERROR_NONE)
 				Utils::logError("FileParser: Could not open text file: %s", current_filename.c_str());
-			infile.clear();
 			return false;
 		}
 		// a new file starts a new section
@@ -226,12 +314,13 @@ bool FileParser::next() {
  * Get an unparsed, unfiltered line from the input file
  */
 std::string FileParser::getRawLine() {
-	line = "";
+	// raw lines can't be replayed from a cache
+	if (recorder)
+		recorder->cancelRecording();
 
-	if (infile.good()) {
-		line = Parse::getLine(infile);
-	}
-	return line;
+	std::string_view raw_line;
+	readLine(raw_line);
+	return std::string(raw_line);
 }
 
 void FileParser::error(const char* format, ...) {
@@ -249,6 +338,11 @@ void FileParser::errorBuf(const char* buffer) {
 	if (include_fp) {
 		include_fp->errorBuf(buffer);
 	}
+	else if (cache && cache->isLoaded()) {
+		std::stringstream ss;
+		ss << "[" << cache->getFilename() << ":" << cache->getLineNumber() << "] " << buffer;
+		Utils::logError(ss.str().c_str());
+	}
 	else {
 		std::stringstream ss;
 		ss << "[" << filenames[current_index] << ":" << line_number << "] " << buffer;
@@ -257,9 +351,29 @@ void FileParser::errorBuf(const char* buffer) {
 }
 
 void FileParser::incrementLineNum() {
+	if (recorder)
+		recorder->cancelRecording();
+
 	line_number++;
 }
 
+void FileParser::recordPair() {
+	if (cache && cache->isRecording())
+		cache->addPair(new_section, section, key, val, getCurrentFilename(), getCurrentLineNumber());
+}
+
+const std::string& FileParser::getCurrentFilename() const {
+	if (include_fp)
+		return include_fp->getCurrentFilename();
+	return filenames[current_index];
+}
+
+unsigned FileParser::getCurrentLineNumber() const {
+	if (include_fp)
+		return include_fp->getCurrentLineNumber();
+	return line_number;
+}
+
 FileParser::~FileParser() {
 	close();
 }
@@ -27,29 +27,47 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 
 #include "CommonIncludes.h"
 
+#include <string_view>
+
+class FileParserCache;
+
 class FileParser {
 private:
 	void errorBuf(const char* buffer);
+	bool openFile(const std::string& filename);
+	void closeFile();
+	bool readLine(std::string_view& out);
+	void recordPair();
+	const std::string& getCurrentFilename() const;
+	unsigned getCurrentLineNumber() const;
 
 	std::vector<std::string> filenames;
+	std::vector<std::string> includes;
 	unsigned current_index;
 	bool is_mod_file;
 	int error_mode;
 	std::string requested_filename;
 
-	std::ifstream infile;
-	std::string line;
+	// the whole file is read at once, and lines are parsed as views into it
+	std::string file_data;
+	size_t file_pos;
 
 	unsigned line_number;
 
 	FileParser* include_fp;
 
+	// set when the key pairs are replayed from or recorded to a binary cache
+	FileParserCache* cache;
+	// the cache that INCLUDE files should be reported to, shared with include_fp
+	FileParserCache* recorder;
+
 public:
 	enum {
 		ERROR_NONE = 0,
 		ERROR_NORMAL = 1
 	};
 	static const bool MOD_FILE = true;
+	static const bool USE_CACHE = true;
 
 	FileParser();
 	~FileParser();
@@ -67,9 +85,27 @@ public:
 	 * NO_ERROR - when enabled, suppresses the error message when a file can't
 	 * be opened
 	 *
+	 * @param use_cache
+	 * Keep the parsed key pairs of this mod file in a binary cache, see FileParserCache.
+	 * Only for callers that never use getRawLine().
+	 *
 	 * @return true if file could be opened successfully for reading.
 	 */
-	bool open(const std::string& filename, bool _is_mod_file, int _error_mode);
+	bool open(const std::string& filename, bool _is_mod_file, int _error_mode, bool _use_cache = false);
+
+	/**
+	 * @brief openData
+	 * Parses text that is already in memory, such as a block stored in another file.
+	 * filename is only used for error messages. INCLUDE and APPEND are not resolved.
+	 */
+	bool openData(const std::string& filename, std::string_view data, int _error_mode);
+
+	/**
+	 * @brief getIncludes
+	 * The requested filenames of the files INCLUDEd so far, including those INCLUDEd by them.
+	 * Not filled when the key pairs are replayed from a cache.
+	 */
+	const std::vector<std::string>& getIncludes() const;
 
 	void close();
 	bool next();
@@ -0,0 +1,413 @@
+/*
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+/**
+ * class FileParserCache
+ *
+ * File layout, with all integers stored little-endian and strings as a u32 length followed by the bytes:
+ *   "FLAREFPC", u32 version, u32 checksum of everything after it, engine version string, requested filename
+ *   u32 source count, per source: requested filename, u32 file count, per file: path, u64 size, i64 mtime
+ *   u32 pair count, u32 pair data size, per pair: u8 flags, u32 file, u32 line, [section], key, val
+ *   u32 filename count, filenames referenced by the pairs
+ */
+
+#include "FileParserCache.h"
+#include "ModManager.h"
+#include "Settings.h"
+#include "SharedResources.h"
+#include "UtilsFileSystem.h"
+#include "Version.h"
+
+#include <stdio.h>
+#include <string.h>
+
+static const char MAGIC[8] = {'F', 'L', 'A', 'R', 'E', 'F', 'P', 'C'};
+static const size_t HEADER_SIZE = 16;
+
+static uint32_t getChecksum(const unsigned char* data, size_t size) {
+	// FNV-1a
+	uint32_t hash = 2166136261u;
+	for (size_t i = 0; i < size; ++i) {
+		hash ^= data[i];
+		hash *= 16777619u;
+	}
+	return hash;
+}
+
+FileParserCache::Reader::Reader()
+	: pos(NULL)
+	, end(NULL)
+	, ok(false)
+{
+}
+
+FileParserCache::Reader::Reader(const unsigned char* _pos, const unsigned char* _end)
+	: pos(_pos)
+	, end(_end)
+	, ok(true)
+{
+}
+
+uint8_t FileParserCache::Reader::readU8() {
+	if (!ok || end - pos < 1) {
+		ok = false;
+		return 0;
+	}
+	return *pos++;
+}
+
+uint32_t FileParserCache::Reader::readU32() {
+	if (!ok || end - pos < 4) {
+		ok = false;
+		return 0;
+	}
+	uint32_t value = static_cast<uint32_t>(pos[0]) | (static_cast<uint32_t>(pos[1]) << 8) | (static_cast<uint32_t>(pos[2]) << 16) | (static_cast<uint32_t>(pos[3]) << 24);
+	pos += 4;
+	return value;
+}
+
+uint64_t FileParserCache::Reader::readU64() {
+	uint64_t low = readU32();
+	uint64_t high = readU32();
+	return low | (high << 32);
+}
+
+std::string_view FileParserCache::Reader::readString() {
+	uint32_t length = readU32();
+	if (!ok || static_cast<size_t>(end - pos) < length) {
+		ok = false;
+		return std::string_view();
+	}
+	std::string_view value(reinterpret_cast<const char*>(pos), length);
+	pos += length;
+	return value;
+}
+
+bool FileParserCache::Reader::skip(size_t size) {
+	if (!ok || static_cast<size_t>(end - pos) < size) {
+		ok = false;
+		return false;
+	}
+	pos += size;
+	return true;
+}
+
+FileParserCache::FileParserCache()
+	: pairs_left(0)
+	, current_file(0)
+	, current_line(0)
+	, recording(false)
+	, pair_count(0)
+{
+}
+
+FileParserCache::~FileParserCache() {
+}
+
+std::string FileParserCache::getCachePath(const std::string& requested_filename) {
+	// FNV-1a, 64 bit
+	uint64_t hash = 14695981039346656037ull;
+	for (size_t i = 0; i < requested_filename.length(); ++i) {
+		hash ^= static_cast<unsigned char>(requested_filename[i]);
+		hash *= 1099511628211ull;
+	}
+
+	char name[32];
+	snprintf(name, sizeof(name), "%016llx.bin", static_cast<unsigned long long>(hash));
+	return settings->path_user + "cache/parser/" + name;
+}
+
+void FileParserCache::clear() {
+	file.close();
+	pairs = Reader();
+	pairs_left = 0;
+	pair_filenames.clear();
+	current_file = 0;
+	current_line = 0;
+
+	recording = false;
+	sources.clear();
+	pair_data.clear();
+	pair_count = 0;
+	recorded_filenames.clear();
+	last_section.clear();
+}
+
+bool FileParserCache::load(const std::string& requested_filename, const std::vector<std::string>& filenames) {
+	clear();
+	requested = requested_filename;
+
+	if (!file.open(getCachePath(requested_filename)))
+		return false;
+
+	const unsigned char* data = file.getData();
+	size_t size = file.getSize();
+
+	Reader reader(data, data + size);
+	if (size < HEADER_SIZE || memcmp(data, MAGIC, 8) != 0) {
+		clear();
+		return false;
+	}
+
+	reader.skip(8);
+	uint32_t version = reader.readU32();
+	uint32_t checksum = reader.readU32();
+	if (version != VERSION || checksum != getChecksum(data + HEADER_SIZE, size - HEADER_SIZE)) {
+		clear();
+		return false;
+	}
+
+	if (reader.readString() != VersionInfo::ENGINE.getString() || reader.readString() != requested_filename || !validateSources(reader, filenames)) {
+		clear();
+		return false;
+	}
+
+	pairs_left = reader.readU32();
+	uint32_t pairs_size = reader.readU32();
+	pairs = Reader(reader.pos, reader.pos);
+	if (!reader.skip(pairs_size)) {
+		clear();
+		return false;
+	}
+	pairs.end = reader.pos;
+
+	uint32_t filename_count = reader.readU32();
+	for (uint32_t i = 0; i < filename_count && reader.ok; ++i) {
+		pair_filenames.push_back(reader.readString());
+	}
+
+	if (!reader.ok) {
+		clear();
+		return false;
+	}
+
+	return true;
+}
+
+/**
+ * Checks that the same files would be parsed now, and that none of them changed since the cache was written
+ */
+bool FileParserCache::validateSources(Reader& reader, const std::vector<std::string>& filenames) {
+	uint32_t source_count = reader.readU32();
+	for (uint32_t i = 0; i < source_count && reader.ok; ++i) {
+		std::string source_requested(reader.readString());
+
+		// the first source is the file that was opened, which the parser has already listed for us
+		std::vector<std::string> source_filenames;
+		if (i == 0)
+			source_filenames = filenames;
+		else
+			source_filenames = mods->list(Filesystem::convertSlashes(source_requested), ModManager::LIST_FULL_PATHS);
+
+		uint32_t file_count = reader.readU32();
+		if (!reader.ok || file_count != source_filenames.size())
+			return false;
+
+		for (uint32_t j = 0; j < file_count; ++j) {
+			std::string_view path = reader.readString();
+			uint64_t size = reader.readU64();
+			int64_t mtime = static_cast<int64_t>(reader.readU64());
+
+			uint64_t current_size = 0;
+			int64_t current_mtime = 0;
+			if (!reader.ok || path != source_filenames[j] || !mods->getFileStamp(source_filenames[j], current_size, current_mtime))
+				return false;
+			if (size != current_size || mtime != current_mtime)
+				return false;
+		}
+	}
+
+	return reader.ok;
+}
+
+bool FileParserCache::isLoaded() const {
+	return file.getData() != NULL;
+}
+
+bool FileParserCache::next(bool& new_section, std::string& section, std::string& key, std::string& val) {
+	if (pairs_left == 0)
+		return false;
+
+	uint8_t flags = pairs.readU8();
+	current_file = pairs.readU32();
+	current_line = pairs.readU32();
+	if (flags & PAIR_SECTION_CHANGED)
+		section.assign(pairs.readString());
+	key.assign(pairs.readString());
+	val.assign(pairs.readString());
+
+	if (!pairs.ok) {
+		pairs_left = 0;
+		return false;
+	}
+
+	new_section = (flags & PAIR_NEW_SECTION) != 0;
+	pairs_left--;
+	return true;
+}
+
+std::string FileParserCache::getFilename() const {
+	if (current_file < pair_filenames.size())
+		return std::string(pair_filenames[current_file]);
+	return requested;
+}
+
+unsigned FileParserCache::getLineNumber() const {
+	return current_line;
+}
+
+void FileParserCache::startRecording(const std::string& requested_filename, const std::vector<std::string>& filenames) {
+	clear();
+	requested = requested_filename;
+	recording = true;
+	addSource(requested_filename, filenames);
+}
+
+bool FileParserCache::isRecording() const {
+	return recording;
+}
+
+void FileParserCache::addSource(const std::string& requested_filename, const std::vector<std::string>& filenames) {
+	if (!recording)
+		return;
+
+	Source source;
+	source.requested_filename = requested_filename;
+	source.filenames = filenames;
+	sources.push_back(source);
+}
+
+void FileParserCache::addPair(bool new_section, const std::string& section, const std::string& key, const std::string& val, const std::string& filename, unsigned line_number) {
+	if (!recording)
+		return;
+
+	std::map<std::string, uint32_t>::iterator it = recorded_filenames.find(filename);
+	if (it == recorded_filenames.end())
+		it = recorded_filenames.insert(std::pair<std::string, uint32_t>(filename, static_cast<uint32_t>(recorded_filenames.size()))).first;
+
+	bool section_changed = (pair_count == 0 || section != last_section);
+
+	uint8_t flags = 0;
+	if (new_section) flags |= PAIR_NEW_SECTION;
+	if (section_changed) flags |= PAIR_SECTION_CHANGED;
+
+	pair_data.push_back(static_cast<char>(flags));
+	writeU32(pair_data, it->second);
+	writeU32(pair_data, line_number);
+	if (section_changed) {
+		writeString(pair_data, section);
+		last_section = section;
+	}
+	writeString(pair_data, key);
+	writeString(pair_data, val);
+
+	pair_count++;
+}
+
+/**
+ * Called when the parser is used in a way that the cache can't replay, such as reading raw lines
+ */
+void FileParserCache::cancelRecording() {
+	clear();
+}
+
+void FileParserCache::save() {
+	if (!recording)
+		return;
+
+	std::string out(MAGIC, 8);
+	writeU32(out, VERSION);
+	writeU32(out, 0); // checksum, filled in below
+
+	writeString(out, VersionInfo::ENGINE.getString());
+	writeString(out, requested);
+
+	writeU32(out, static_cast<uint32_t>(sources.size()));
+	for (size_t i = 0; i < sources.size(); ++i) {
+		writeString(out, sources[i].requested_filename);
+		writeU32(out, static_cast<uint32_t>(sources[i].filenames.size()));
+		for (size_t j = 0; j < sources[i].filenames.size(); ++j) {
+			uint64_t size = 0;
+			int64_t mtime = 0;
+			if (!mods->getFileStamp(sources[i].filenames[j], size, mtime)) {
+				clear();
+				return;
+			}
+			writeString(out, sources[i].filenames[j]);
+			writeU64(out, size);
+			writeU64(out, static_cast<uint64_t>(mtime));
+		}
+	}
+
+	writeU32(out, pair_count);
+	writeU32(out, static_cast<uint32_t>(pair_data.size()));
+	out += pair_data;
+
+	std::vector<std::string> filenames(recorded_filenames.size());
+	std::map<std::string, uint32_t>::iterator it;
+	for (it = recorded_filenames.begin(); it != recorded_filenames.end(); ++it) {
+		filenames[it->second] = it->first;
+	}
+	writeU32(out, static_cast<uint32_t>(filenames.size()));
+	for (size_t i = 0; i < filenames.size(); ++i) {
+		writeString(out, filenames[i]);
+	}
+
+	uint32_t checksum = getChecksum(reinterpret_cast<const unsigned char*>(out.data()) + HEADER_SIZE, out.size() - HEADER_SIZE);
+	for (size_t i = 0; i < 4; ++i) {
+		out[12 + i] = static_cast<char>(checksum >> (i * 8));
+	}
+
+	clear();
+
+	// write to a temporary file first, so that an interrupted write never leaves a broken cache behind
+	Filesystem::createDir(settings->path_user + "cache");
+	Filesystem::createDir(settings->path_user + "cache/parser");
+
+	std::string cache_path = getCachePath(requested);
+	std::string temp_path = cache_path + ".tmp";
+
+	std::ofstream outfile(temp_path.c_str(), std::ios::out | std::ios::binary);
+	if (!outfile.is_open())
+		return;
+
+	outfile.write(out.data(), static_cast<std::streamsize>(out.size()));
+	outfile.close();
+
+	if (outfile.fail()) {
+		Filesystem::removeFile(temp_path);
+		return;
+	}
+
+	if (Filesystem::fileExists(cache_path))
+		Filesystem::removeFile(cache_path);
+	Filesystem::renameFile(temp_path, cache_path);
+}
+
+void FileParserCache::writeU32(std::string& out, uint32_t value) {
+	for (size_t i = 0; i < 4; ++i) {
+		out.push_back(static_cast<char>(value >> (i * 8)));
+	}
+}
+
+void FileParserCache::writeU64(std::string& out, uint64_t value) {
+	writeU32(out, static_cast<uint32_t>(value));
+	writeU32(out, static_cast<uint32_t>(value >> 32));
+}
+
+void FileParserCache::writeString(std::string& out, std::string_view value) {
+	writeU32(out, static_cast<uint32_t>(value.length()));
+	out.append(value.data(), value.length());
+}
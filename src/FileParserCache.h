@@ -0,0 +1,116 @@
+/*
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+/**
+ * class FileParserCache
+ *
+ * Stores the key/value pairs that a FileParser returned for a mod file, after INCLUDE
+ * and APPEND were resolved, in a binary file under [PATH_USER]/cache/parser/.
+ * The next time the same file is opened, the pairs are replayed from a memory-mapped
+ * copy of that file instead of parsing the text again.
+ *
+ * A cache is only used if it was written by the same engine version, the same
+ * files still provide the data (so no mod was added or removed), and all of those
+ * files still have the same size and modification time.
+ */
+
+#ifndef FILE_PARSER_CACHE_H
+#define FILE_PARSER_CACHE_H
+
+#include "CommonIncludes.h"
+#include "MappedFile.h"
+
+#include <stdint.h>
+#include <string_view>
+
+class FileParserCache {
+public:
+	FileParserCache();
+	~FileParserCache();
+
+	// replaying a cache
+	bool load(const std::string& requested_filename, const std::vector<std::string>& filenames);
+	bool isLoaded() const;
+	bool next(bool& new_section, std::string& section, std::string& key, std::string& val);
+	std::string getFilename() const;
+	unsigned getLineNumber() const;
+
+	// recording a new cache while the text is parsed
+	void startRecording(const std::string& requested_filename, const std::vector<std::string>& filenames);
+	bool isRecording() const;
+	void addSource(const std::string& requested_filename, const std::vector<std::string>& filenames);
+	void addPair(bool new_section, const std::string& section, const std::string& key, const std::string& val, const std::string& filename, unsigned line_number);
+	void cancelRecording();
+	void save();
+
+private:
+	static const uint32_t VERSION = 1;
+
+	enum {
+		PAIR_NEW_SECTION = 1,
+		PAIR_SECTION_CHANGED = 2
+	};
+
+	// bounds-checked reading from the mapped cache file
+	class Reader {
+	public:
+		Reader();
+		Reader(const unsigned char* _pos, const unsigned char* _end);
+		uint8_t readU8();
+		uint32_t readU32();
+		uint64_t readU64();
+		std::string_view readString();
+		bool skip(size_t size);
+
+		const unsigned char* pos;
+		const unsigned char* end;
+		bool ok;
+	};
+
+	class Source {
+	public:
+		std::string requested_filename;
+		std::vector<std::string> filenames;
+	};
+
+	static std::string getCachePath(const std::string& requested_filename);
+
+	bool validateSources(Reader& reader, const std::vector<std::string>& filenames);
+	void clear();
+
+	static void writeU32(std::string& out, uint32_t value);
+	static void writeU64(std::string& out, uint64_t value);
+	static void writeString(std::string& out, std::string_view value);
+
+	std::string requested;
+
+	// replaying
+	MappedFile file;
+	Reader pairs;
+	uint32_t pairs_left;
+	std::vector<std::string_view> pair_filenames;
+	uint32_t current_file;
+	uint32_t current_line;
+
+	// recording
+	bool recording;
+	std::vector<Source> sources;
+	std::string pair_data;
+	uint32_t pair_count;
+	std::map<std::string, uint32_t> recorded_filenames;
+	std::string last_section;
+};
+
+#endif
@@ -53,9 +53,10 @@ FogOfWar::FogOfWar()
 	, color_sight(255,255,255)
 	, color_fog(128,128,128)
 	, color_dark(0,0,0)
-	, update_minimap(true)
+	, dirty_tiles(0,0,0,0)
+	, dirty_dark(0,0,0,0)
 	, loaded(false)
-	, prev_hero_pos(-1, -1) {
+	, prev_hero_tile(-1, -1) {
 }
 
 int FogOfWar::load() {
@@ -141,6 +142,7 @@ int FogOfWar::load() {
 			for (unsigned short i=0; i<bits_per_tile; i++) {
 				TILE_HIDDEN = static_cast<unsigned short>(TILE_HIDDEN | static_cast<unsigned short>(1<<i));
 			}
+			calcStepRuns();
 		}
 
 		def_tiles.clear();
@@ -171,22 +173,30 @@ int FogOfWar::load() {
 		}
 	}
 
+	// force the mask to be applied on the first logic tick of this map
+	prev_hero_tile = Point(-1, -1);
+
 	loaded = true;
 
 	return 0;
 }
 
 void FogOfWar::logic() {
-	if (prev_hero_pos.x == pc->stats.pos.x && prev_hero_pos.y == pc->stats.pos.y)
+	// the mask is applied at the hero's tile, so moving within a tile can't change anything
+	const Point hero_tile(pc->stats.pos);
+	if (prev_hero_tile.x == hero_tile.x && prev_hero_tile.y == hero_tile.y)
 		return;
 
-	prev_hero_pos = pc->stats.pos;
+	updateTiles(prev_hero_tile);
+
+	prev_hero_tile = hero_tile;
+
+	if (dirty_tiles.w > 0) {
+		mapr->updateFogOfWarCoverage(dirty_tiles.x, dirty_tiles.y, dirty_tiles.w-1, dirty_tiles.h-1);
+	}
 
-	updateTiles();
-	if (update_minimap) {
-		calcMiniBoundaries();
-		menu->mini->update(&mapr->collider, &bounds);
-		update_minimap = false;
+	if (dirty_dark.w > 0) {
+		menu->mini->update(&mapr->collider, &dirty_dark);
 	}
 }
 
@@ -200,6 +210,11 @@ void FogOfWar::handleIntramapTeleport() {
 			}
 		}
 	}
+
+	mapr->updateFogOfWarCoverage(bounds.x, bounds.y, bounds.w, bounds.h);
+
+	// the area around the old position was reset, so the next update can't rely on the previous mask
+	prev_hero_tile = Point(-1, -1);
 }
 
 Color FogOfWar::getTileColorMod(const int_fast16_t x, const int_fast16_t y) {
@@ -218,38 +233,138 @@ void FogOfWar::calcBoundaries() {
 	bounds.h = static_cast<short>(pc->stats.pos.y)+mask_radius;
 }
 
-void FogOfWar::calcMiniBoundaries() {
-	bounds.x = static_cast<short>(pc->stats.pos.x)-mask_radius;
-	bounds.y = static_cast<short>(pc->stats.pos.y)-mask_radius;
-	bounds.w = static_cast<short>(pc->stats.pos.x)+mask_radius;
-	bounds.h = static_cast<short>(pc->stats.pos.y)+mask_radius;
-
-	if (bounds.x < 0) bounds.x = 0;
-	if (bounds.y < 0) bounds.y = 0;
-	if (bounds.w > mapr->w) bounds.w = mapr->w;
-	if (bounds.h > mapr->h) bounds.h = mapr->h;
-}
+/**
+ * Applies the mask around the hero's tile to the dark and fog layers.
+ * When the hero moved to a neighboring tile of prev_tile, the mask was already applied one step away,
+ * so only the tiles where the two placements differ (the leading and trailing edges of the mask) are updated.
+ * Otherwise the whole mask is applied.
+ * The changed tiles are recorded in dirty_tiles and dirty_dark.
+ */
+void FogOfWar::updateTiles(const Point& prev_tile) {
+	dirty_tiles = Rect(0, 0, 0, 0);
+	dirty_dark = Rect(0, 0, 0, 0);
 
-void FogOfWar::updateTiles() {
 	if (!def_mask)
 		return;
 
 	calcBoundaries();
-	const unsigned short * mask = &def_mask[0];
 
-	for (int x = bounds.x; x <= bounds.w; x++) {
-		for (int y = bounds.y; y <= bounds.h; y++) {
-			if (x>=0 && y>=0 && x < mapr->w && y < mapr->h) {
-				unsigned short prev_dark_tile = mapr->layers[dark_layer_id][x][y];
+	// clip the mask to the map
+	const int x_begin = std::max(bounds.x, 0);
+	const int x_end = std::min(bounds.w + 1, static_cast<int>(mapr->w));
+	const int y_begin = std::max(bounds.y, 0);
+	const int y_end = std::min(bounds.h + 1, static_cast<int>(mapr->h));
+
+	if (x_begin >= x_end || y_begin >= y_end)
+		return;
+
+	const int dx = bounds.x + mask_radius - prev_tile.x;
+	const int dy = bounds.y + mask_radius - prev_tile.y;
+
+	if (prev_tile.x < 0 || prev_tile.y < 0 || abs(dx) > 1 || abs(dy) > 1) {
+		for (int x = x_begin; x < x_end; x++) {
+			applyMaskColumn(x, y_begin, y_end);
+		}
+		return;
+	}
+
+	const std::vector<MaskRun>& runs = step_runs[stepIndex(dx, dy)];
+	for (size_t i = 0; i < runs.size(); ++i) {
+		const int x = bounds.x + runs[i].x;
+		if (x < x_begin || x >= x_end)
+			continue;
+
+		const int run_begin = std::max(bounds.y + runs[i].y_begin, y_begin);
+		const int run_end = std::min(bounds.y + runs[i].y_end, y_end);
+		if (run_begin < run_end)
+			applyMaskColumn(x, run_begin, run_end);
+	}
+}
+
+/**
+ * Applies rows [y_begin, y_end) of the mask to map column x.
+ * The mask is stored with rows along the map's y axis, which matches the layout of each layer column,
+ * so the column is processed as one contiguous run that the compiler can vectorize.
+ */
+void FogOfWar::applyMaskColumn(int x, int y_begin, int y_end) {
+	const int mask_size = mask_radius*2+1;
+	const size_t run = static_cast<size_t>(y_end - y_begin);
+
+	const unsigned short* mask = &def_mask[(x - bounds.x) * mask_size + (y_begin - bounds.y)];
+	unsigned short* dark = &mapr->layers[dark_layer_id][x][y_begin];
+	unsigned short* fog = &mapr->layers[fog_layer_id][x][y_begin];
+
+	unsigned short dark_changed = 0;
+	unsigned short fog_changed = 0;
+
+	for (size_t k = 0; k < run; ++k) {
+		const unsigned short new_dark = static_cast<unsigned short>(dark[k] & mask[k]);
+		dark_changed = static_cast<unsigned short>(dark_changed | (dark[k] ^ new_dark));
+		fog_changed = static_cast<unsigned short>(fog_changed | (fog[k] ^ mask[k]));
+		dark[k] = new_dark;
+		fog[k] = mask[k];
+	}
 
-				mapr->layers[dark_layer_id][x][y] &= *mask;
-				mapr->layers[fog_layer_id][x][y] = *mask;
+	if (dark_changed)
+		addDirtyColumn(dirty_dark, x, y_begin, y_end);
+	if (dark_changed || fog_changed)
+		addDirtyColumn(dirty_tiles, x, y_begin, y_end);
+}
 
-				if (prev_dark_tile != mapr->layers[dark_layer_id][x][y]) {
-					update_minimap = true;
+void FogOfWar::addDirtyColumn(Rect& dirty, int x, int y_begin, int y_end) {
+	if (dirty.w == 0) {
+		dirty = Rect(x, y_begin, x+1, y_end);
+	}
+	else {
+		dirty.x = std::min(dirty.x, x);
+		dirty.y = std::min(dirty.y, y_begin);
+		dirty.w = std::max(dirty.w, x+1);
+		dirty.h = std::max(dirty.h, y_end);
+	}
+}
+
+int FogOfWar::stepIndex(int dx, int dy) {
+	return (dx + 1) * 3 + (dy + 1);
+}
+
+/**
+ * For every step to a neighboring tile, finds the mask tiles whose value differs from the tile
+ * that covered the same map position before the step. Tiles that the previous placement didn't cover
+ * always differ. For a circular mask, each column yields a short run at the leading and trailing edge.
+ */
+void FogOfWar::calcStepRuns() {
+	const int mask_size = mask_radius*2+1;
+
+	for (int dx = -1; dx <= 1; dx++) {
+		for (int dy = -1; dy <= 1; dy++) {
+			std::vector<MaskRun>& runs = step_runs[stepIndex(dx, dy)];
+			runs.clear();
+
+			if (dx == 0 && dy == 0)
+				continue;
+
+			for (int i = 0; i < mask_size; i++) {
+				int run_begin = -1;
+				for (int j = 0; j <= mask_size; j++) {
+					bool differs = false;
+					if (j < mask_size) {
+						const int prev_i = i + dx;
+						const int prev_j = j + dy;
+						if (prev_i < 0 || prev_j < 0 || prev_i >= mask_size || prev_j >= mask_size)
+							differs = true;
+						else
+							differs = def_mask[i * mask_size + j] != def_mask[prev_i * mask_size + prev_j];
+					}
+
+					if (differs && run_begin == -1) {
+						run_begin = j;
+					}
+					else if (!differs && run_begin != -1) {
+						runs.push_back(MaskRun(i, run_begin, j));
+						run_begin = -1;
+					}
 				}
 			}
-			mask++;
 		}
 	}
 }
@@ -71,20 +71,39 @@ private:
 	void loadDefTile(FileParser &infile);
 	void loadDefMask(FileParser &infile);
 
+	// rows [y_begin, y_end) of mask column x that differ from the mask placed one tile step away
+	class MaskRun {
+	public:
+		int x;
+		int y_begin;
+		int y_end;
+		MaskRun(int _x, int _y_begin, int _y_end) : x(_x), y_begin(_y_begin), y_end(_y_end) {}
+	};
+
+	// indexed by stepIndex(); only the tiles in these runs change when the hero moves to a neighboring tile
+	std::vector<MaskRun> step_runs[9];
+
+	void calcStepRuns();
+	int stepIndex(int dx, int dy);
+
 	Rect bounds;
 
 	Color color_sight;
 	Color color_fog;
 	Color color_dark;
 
-	bool update_minimap;
+	// tiles changed by the last call to updateTiles(); w/h are exclusive end coordinates, w == 0 means nothing changed
+	Rect dirty_tiles; // either layer changed, used for the renderer's fog of war coverage
+	Rect dirty_dark; // dark layer changed, used for the minimap
+
 	bool loaded;
 
 	void calcBoundaries();
-	void calcMiniBoundaries();
-	void updateTiles();
+	void updateTiles(const Point& prev_tile);
+	void applyMaskColumn(int x, int y_begin, int y_end);
+	void addDirtyColumn(Rect& dirty, int x, int y_begin, int y_end);
 
-	FPoint prev_hero_pos;
+	Point prev_hero_tile;
 };
 
 #endif
@@ -25,6 +25,8 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 
 #include "FileParser.h"
 #include "FontEngine.h"
+#include "RenderDevice.h"
+#include "SharedResources.h"
 #include "UtilsParsing.h"
 
 FontStyle::FontStyle()
@@ -110,100 +112,25 @@ size_t FontEngine::stringToFontColor(const std::string& val) {
 Point FontEngine::calc_size(const std::string& text_with_newlines, int width) {
 	char newline = 10;
 
-	std::string text = text_with_newlines;
-
-	// if this contains newlines, recurse
-	size_t check_newline = text.find_first_of(newline);
-	if (check_newline != std::string::npos) {
-		Point p1 = calc_size(text.substr(0, check_newline), width);
-		Point p2 = calc_size(text.substr(check_newline+1, text.length()), width);
-		Point p3;
-
-		if (p1.x > p2.x) p3.x = p1.x;
-		else p3.x = p2.x;
-
-		p3.y = p1.y + p2.y;
-		return p3;
-	}
-
-	int height = 0;
-	int max_width = 0;
-
-	std::string next_word;
-	std::string builder("");
-	std::string builder_prev("");
-	char space = 32;
-	size_t cursor = 0;
-	std::string fulltext = text + " ";
-	std::string long_token;
-
-	builder.reserve(BUILDER_RESERVE);
-	builder_prev.reserve(BUILDER_RESERVE);
-
-	next_word = getNextToken(fulltext, cursor, space);
-
-	while(cursor != std::string::npos) {
-		size_t old_cursor = cursor;
-
-		builder += next_word;
-
-		if (calc_width(builder) > width) {
-
-			// this word can't fit on this line, so word wrap
-			if (!builder_prev.empty()) {
-				height += getLineHeight();
-				if (calc_width(builder_prev) > max_width) {
-					max_width = calc_width(builder_prev);
-				}
-			}
-
-			builder = "";
-
-			long_token = popTokenByWidth(next_word, width);
-
-			if (!long_token.empty()) {
-				while (!long_token.empty()) {
-					if (calc_width(next_word) > max_width) {
-						max_width = calc_width(next_word);
-					}
-					height += getLineHeight();
-
-					next_word = long_token;
-					long_token = popTokenByWidth(next_word, width);
-
-					if (long_token == next_word)
-						break;
-				}
-			}
+	Point size;
 
-			builder += next_word + " ";
-			builder_prev = builder;
-		}
-		else {
-			builder +=  " ";
-			builder_prev = builder;
-		}
+	// each line is wrapped on its own
+	size_t line_start = 0;
+	while (true) {
+		size_t line_end = text_with_newlines.find_first_of(newline, line_start);
+		size_t line_length = (line_end == std::string::npos ? std::string::npos : line_end - line_start);
 
-		next_word = getNextToken(fulltext, cursor, space); // next word
+		const FontLayout& layout = getLayout(text_with_newlines.substr(line_start, line_length), width);
+		if (layout.size.x > size.x)
+			size.x = layout.size.x;
+		size.y += layout.size.y;
 
-		// next token is the same location as the previous token; abort
-		if (cursor == old_cursor)
+		if (line_end == std::string::npos)
 			break;
-	}
 
-	builder = Parse::trim(builder); //removes whitespace that shouldn't be included in the size
-	if (!builder.empty())
-		height += getLineHeight();
-	if (calc_width(builder) > max_width)
-		max_width = calc_width(builder);
-
-	// handle blank lines
-	if (text_with_newlines == " ")
-		height += getLineHeight();
+		line_start = line_end + 1;
+	}
 
-	Point size;
-	size.x = max_width;
-	size.y = height;
 	return size;
 }
 
@@ -241,109 +168,214 @@ void FontEngine::render(const std::string& text, int x, int y, int justify, Imag
 		return;
 	}
 
-	std::string fulltext = text + " ";
 	cursor_y = y;
-	std::string next_word;
-	std::string builder("");
-	std::string builder_prev("");
-	char space = 32;
-	size_t cursor = 0;
-	std::string long_token;
 
-	builder.reserve(BUILDER_RESERVE);
-	builder_prev.reserve(BUILDER_RESERVE);
+	const FontLayout& layout = getLayout(text, width);
+	for (size_t i = 0; i < layout.lines.size(); ++i) {
+		renderInternal(layout.lines[i], x, cursor_y, justify, target, color);
+		cursor_y += getLineHeight();
+	}
+}
 
-	next_word = getNextToken(fulltext, cursor, space);
+void FontEngine::renderShadowed(const std::string& text, int x, int y, int justify, Image *target, int width, const Color& color) {
+	render(text, x+1, y+1, justify, target, width, getColor(COLOR_BLACK));
+	render(text, x, y, justify, target, width, color);
+}
 
-	while(cursor != std::string::npos) {
-		size_t old_cursor = cursor;
+/**
+ * Returns an image of the text, sized to fit it, using the given font.
+ * When width is greater than 0, the text is wrapped to that width.
+ * Images are kept in the text cache, so repeated strings are only rendered once.
+ * The caller must unref() the returned image.
+ */
+Image* FontEngine::renderToCachedImage(const std::string& font_style, const std::string& text, const Color& color, bool shadowed, int width) {
+	if (text.empty())
+		return NULL;
 
-		builder += next_word;
+	TextCacheKey key(font_style, text, color, shadowed, width);
 
-		if (calc_width(builder) > width) {
-			if (!builder_prev.empty()) {
-				renderInternal(builder_prev, x, cursor_y, justify, target, color);
-				cursor_y += getLineHeight();
-			}
-			builder = "";
+	Image* image = text_cache.lookup(key);
+	if (image)
+		return image;
 
-			long_token = popTokenByWidth(next_word, width);
+	setFont(font_style);
 
-			if (!long_token.empty()) {
-				while (!long_token.empty()) {
-					renderInternal(next_word, x, cursor_y, justify, target, color);
-					cursor_y += getLineHeight();
+	Point size;
+	if (width > 0) {
+		size = calc_size(text, width);
 
-					next_word = long_token;
-					long_token = popTokenByWidth(next_word, width);
+		// leave room for the shadow below and to the right of the last line
+		if (shadowed) {
+			size.x++;
+			size.y++;
+		}
+	}
+	else {
+		size.x = calc_width(text);
+		size.y = getFontHeight();
+	}
+
+	image = render_device->createImage(size.x, size.y);
+	if (!image)
+		return NULL;
+
+	if (shadowed)
+		renderShadowed(text, 0, 0, JUSTIFY_LEFT, image, width, color);
+	else
+		render(text, 0, 0, JUSTIFY_LEFT, image, width, color);
+
+	text_cache.store(key, image);
+	return image;
+}
+
+/**
+ * Returns the word-wrapped lines of the text for the active font, wrapping it only if it hasn't been seen recently
+ */
+const FontLayout& FontEngine::getLayout(const std::string& text, int width) {
+	FontLayoutKey key;
+	key.style = getActiveFont();
+	key.width = width;
+	key.text = text;
+
+	std::map<FontLayoutKey, FontLayout>::iterator it = layouts.find(key);
+	if (it != layouts.end())
+		return it->second;
+
+	// most layouts are for tooltips and the like, so there's no need for anything smarter than starting over
+	if (layouts.size() >= MAX_LAYOUTS)
+		layouts.clear();
+
+	FontLayout& layout = layouts[key];
+	wrapText(text, width, layout);
+	return layout;
+}
+
+/**
+ * Splits a line of text into lines that fit the width, breaking at spaces when possible.
+ * Words that don't fit on a line of their own are split between characters.
+ * The lines keep their trailing space; only the width of the last line ignores it.
+ * Instead of building each line in its own string, lines are tracked as ranges of the text.
+ */
+void FontEngine::wrapText(const std::string& text, int width, FontLayout& layout) {
+	layout.lines.clear();
+	layout.size = Point();
+
+	int height = 0;
+	int max_width = 0;
+
+	std::string fulltext = text + " ";
+
+	// the line being built is [builder_start, builder_end), the last one that fit is [prev_start, prev_end)
+	size_t builder_start = 0;
+	size_t builder_end = 0;
+	size_t prev_start = 0;
+	size_t prev_end = 0;
+
+	size_t cursor = 0;
+	size_t word_start = 0;
+	size_t word_end = getNextToken(fulltext, cursor);
+
+	while (cursor != std::string::npos) {
+		size_t old_cursor = cursor;
+
+		// the builder always ends right where the next word starts, so adding the word only extends it
+		if (builder_start == builder_end)
+			builder_start = word_start;
+		builder_end = word_end;
+
+		if (calcWidth(fulltext, builder_start, builder_end) > width) {
 
-					if (long_token == next_word)
-						break;
-				}
+			// this word can't fit on this line, so word wrap
+			if (prev_start != prev_end) {
+				layout.lines.push_back(fulltext.substr(prev_start, prev_end - prev_start));
+				height += getLineHeight();
+				max_width = std::max(max_width, calcWidth(fulltext, prev_start, prev_end));
 			}
 
-			builder += next_word + " ";
-			builder_prev = builder;
+			// split words that are too long for a line of their own
+			size_t split = fitToWidth(fulltext, word_start, word_end, width);
+			while (split > word_start && split < word_end) {
+				layout.lines.push_back(fulltext.substr(word_start, split - word_start));
+				height += getLineHeight();
+				max_width = std::max(max_width, calcWidth(fulltext, word_start, split));
+
+				word_start = split;
+				split = fitToWidth(fulltext, word_start, word_end, width);
+			}
+
+			builder_start = word_start;
+			builder_end = word_end + 1;
 		}
 		else {
-			builder += " ";
-			builder_prev = builder;
+			builder_end = word_end + 1;
 		}
+		prev_start = builder_start;
+		prev_end = builder_end;
 
-		next_word = getNextToken(fulltext, cursor, space); // next word
+		word_start = cursor;
+		word_end = getNextToken(fulltext, cursor); // next word
 
 		// next token is the same location as the previous token; abort
 		if (cursor == old_cursor)
 			break;
 	}
 
-	renderInternal(builder, x, cursor_y, justify, target, color);
-	cursor_y += getLineHeight();
+	layout.lines.push_back(fulltext.substr(builder_start, builder_end - builder_start));
 
+	// the trailing whitespace of the last line isn't included in the size
+	std::string last_line = Parse::trim(layout.lines.back());
+	if (!last_line.empty())
+		height += getLineHeight();
+	max_width = std::max(max_width, calc_width(last_line));
+
+	// handle blank lines
+	if (text == " ")
+		height += getLineHeight();
+
+	layout.size.x = max_width;
+	layout.size.y = height;
 }
 
-void FontEngine::renderShadowed(const std::string& text, int x, int y, int justify, Image *target, int width, const Color& color) {
-	render(text, x+1, y+1, justify, target, width, getColor(COLOR_BLACK));
-	render(text, x, y, justify, target, width, color);
+/**
+ * Measures text[start, end) without allocating a new string
+ */
+int FontEngine::calcWidth(const std::string& text, size_t start, size_t end) {
+	measure_buffer.assign(text, start, end - start);
+	return calc_width(measure_buffer);
 }
 
-/*
- * Fits a string, "text", to a pixel "width".
- * The original string is mutated to fit within the width.
- * Returns a string that is the remainder of the original string that could not fit in the width.
+/**
+ * Returns the end of the longest start of text[start, end) that fits in the width, not splitting UTF-8 sequences.
+ * If not even one character fits, start is returned.
  */
-std::string FontEngine::popTokenByWidth(std::string& text, int width) {
-	size_t new_length = 0;
+size_t FontEngine::fitToWidth(const std::string& text, size_t start, size_t end, int width) {
+	size_t new_end = start;
 
-	for (size_t i = 0; i <= text.length(); ++i) {
-		if (i < text.length() && (text[i] & 0xc0) == 0x80)
+	for (size_t i = start + 1; i <= end; ++i) {
+		if (i < end && (text[i] & 0xc0) == 0x80)
 			continue;
 
-		if (calc_width(text.substr(0, i)) > width)
+		if (calcWidth(text, start, i) > width)
 			break;
 
-		new_length = i;
+		new_end = i;
 	}
 
-	if (new_length > 0) {
-		std::string ret = text.substr(new_length, text.length());
-		text = text.substr(0, new_length);
-		return ret;
-	}
-	else {
-		return text;
-	}
+	return new_end;
 }
 
-// similar to Parse::popFirstString but does not alter the input string
-std::string FontEngine::getNextToken(const std::string& s, size_t &cursor, char separator) {
-	size_t seppos = s.find_first_of(separator, cursor);
+/**
+ * Finds the end of the space-separated token at cursor and moves the cursor past the space.
+ * The cursor is set to npos when there is no space left.
+ */
+size_t FontEngine::getNextToken(const std::string& s, size_t &cursor) {
+	char space = 32;
+
+	size_t seppos = s.find_first_of(space, cursor);
 	if (seppos == std::string::npos) { // not found
 		cursor = std::string::npos;
-		return "";
+		return seppos;
 	}
-	std::string outs = s.substr(cursor, seppos-cursor);
 	cursor = seppos+1;
-	return outs;
+	return seppos;
 }
-
@@ -22,6 +22,7 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 #define FONT_ENGINE_H
 
 #include "CommonIncludes.h"
+#include "TextCache.h"
 #include "Utils.h"
 
 class FontStyle {
@@ -37,6 +38,30 @@ public:
 	virtual ~FontStyle() {};
 };
 
+/**
+ * The result of word-wrapping a string
+ */
+class FontLayout {
+public:
+	std::vector<std::string> lines;
+	Point size;
+};
+
+class FontLayoutKey {
+public:
+	FontStyle *style;
+	int width;
+	std::string text;
+
+	bool operator<(const FontLayoutKey& other) const {
+		if (style != other.style)
+			return style < other.style;
+		if (width != other.width)
+			return width < other.width;
+		return text < other.text;
+	}
+};
+
 /**
  *
  * class FontEngine
@@ -82,6 +107,7 @@ public:
 
 	void render(const std::string& text, int x, int y, int justify, Image *target, int width, const Color& color);
 	void renderShadowed(const std::string& text, int x, int y, int justify, Image *target, int width, const Color& color);
+	Image* renderToCachedImage(const std::string& font_style, const std::string& text, const Color& color, bool shadowed, int width);
 
 	virtual int getLineHeight() = 0;
 	virtual int getFontHeight() = 0;
@@ -92,17 +118,28 @@ public:
 
 	int cursor_y;
 
+	TextCache text_cache;
+
 protected:
 	size_t stringToFontColor(const std::string& val);
 	Rect position(const std::string& text, int x, int y, int justify);
+	virtual FontStyle* getActiveFont() = 0;
 	virtual void renderInternal(const std::string& text, int x, int y, int justify, Image *target, const Color& color) = 0;
-	std::string popTokenByWidth(std::string& text, int width);
-	std::string getNextToken(const std::string& s, size_t& cursor, char separator);
 
 	std::vector<Color> font_colors;
 
 private:
-	static const size_t BUILDER_RESERVE = 128;
+	static const size_t MAX_LAYOUTS = 1024;
+
+	const FontLayout& getLayout(const std::string& text, int width);
+	void wrapText(const std::string& text, int width, FontLayout& layout);
+	int calcWidth(const std::string& text, size_t start, size_t end);
+	size_t fitToWidth(const std::string& text, size_t start, size_t end, int width);
+	size_t getNextToken(const std::string& s, size_t& cursor);
+
+	// wrapped text, keyed by the font, width and text
+	std::map<FontLayoutKey, FontLayout> layouts;
+	std::string measure_buffer;
 };
 
 #endif
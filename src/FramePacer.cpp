@@ -0,0 +1,58 @@
+/*
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+/**
+ * class FramePacer
+ */
+
+#include "FramePacer.h"
+
+FramePacer::FramePacer()
+	: oversleep(static_cast<float>(secondsToTicks(0.001f)))
+{
+}
+
+void FramePacer::waitUntil(uint64_t deadline) {
+	const float ticks_per_ms = static_cast<float>(SDL_GetPerformanceFrequency()) / 1000.f;
+
+	uint64_t now = SDL_GetPerformanceCounter();
+	while (now < deadline) {
+		float remaining = static_cast<float>(deadline - now);
+
+		// waking up a little early is better than missing the deadline, so stop once another sleep would likely overshoot
+		if (remaining <= oversleep)
+			break;
+
+		Uint32 delay_ms = std::max(static_cast<Uint32>((remaining - oversleep) / ticks_per_ms), static_cast<Uint32>(1));
+		SDL_Delay(delay_ms);
+
+		uint64_t after = SDL_GetPerformanceCounter();
+		float slept = static_cast<float>(after - now);
+		float requested = static_cast<float>(delay_ms) * ticks_per_ms;
+
+		// adapt quickly when the oversleep grows, and slowly when it shrinks, since being late is worse
+		float error = std::max(slept - requested, 0.f);
+		if (error > oversleep)
+			oversleep += (error - oversleep) * 0.5f;
+		else
+			oversleep += (error - oversleep) * 0.05f;
+
+		now = after;
+	}
+}
+
+uint64_t FramePacer::secondsToTicks(float seconds) {
+	return static_cast<uint64_t>(seconds * static_cast<float>(SDL_GetPerformanceFrequency()));
+}
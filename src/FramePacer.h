@@ -0,0 +1,44 @@
+/*
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+/**
+ * class FramePacer
+ *
+ * Waits for frame deadlines by sleeping, without busy-waiting.
+ * SDL_Delay() tends to oversleep by a platform-dependent amount, so the pacer
+ * measures that and wakes up early by the same margin.
+ */
+
+#ifndef FRAME_PACER_H
+#define FRAME_PACER_H
+
+#include "CommonIncludes.h"
+
+class FramePacer {
+public:
+	FramePacer();
+
+	// sleeps until roughly the given SDL_GetPerformanceCounter() value
+	void waitUntil(uint64_t deadline);
+
+	// number of performance counter ticks in the given number of seconds
+	static uint64_t secondsToTicks(float seconds);
+
+private:
+	// average amount that SDL_Delay() oversleeps by, in performance counter ticks
+	float oversleep;
+};
+
+#endif
@@ -106,6 +106,7 @@ void GameSlotPreview::loadGraphics(std::vector<std::string> _img_gfx) {
 	}
 	animsets.clear();
 	anims.clear();
+	compositor.clear();
 
 	for (unsigned int i=0; i<_img_gfx.size(); i++) {
 		if (_img_gfx[i] != "") {
@@ -163,14 +164,24 @@ void GameSlotPreview::addRenders(std::vector<Renderable> &r) {
 
 	unsigned char dir = *direction;
 
+	layer_renders.clear();
 	for (unsigned i = 0; i < layer_def[dir].size(); ++i) {
 		unsigned index = layer_def[dir][i];
 		if (index < anims.size() && anims[index]) {
 			Renderable ren = anims[index]->getCurrentFrame(dir);
 			ren.prio = i+1;
-			r.push_back(ren);
+			layer_renders.push_back(ren);
 		}
 	}
+
+	Renderable composite;
+	if (LayerCompositor::isEnabled() && compositor.compose(layer_renders, composite)) {
+		composite.prio = 1;
+		r.push_back(composite);
+	}
+	else {
+		r.insert(r.end(), layer_renders.begin(), layer_renders.end());
+	}
 }
 
 void GameSlotPreview::setStatBlock(StatBlock *_stats) {
@@ -213,7 +224,7 @@ void GameSlotPreview::loadDefaultGraphics() {
 
 	// fall back to default if it exists
 	for (size_t i = 0; i < layer_reference_order.size(); ++i) {
-		bool exists = Filesystem::fileExists(mods->locate("animations/avatar/" + stats->gfx_base + "/default_" + layer_reference_order[i] + ".txt"));
+		bool exists = !mods->locate("animations/avatar/" + stats->gfx_base + "/default_" + layer_reference_order[i] + ".txt").empty();
 		if (exists) {
 			default_gfx.push_back("default_" + layer_reference_order[i]);
 		}
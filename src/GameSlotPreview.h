@@ -28,6 +28,7 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 #define AVATAR_GRAPHICS_H
 
 #include "CommonIncludes.h"
+#include "LayerCompositor.h"
 #include "Utils.h"
 
 class Animation;
@@ -47,6 +48,9 @@ private:
 
 	std::vector<std::string> default_gfx;
 
+	LayerCompositor compositor;
+	std::vector<Renderable> layer_renders;
+
 public:
 	GameSlotPreview();
 	~GameSlotPreview();
@@ -30,6 +30,7 @@ GameState::GameState()
 	, force_refresh_background(false)
 	, save_settings_on_exit(true)
 	, load_counter(0)
+	, render_interpolation(1)
 	, requestedGameState(NULL)
 	, exitRequested(false)
 	, loading_tip(new WidgetTooltip())
@@ -52,6 +53,7 @@ GameState& GameState::operator=(const GameState& other) {
 	force_refresh_background = other.force_refresh_background;
 	save_settings_on_exit = other.save_settings_on_exit;
 	load_counter = other.load_counter;
+	render_interpolation = other.render_interpolation;
 	requestedGameState = other.requestedGameState;
 	exitRequested = other.exitRequested;
 	loading_tip = new WidgetTooltip();
@@ -93,6 +95,10 @@ bool GameState::isPaused() {
 	return false;
 }
 
+bool GameState::isPlaying() {
+	return false;
+}
+
 void GameState::showLoading() {
 	if (!loading_tip)
 		return;
@@ -41,6 +41,7 @@ public:
 	}
 	void setLoadingFrame();
 	virtual bool isPaused();
+	virtual bool isPlaying();
 	void showLoading();
 
 	bool hasMusic;
@@ -52,6 +53,9 @@ public:
 
 	int load_counter;
 
+	// how far rendering is between the previous logic frame (0) and the current one (1)
+	float render_interpolation;
+
 protected:
 	GameState* requestedGameState;
 	bool exitRequested;
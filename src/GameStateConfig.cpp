@@ -89,6 +89,7 @@ void GameStateConfig::logicAccept() {
 		reload_backgrounds = true;
 		delete mods;
 		mods = new ModManager(NULL);
+		render_device->freeUnusedImages();
 		settings->prev_save_slot = -1;
 	}
 	delete msg;
@@ -267,7 +267,7 @@ int Scene::logic() {
 		if (!image_filename.empty()) {
 			clearArt();
 
-			Image *graphics = render_device->loadImage(image_filename, RenderDevice::ERROR_NORMAL);
+			Image *graphics = render_device->loadImageAsync(image_filename, RenderDevice::ERROR_NORMAL);
 			if (graphics != NULL) {
 				art = graphics->createSprite();
 				art_size.x = art->getGraphicsWidth();
@@ -319,7 +319,7 @@ int Scene::logic() {
 				else if (components[i].type == "image") {
 					VScrollComponent vsc;
 
-					Image *graphics = render_device->loadImage(components[i].s, RenderDevice::ERROR_NORMAL);
+					Image *graphics = render_device->loadImageAsync(components[i].s, RenderDevice::ERROR_NORMAL);
 					if (graphics != NULL) {
 						vsc.image = graphics->createSprite();
 						if (vsc.image) {
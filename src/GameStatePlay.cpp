@@ -66,6 +66,7 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 #include "NPC.h"
 #include "NPCManager.h"
 #include "PowerManager.h"
+#include "Profiler.h"
 #include "QuestLog.h"
 #include "RenderDevice.h"
 #include "SaveLoad.h"
@@ -73,12 +74,47 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 #include "SharedGameResources.h"
 #include "SharedResources.h"
 #include "SoundManager.h"
+#include "TaskGraph.h"
 #include "UtilsParsing.h"
 #include "WidgetLabel.h"
 #include "XPScaling.h"
 
 #include <cassert>
 
+// tasks for GameStatePlay::loadDatabases()
+static void loadItemsTask(void*) {
+	if (items == NULL)
+		items = new ItemManager();
+}
+
+static void loadItemSoundsTask(void*) {
+	items->loadSounds();
+}
+
+static void loadEffectsTask(void*) {
+	powers->loadEffects();
+}
+
+static void loadPowersTask(void*) {
+	powers->loadPowers();
+}
+
+static void loadPowerResourcesTask(void*) {
+	powers->loadResources();
+}
+
+static void loadLootTablesTask(void*) {
+	loot->loadLootTables();
+}
+
+static void loadLootGraphicsTask(void*) {
+	loot->loadGraphics();
+}
+
+static void loadEnemyGroupsTask(void*) {
+	enemyg = new EnemyGroupManager();
+}
+
 GameStatePlay::GameStatePlay()
 	: GameState()
 	, enemy(NULL)
@@ -91,19 +127,17 @@ GameStatePlay::GameStatePlay()
 	has_background = false;
 	// GameEngine scope variables
 
-	if (items == NULL)
-		items = new ItemManager();
-
 	camp = new CampaignManager();
 	combat_manager = new CombatManager();
 
 	loot = new LootManager();
 	powers = new PowerManager();
+	loadDatabases();
+
 	fow = new FogOfWar();
 	mapr = new MapRenderer();
 	pc = new Avatar();
 	entitym = new EntityManager();
-	enemyg = new EnemyGroupManager();
 	hazards = new HazardManager();
 	menu = new MenuManager();
 	npcs = new NPCManager();
@@ -116,6 +150,32 @@ GameStatePlay::GameStatePlay()
 	refreshWidgets();
 }
 
+/**
+ * Parses the item, power, loot and enemy databases in parallel. Animations and sounds
+ * are created by the tasks that run on the main thread, once the data they need is parsed.
+ */
+void GameStatePlay::loadDatabases() {
+	TaskGraph graph;
+
+	size_t task_items = graph.add("items", loadItemsTask, NULL);
+	size_t task_item_sounds = graph.add("item sounds", loadItemSoundsTask, NULL, TaskGraph::MAIN_THREAD);
+	size_t task_effects = graph.add("effects", loadEffectsTask, NULL);
+	size_t task_powers = graph.add("powers", loadPowersTask, NULL);
+	size_t task_power_resources = graph.add("power resources", loadPowerResourcesTask, NULL, TaskGraph::MAIN_THREAD);
+	size_t task_loot_tables = graph.add("loot tables", loadLootTablesTask, NULL);
+	size_t task_loot_graphics = graph.add("loot graphics", loadLootGraphicsTask, NULL, TaskGraph::MAIN_THREAD);
+	graph.add("enemy groups", loadEnemyGroupsTask, NULL);
+
+	graph.addDependency(task_item_sounds, task_items);
+	graph.addDependency(task_powers, task_effects);
+	graph.addDependency(task_powers, task_items); // required_items
+	graph.addDependency(task_power_resources, task_powers);
+	graph.addDependency(task_loot_tables, task_items);
+	graph.addDependency(task_loot_graphics, task_items);
+
+	graph.run();
+}
+
 void GameStatePlay::refreshWidgets() {
 	menu->alignAll();
 }
@@ -375,8 +435,10 @@ void GameStatePlay::checkTeleport() {
 			entitym->handleNewMap();
 			npcs->handleNewMap();
 			resetNPC();
+			mapr->releaseStreamedMap();
 
 			menu->mini->prerender(&mapr->collider, mapr->w, mapr->h);
+			mapr->map_change = false;
 
 			// return to title (permadeath) OR auto-save
 			if (pc->stats.permadeath && pc->stats.cur_state == StatBlock::ENTITY_DEAD) {
@@ -844,6 +906,8 @@ void GameStatePlay::updateActionBar(unsigned index) {
  * This is the main game loop function that coordinates all game systems.
  */
 void GameStatePlay::logic() {
+    saveFramePositions();
+
     // Handle window resize events
     if (inpt->window_resized) {
         refreshWidgets();
@@ -853,7 +917,10 @@ void GameStatePlay::logic() {
     curs->setLowHP(pc->isLowHpCursorEnabled() && pc->isLowHp());
 
     checkCutscene();
-    menu->logic(); // Process menus first for input priority
+    {
+        PROFILE_ZONE(Profiler::ZONE_MENUS);
+        menu->logic(); // Process menus first for input priority
+    }
 
 	// Process gameplay logic when not paused
     if (!isPaused()) {
@@ -871,9 +938,15 @@ void GameStatePlay::logic() {
     processPausedActions();
 
     // Update map and quest state
-    mapr->logic(isPaused());
+    {
+        PROFILE_ZONE(Profiler::ZONE_MAP);
+        mapr->logic(isPaused());
+    }
     mapr->enemies_cleared = entitym->isCleared();
-    quests->logic();
+    {
+        PROFILE_ZONE(Profiler::ZONE_QUESTS);
+        quests->logic();
+    }
 
     // Handle character transformation
     pc->checkTransform();
@@ -905,6 +978,8 @@ void GameStatePlay::logic() {
 
 	// Check for combat initiation and ongoing combat logic
     checkCombatState();
+
+    markPartyNPCs();
 }
 
 /**
@@ -939,16 +1014,31 @@ void GameStatePlay::processUnpausedActions() {
 
     // Process action queue and player logic
     menu->act->checkAction(pc->action_queue);
-    pc->logic();
+    {
+        PROFILE_ZONE(Profiler::ZONE_AVATAR);
+        pc->logic();
+    }
 
     // Update stealth mechanics
     entitym->hero_stealth = std::min(pc->stats.get(Stats::STEALTH), 100.0f);
 
     // Update game systems
-    entitym->logic();
-    hazards->logic();
-    loot->logic();
-    npcs->logic();
+    {
+        PROFILE_ZONE(Profiler::ZONE_ENTITIES);
+        entitym->logic();
+    }
+    {
+        PROFILE_ZONE(Profiler::ZONE_HAZARDS);
+        hazards->logic();
+    }
+    {
+        PROFILE_ZONE(Profiler::ZONE_LOOT);
+        loot->logic();
+    }
+    {
+        PROFILE_ZONE(Profiler::ZONE_NPCS);
+        npcs->logic();
+    }
     snd->logic(pc->stats.pos);
     comb->logic(mapr->cam.pos);
 }
@@ -1125,6 +1215,9 @@ void GameStatePlay::render() {
         return;
     }
 
+    // Draw moving objects (and the camera) between their last two logic positions
+    interpolatePositions();
+
     // Containers for renderable game objects
     std::vector<Renderable> livingEntities;    // Entities that can move
     std::vector<Renderable> deadEntities;      // Static entities
@@ -1137,30 +1230,138 @@ void GameStatePlay::render() {
     hazards->addRenders(livingEntities, deadEntities);  // Hazards/effects
 
     // Render map and all collected entities
-    mapr->render(livingEntities, deadEntities);
+    {
+        PROFILE_ZONE(Profiler::ZONE_RENDER_MAP);
+        mapr->render(livingEntities, deadEntities);
+    }
 
     // Render UI elements
     loot->renderTooltips(mapr->cam.pos);
 
     // Update and render minimap
     if (mapr->map_change) {
-        menu->mini->prerender(&mapr->collider, mapr->w, mapr->h);
+        menu->mini->update(&mapr->collider, &mapr->map_change_area);
         mapr->map_change = false;
     }
     menu->mini->setMapTitle(mapr->title);
     menu->mini->render(pc->stats.pos);
-    menu->render();
+    {
+        PROFILE_ZONE(Profiler::ZONE_RENDER_MENUS);
+        menu->render();
+    }
 
     // Render combat text on top when game is not paused
     if (!isPaused()) {
         comb->render();
     }
+
+    restorePositions();
+}
+
+/**
+ * Remembers where everything was at the start of this logic frame, for interpolatePositions()
+ */
+void GameStatePlay::saveFramePositions() {
+	mapr->cam.prev_frame_shake = mapr->cam.shake;
+	pc->prev_frame_pos = pc->stats.pos;
+	for (size_t i = 0; i < entitym->entities.size(); ++i) {
+		entitym->entities[i]->prev_frame_pos = entitym->entities[i]->stats.pos;
+	}
+	for (size_t i = 0; i < npcs->npcs.size(); ++i) {
+		npcs->npcs[i]->prev_frame_pos = npcs->npcs[i]->stats.pos;
+	}
+	for (size_t i = 0; i < hazards->h.size(); ++i) {
+		hazards->h[i]->prev_frame_pos = hazards->h[i]->pos;
+	}
+}
+
+/**
+ * NPCs that joined the hero's party are also in the entity list, and must only be interpolated once.
+ * They are marked at the end of each logic frame, so rendering doesn't have to search the entity list.
+ */
+void GameStatePlay::markPartyNPCs() {
+	party_npcs.assign(npcs->npcs.size(), false);
+	for (size_t i = 0; i < npcs->npcs.size(); ++i) {
+		if (npcs->npcs[i]->stats.hero_ally)
+			party_npcs[i] = std::find(entitym->entities.begin(), entitym->entities.end(), npcs->npcs[i]) != entitym->entities.end();
+	}
+}
+
+/**
+ * Party NPCs are moved with the entities. NPCs that appeared since the last logic frame
+ * haven't been marked yet, so they are left where they are.
+ */
+bool GameStatePlay::skipNPCInterpolation(size_t index) {
+	return party_npcs.size() != npcs->npcs.size() || party_npcs[index];
+}
+
+// anything that moved further than this (in tiles) in a single logic frame was teleported, so it isn't interpolated
+static const float MAX_INTERPOLATION_DIST = 2.f;
+
+static void interpolatePosition(FPoint& pos, const FPoint& prev_pos, float interpolation, std::vector<FPoint>& saved_positions) {
+	saved_positions.push_back(pos);
+	if (Utils::calcDist(prev_pos, pos) <= MAX_INTERPOLATION_DIST) {
+		pos.x = prev_pos.x + (pos.x - prev_pos.x) * interpolation;
+		pos.y = prev_pos.y + (pos.y - prev_pos.y) * interpolation;
+	}
+}
+
+/**
+ * When rendering runs faster than the game logic, each frame is drawn part way between the last two logic frames.
+ * Positions are moved temporarily, so that the rendering code doesn't need to know about it.
+ */
+void GameStatePlay::interpolatePositions() {
+	saved_positions.clear();
+	if (render_interpolation >= 1)
+		return;
+
+	interpolatePosition(mapr->cam.shake, mapr->cam.prev_frame_shake, render_interpolation, saved_positions);
+	interpolatePosition(pc->stats.pos, pc->prev_frame_pos, render_interpolation, saved_positions);
+	for (size_t i = 0; i < entitym->entities.size(); ++i) {
+		interpolatePosition(entitym->entities[i]->stats.pos, entitym->entities[i]->prev_frame_pos, render_interpolation, saved_positions);
+	}
+	for (size_t i = 0; i < npcs->npcs.size(); ++i) {
+		if (skipNPCInterpolation(i))
+			continue;
+		interpolatePosition(npcs->npcs[i]->stats.pos, npcs->npcs[i]->prev_frame_pos, render_interpolation, saved_positions);
+	}
+	for (size_t i = 0; i < hazards->h.size(); ++i) {
+		interpolatePosition(hazards->h[i]->pos, hazards->h[i]->prev_frame_pos, render_interpolation, saved_positions);
+	}
+}
+
+/**
+ * Puts back the positions changed by interpolatePositions()
+ */
+void GameStatePlay::restorePositions() {
+	if (saved_positions.empty())
+		return;
+
+	size_t index = 0;
+	mapr->cam.shake = saved_positions[index++];
+	pc->stats.pos = saved_positions[index++];
+	for (size_t i = 0; i < entitym->entities.size(); ++i) {
+		entitym->entities[i]->stats.pos = saved_positions[index++];
+	}
+	for (size_t i = 0; i < npcs->npcs.size(); ++i) {
+		if (skipNPCInterpolation(i))
+			continue;
+		npcs->npcs[i]->stats.pos = saved_positions[index++];
+	}
+	for (size_t i = 0; i < hazards->h.size(); ++i) {
+		hazards->h[i]->pos = saved_positions[index++];
+	}
+	saved_positions.clear();
 }
 
 bool GameStatePlay::isPaused() {
 	return menu->pause;
 }
 
+bool GameStatePlay::isPlaying() {
+	return true;
+}
+
 void GameStatePlay::resetNPC() {
 	npc_id = -1;
 	menu->talker->npc_from_map = true;
@@ -85,6 +85,7 @@ private:
 	void checkSaveEvent();
 	void updateActionBar(unsigned index);
 	void loadTitles();
+	void loadDatabases();
 	void resetNPC();
 	bool checkPrimaryStat(const std::string& first, const std::string& second);
 	void checkCombatState();
@@ -96,9 +97,20 @@ private:
 	void handlePowerReversion();
 	void handlePlayerRespawn();
 	void updateActionBarState();
+	void saveFramePositions();
+	void interpolatePositions();
+	void restorePositions();
+	void markPartyNPCs();
+	bool skipNPCInterpolation(size_t index);
 
 	int npc_id;
 
+	// real positions of everything moved by interpolatePositions()
+	std::vector<FPoint> saved_positions;
+
+	// NPCs that are also in the entity list, see markPartyNPCs()
+	std::vector<bool> party_npcs;
+
 	std::vector<Title> titles;
 
 	Timer second_timer;
@@ -113,6 +125,7 @@ public:
 	void refreshWidgets();
 
 	bool isPaused();
+	bool isPlaying();
 	void logic();
 	void render();
 	void resetGame();
@@ -278,6 +278,14 @@ bool GameSwitcher::isPaused() {
 	return currentState->isPaused();
 }
 
+bool GameSwitcher::isPlaying() {
+	return currentState->isPlaying();
+}
+
+void GameSwitcher::setRenderInterpolation(float interpolation) {
+	currentState->render_interpolation = interpolation;
+}
+
 void GameSwitcher::render() {
 	// display background
 	if (background && currentState->has_background) {
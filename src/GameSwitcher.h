@@ -69,8 +69,10 @@ public:
 	void loadFPS();
 	bool isLoadingFrame();
 	bool isPaused();
+	bool isPlaying();
 	void logic();
 	void render();
+	void setRenderInterpolation(float interpolation);
 	void showFPS(float fps);
 	void saveUserSettings();
 	bool done;
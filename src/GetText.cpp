@@ -18,6 +18,8 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 */
 
 #include "GetText.h"
+#include "ModManager.h"
+#include "SharedResources.h"
 #include "UtilsParsing.h"
 
 GetText::GetText()
@@ -28,13 +30,17 @@ GetText::GetText()
 }
 
 bool GetText::open(const std::string& filename) {
-	infile.open(filename.c_str(), std::ios::in);
-	return infile.is_open();
+	std::string data;
+	if (!mods->readFile(filename, data))
+		return false;
+
+	infile.clear();
+	infile.str(data);
+	return true;
 }
 
 void GetText::close() {
-	if (infile.is_open())
-		infile.close();
+	infile.str("");
 	infile.clear();
 }
 
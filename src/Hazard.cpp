@@ -96,6 +96,7 @@ Hazard& Hazard::operator=(const Hazard& other) {
 	pos = other.pos;
 	speed = other.speed;
 	pos_offset = other.pos_offset;
+	prev_frame_pos = other.prev_frame_pos;
 
 	parent = other.parent;
 	children = other.children;
@@ -82,6 +82,10 @@ public:
 
 	FPoint prev_pos;
 
+	// pos at the start of the last logic frame, used to interpolate rendering between logic frames
+	// unlike prev_pos, this is also updated when the hazard's logic doesn't run
+	FPoint prev_frame_pos;
+
 private:
     void reflect();
 
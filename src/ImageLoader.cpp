@@ -0,0 +1,259 @@
+/*
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+/**
+ * class ImageLoader
+ */
+
+#include "ImageLoader.h"
+#include "ModManager.h"
+#include "RenderDevice.h"
+#include "SharedResources.h"
+
+#include <SDL_image.h>
+#include <string.h>
+
+ImageLoader::ImageLoader()
+	: quit(false)
+	, mutex(SDL_CreateMutex())
+	, cond(SDL_CreateCond())
+{
+	if (!mutex || !cond) {
+		Utils::logError("ImageLoader: Unable to create worker threads, images will load on the main thread. %s", SDL_GetError());
+		return;
+	}
+
+	int thread_count = std::max(std::min(SDL_GetCPUCount() - 1, MAX_THREADS), 1);
+	for (int i = 0; i < thread_count; ++i) {
+		SDL_Thread* thread = SDL_CreateThread(threadFunction, "image_loader", this);
+		if (!thread) {
+			Utils::logError("ImageLoader: Unable to create worker thread. %s", SDL_GetError());
+			break;
+		}
+		threads.push_back(thread);
+	}
+}
+
+ImageLoader::~ImageLoader() {
+	if (mutex) {
+		SDL_LockMutex(mutex);
+		quit = true;
+		SDL_CondBroadcast(cond);
+		SDL_UnlockMutex(mutex);
+	}
+
+	for (size_t i = 0; i < threads.size(); ++i) {
+		SDL_WaitThread(threads[i], NULL);
+	}
+
+	for (std::list<Job>::iterator it = jobs.begin(); it != jobs.end(); ++it) {
+		if (it->surface)
+			SDL_FreeSurface(it->surface);
+		if (it->image)
+			it->image->unref();
+	}
+
+	if (cond) SDL_DestroyCond(cond);
+	if (mutex) SDL_DestroyMutex(mutex);
+}
+
+bool ImageLoader::readImageSize(const std::string& path, Point& size) {
+	static const unsigned char PNG_SIGNATURE[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+
+	SDL_RWops* rw = mods->openRW(path);
+	if (!rw)
+		return false;
+
+	// the IHDR chunk always comes first, with the width and height as big-endian integers
+	unsigned char header[24];
+	size_t header_size = SDL_RWread(rw, header, 1, sizeof(header));
+	SDL_RWclose(rw);
+
+	if (header_size != sizeof(header) || memcmp(header, PNG_SIGNATURE, 8) != 0 || memcmp(header + 12, "IHDR", 4) != 0)
+		return false;
+
+	uint32_t width = (static_cast<uint32_t>(header[16]) << 24) | (static_cast<uint32_t>(header[17]) << 16) | (static_cast<uint32_t>(header[18]) << 8) | header[19];
+	uint32_t height = (static_cast<uint32_t>(header[20]) << 24) | (static_cast<uint32_t>(header[21]) << 16) | (static_cast<uint32_t>(header[22]) << 8) | header[23];
+	if (width == 0 || height == 0 || width > INT16_MAX || height > INT16_MAX)
+		return false;
+
+	size.x = static_cast<int>(width);
+	size.y = static_cast<int>(height);
+	return true;
+}
+
+bool ImageLoader::isRunning() {
+	return !threads.empty();
+}
+
+void ImageLoader::push(const std::string& filename, const std::string& path, Image* image, int error_type) {
+	Job job;
+	job.filename = filename;
+	job.path = path;
+	job.image = image;
+	job.error_type = error_type;
+
+	// held until the pixels are copied in
+	image->ref();
+
+	SDL_LockMutex(mutex);
+	jobs.push_back(job);
+	SDL_CondSignal(cond);
+	SDL_UnlockMutex(mutex);
+}
+
+void ImageLoader::upload() {
+	uint64_t start_ticks = SDL_GetPerformanceCounter();
+	uint64_t budget_ticks = UPLOAD_BUDGET * SDL_GetPerformanceFrequency() / 1000000;
+
+	// only the main thread removes jobs, so the iterator stays valid while the mutex is unlocked
+	SDL_LockMutex(mutex);
+	std::list<Job>::iterator it = jobs.begin();
+	while (it != jobs.end()) {
+		if (it->state != JOB_DECODED) {
+			++it;
+			continue;
+		}
+
+		Job job = *it;
+		it = jobs.erase(it);
+
+		SDL_UnlockMutex(mutex);
+		copyToImage(job);
+		SDL_LockMutex(mutex);
+
+		if (SDL_GetPerformanceCounter() - start_ticks >= budget_ticks)
+			break;
+	}
+	SDL_UnlockMutex(mutex);
+}
+
+void ImageLoader::finish(Image* image) {
+	SDL_LockMutex(mutex);
+
+	std::list<Job>::iterator it = jobs.begin();
+	while (it != jobs.end() && it->image != image)
+		++it;
+
+	if (it == jobs.end()) {
+		SDL_UnlockMutex(mutex);
+		return;
+	}
+
+	// rather than waiting for a worker to get to it, decode it here
+	if (it->state == JOB_QUEUED)
+		decode(it);
+
+	while (it->state == JOB_DECODING)
+		SDL_CondWait(cond, mutex);
+
+	Job job = *it;
+	jobs.erase(it);
+	SDL_UnlockMutex(mutex);
+
+	copyToImage(job);
+}
+
+void ImageLoader::cancel() {
+	SDL_LockMutex(mutex);
+
+	std::list<Job>::iterator it = jobs.begin();
+	while (it != jobs.end()) {
+		if (it->image) {
+			it->image->unref();
+			it->image = NULL;
+		}
+
+		// a worker is still writing to this one, upload() drops it once it is done
+		if (it->state == JOB_DECODING) {
+			++it;
+			continue;
+		}
+
+		if (it->surface)
+			SDL_FreeSurface(it->surface);
+		it = jobs.erase(it);
+	}
+
+	SDL_UnlockMutex(mutex);
+}
+
+int ImageLoader::threadFunction(void* data) {
+	static_cast<ImageLoader*>(data)->workerLoop();
+	return 0;
+}
+
+void ImageLoader::workerLoop() {
+	SDL_LockMutex(mutex);
+	while (!quit) {
+		std::list<Job>::iterator it = jobs.begin();
+		while (it != jobs.end() && it->state != JOB_QUEUED)
+			++it;
+
+		if (it != jobs.end())
+			decode(it);
+		else
+			SDL_CondWait(cond, mutex);
+	}
+	SDL_UnlockMutex(mutex);
+}
+
+/**
+ * Decodes a queued job. The mutex must be locked; it is unlocked while decoding.
+ */
+void ImageLoader::decode(std::list<Job>::iterator job) {
+	job->state = JOB_DECODING;
+	std::string path = job->path;
+	SDL_UnlockMutex(mutex);
+
+	// converting here leaves only the copy for the main thread
+	SDL_Surface* surface = NULL;
+	SDL_Surface* loaded = IMG_Load_RW(mods->openRW(path), 1);
+	if (loaded) {
+		surface = SDL_ConvertSurfaceFormat(loaded, SDL_PIXELFORMAT_ARGB8888, 0);
+		SDL_FreeSurface(loaded);
+	}
+
+	// SDL's error message is per thread, so it is kept for the main thread to log
+	std::string error;
+	if (!surface)
+		error = IMG_GetError();
+
+	SDL_LockMutex(mutex);
+	job->surface = surface;
+	job->error = error;
+	job->state = JOB_DECODED;
+	SDL_CondBroadcast(cond);
+}
+
+void ImageLoader::copyToImage(Job& job) {
+	if (job.image) {
+		if (!job.surface) {
+			if (job.error_type != RenderDevice::ERROR_NONE)
+				Utils::logError("ImageLoader: Couldn't load image: '%s'. %s", job.filename.c_str(), job.error.c_str());
+		}
+		else if (job.surface->w != job.image->getWidth() || job.surface->h != job.image->getHeight()) {
+			Utils::logError("ImageLoader: The size of '%s' doesn't match its header.", job.filename.c_str());
+		}
+		else {
+			job.image->copyFromSurface(job.surface, Rect(0, 0, job.surface->w, job.surface->h));
+		}
+
+		job.image->unref();
+	}
+
+	if (job.surface)
+		SDL_FreeSurface(job.surface);
+}
@@ -0,0 +1,97 @@
+/*
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+/**
+ * class ImageLoader
+ *
+ * Decodes images for RenderDevice::loadImageAsync() on worker threads. The render
+ * device hands out a blank image of the right size right away; the decoded pixels are
+ * copied into it on the main thread by upload(), a few images per frame.
+ */
+
+#ifndef IMAGE_LOADER_H
+#define IMAGE_LOADER_H
+
+#include "CommonIncludes.h"
+#include "Utils.h"
+
+#include <list>
+
+class ImageLoader {
+public:
+	static const int MAX_THREADS = 2;
+
+	// time upload() may spend per frame, in microseconds
+	static const uint64_t UPLOAD_BUDGET = 2000;
+
+	ImageLoader();
+	~ImageLoader();
+
+	// reads the size of a PNG from its header, without decoding it
+	static bool readImageSize(const std::string& path, Point& size);
+
+	// false if no worker thread could be started
+	bool isRunning();
+
+	// decodes path on a worker thread and copies it into image, which must already have its size
+	void push(const std::string& filename, const std::string& path, Image* image, int error_type);
+
+	// copies decoded images into their placeholders until the per-frame budget is used up
+	void upload();
+
+	// if image is still being loaded, finishes loading it before returning
+	void finish(Image* image);
+
+	// drops every image that hasn't been uploaded yet
+	void cancel();
+
+private:
+	enum {
+		JOB_QUEUED = 0,
+		JOB_DECODING = 1,
+		JOB_DECODED = 2
+	};
+
+	class Job {
+	public:
+		Job()
+			: image(NULL)
+			, surface(NULL)
+			, error_type(0)
+			, state(JOB_QUEUED)
+		{}
+		std::string filename;
+		std::string path;
+		Image* image; // NULL once cancelled
+		SDL_Surface* surface;
+		std::string error;
+		int error_type;
+		int state;
+	};
+
+	static int threadFunction(void* data);
+	void workerLoop();
+	void decode(std::list<Job>::iterator job);
+	void copyToImage(Job& job);
+
+	std::list<Job> jobs;
+	std::vector<SDL_Thread*> threads;
+	bool quit;
+
+	SDL_mutex* mutex;
+	SDL_cond* cond;
+};
+
+#endif
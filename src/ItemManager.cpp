@@ -259,7 +259,7 @@ void ItemManager::loadItems(const std::string& filename) {
 	FileParser infile;
 
 	// @CLASS ItemManager: Items|Description of Items in items/items.txt.
-	if (!infile.open(filename, FileParser::MOD_FILE, FileParser::ERROR_NORMAL))
+	if (!infile.open(filename, FileParser::MOD_FILE, FileParser::ERROR_NORMAL, FileParser::USE_CACHE))
 		return;
 
 	// used to clear vectors when overriding items
@@ -417,7 +417,6 @@ void ItemManager::loadItems(const std::string& filename) {
 		else if (infile.key == "soundfx") {
 			// @ATTR soundfx|filename|Sound effect filename to play for the specific item.
 			item->sfx = infile.val;
-			item->sfx_id = snd->load(item->sfx, "ItemManager");
 		}
 		else if (infile.key == "gfx")
 			// @ATTR gfx|filename|Filename of an animation set to display when the item is equipped.
@@ -568,7 +567,7 @@ void ItemManager::loadTypes(const std::string& filename) {
 	FileParser infile;
 
 	// @CLASS ItemManager: Types|Definition of a item types, items/types.txt...
-	if (infile.open(filename, FileParser::MOD_FILE, FileParser::ERROR_NORMAL)) {
+	if (infile.open(filename, FileParser::MOD_FILE, FileParser::ERROR_NORMAL, FileParser::USE_CACHE)) {
 		while (infile.next()) {
 			if (infile.new_section) {
 				if (infile.section == "type") {
@@ -610,7 +609,7 @@ void ItemManager::loadQualities(const std::string& filename) {
 	FileParser infile;
 
 	// @CLASS ItemManager: Qualities|Definition of a item qualities, items/types.txt...
-	if (infile.open(filename, FileParser::MOD_FILE, FileParser::ERROR_NORMAL)) {
+	if (infile.open(filename, FileParser::MOD_FILE, FileParser::ERROR_NORMAL, FileParser::USE_CACHE)) {
 		while (infile.next()) {
 			if (infile.new_section) {
 				if (infile.section == "quality") {
@@ -702,7 +701,7 @@ void ItemManager::loadSets(const std::string& filename) {
 	FileParser infile;
 
 	// @CLASS ItemManager: Sets|Definition of a item sets, items/sets.txt...
-	if (!infile.open(filename, FileParser::MOD_FILE, FileParser::ERROR_NORMAL))
+	if (!infile.open(filename, FileParser::MOD_FILE, FileParser::ERROR_NORMAL, FileParser::USE_CACHE))
 		return;
 
 	bool clear_bonus = true;
@@ -971,6 +970,16 @@ void ItemManager::getBonusString(std::stringstream& ss, BonusData* bdata) {
 	}
 }
 
+/**
+ * Sounds aren't loaded while parsing, so that items can be loaded on a worker thread
+ */
+void ItemManager::loadSounds() {
+	for (size_t i = 1; i < items.size(); ++i) {
+		if (items[i] && !items[i]->sfx.empty() && items[i]->sfx_id == 0)
+			items[i]->sfx_id = snd->load(items[i]->sfx, "ItemManager");
+	}
+}
+
 void ItemManager::playSound(ItemID item, const Point& pos) {
 	if (!isValid(item))
 		return;
@@ -1414,7 +1423,7 @@ ItemRandomizerDef* ItemManager::loadRandomizerDef(const std::string& filename) {
 	FileParser infile;
 
 	// @CLASS ItemManager: Randomizer Definition|Description of item randomizer configuration in items/random/...
-	if (!infile.open(filename, FileParser::MOD_FILE, FileParser::ERROR_NORMAL))
+	if (!infile.open(filename, FileParser::MOD_FILE, FileParser::ERROR_NORMAL, FileParser::USE_CACHE))
 		return NULL;
 
 	randomizer_defs.resize(randomizer_defs.size()+1, new ItemRandomizerDef());
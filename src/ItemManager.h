@@ -324,6 +324,7 @@ public:
 	~ItemManager();
 	bool isValid(ItemID item_id);
 	bool isValidSet(ItemSetID set_id);
+	void loadSounds();
 	void playSound(ItemID item, const Point& pos = Point(0,0));
 	TooltipData getTooltip(ItemStack stack, StatBlock *stats, int context, bool input_hint);
 	TooltipData getShortTooltip(ItemStack item);
@@ -0,0 +1,192 @@
+/*
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+/**
+ * class LayerCompositor
+ */
+
+#include "LayerCompositor.h"
+#include "RenderDevice.h"
+#include "Settings.h"
+#include "SharedResources.h"
+
+bool LayerCompositor::Layer::operator<(const Layer& other) const {
+	if (image != other.image)
+		return image < other.image;
+	if (src.x != other.src.x)
+		return src.x < other.src.x;
+	if (src.y != other.src.y)
+		return src.y < other.src.y;
+	if (src.w != other.src.w)
+		return src.w < other.src.w;
+	if (src.h != other.src.h)
+		return src.h < other.src.h;
+	if (offset.x != other.offset.x)
+		return offset.x < other.offset.x;
+	return offset.y < other.offset.y;
+}
+
+LayerCompositor::LayerCompositor()
+	: use_counter(0)
+	, context_version(0)
+{
+}
+
+/**
+ * Baked frames aren't shared between characters, so copies start out empty
+ */
+LayerCompositor::LayerCompositor(const LayerCompositor&)
+	: use_counter(0)
+	, context_version(0)
+{
+}
+
+LayerCompositor& LayerCompositor::operator=(const LayerCompositor& other) {
+	if (this != &other)
+		clear();
+
+	return *this;
+}
+
+LayerCompositor::~LayerCompositor() {
+	clear();
+}
+
+bool LayerCompositor::isEnabled() {
+	return settings->composite_layers && render_device->supportsPremultipliedAlpha();
+}
+
+bool LayerCompositor::compose(const std::vector<Renderable>& layers, Renderable& result) {
+	// a single layer is already a single draw
+	if (layers.size() < 2)
+		return false;
+
+	if (context_version != render_device->getContextVersion()) {
+		clear();
+		context_version = render_device->getContextVersion();
+	}
+
+	key.clear();
+	for (size_t i = 0; i < layers.size(); ++i) {
+		const Renderable& ren = layers[i];
+		if (!ren.image)
+			continue;
+
+		// these would have to be applied to each layer separately
+		if (ren.blend_mode != Renderable::BLEND_NORMAL || ren.alpha_mod != 255)
+			return false;
+		if (ren.color_mod.r != 255 || ren.color_mod.g != 255 || ren.color_mod.b != 255)
+			return false;
+
+		Layer layer;
+		layer.image = ren.image;
+		layer.src = ren.src;
+		layer.offset = ren.offset;
+		key.push_back(layer);
+	}
+
+	if (key.size() < 2)
+		return false;
+
+	FRAME_CONTAINER_ITER it = frames.find(key);
+	if (it == frames.end()) {
+		Frame frame;
+		frame.image = bake(key, frame.offset);
+		frame.last_used = 0;
+		if (!frame.image)
+			return false;
+
+		if (frames.size() >= MAX_FRAMES)
+			evict();
+
+		// keep the layer images alive, so that their addresses can't be reused by other images
+		for (size_t i = 0; i < key.size(); ++i) {
+			key[i].image->ref();
+		}
+
+		it = frames.insert(std::pair<std::vector<Layer>, Frame>(key, frame)).first;
+	}
+
+	it->second.last_used = ++use_counter;
+
+	result.image = it->second.image;
+	result.src = Rect(0, 0, it->second.image->getWidth(), it->second.image->getHeight());
+	result.offset = it->second.offset;
+	result.blend_mode = Renderable::BLEND_PREMULTIPLIED;
+
+	return true;
+}
+
+/**
+ * Draws the layers onto a new transparent image that covers all of them.
+ * Blending onto transparent black leaves the image with premultiplied alpha.
+ */
+Image* LayerCompositor::bake(const std::vector<Layer>& layers, Point& offset) {
+	offset = layers[0].offset;
+	for (size_t i = 1; i < layers.size(); ++i) {
+		offset.x = std::max(offset.x, layers[i].offset.x);
+		offset.y = std::max(offset.y, layers[i].offset.y);
+	}
+
+	Point size;
+	for (size_t i = 0; i < layers.size(); ++i) {
+		size.x = std::max(size.x, offset.x - layers[i].offset.x + layers[i].src.w);
+		size.y = std::max(size.y, offset.y - layers[i].offset.y + layers[i].src.h);
+	}
+
+	Image* image = render_device->createImage(size.x, size.y);
+	if (!image)
+		return NULL;
+
+	image->fillWithColor(Color(0,0,0,0));
+
+	for (size_t i = 0; i < layers.size(); ++i) {
+		Rect src = layers[i].src;
+		Rect dest(offset.x - layers[i].offset.x, offset.y - layers[i].offset.y, src.w, src.h);
+		render_device->renderToImage(layers[i].image, src, image, dest);
+	}
+
+	return image;
+}
+
+void LayerCompositor::release(FRAME_CONTAINER_ITER it) {
+	const std::vector<Layer>& layers = it->first;
+	for (size_t i = 0; i < layers.size(); ++i) {
+		layers[i].image->unref();
+	}
+	it->second.image->unref();
+	frames.erase(it);
+}
+
+/**
+ * Releases the least recently used frame
+ */
+void LayerCompositor::evict() {
+	FRAME_CONTAINER_ITER oldest = frames.end();
+	for (FRAME_CONTAINER_ITER it = frames.begin(); it != frames.end(); ++it) {
+		if (oldest == frames.end() || it->second.last_used < oldest->second.last_used)
+			oldest = it;
+	}
+
+	if (oldest != frames.end())
+		release(oldest);
+}
+
+void LayerCompositor::clear() {
+	while (!frames.empty()) {
+		release(frames.begin());
+	}
+	use_counter = 0;
+}
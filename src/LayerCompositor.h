@@ -0,0 +1,89 @@
+/*
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+/**
+ * class LayerCompositor
+ *
+ * Bakes the equipment layers of a character (see StatBlock::layer_def) into
+ * a single image per animation frame, so that a fully geared character is
+ * drawn with one Renderable instead of one per layer.
+ * The baked images have premultiplied alpha and are drawn with
+ * Renderable::BLEND_PREMULTIPLIED. Frames are keyed on the exact layer images
+ * being drawn, so changing equipment simply starts using new entries.
+ */
+
+#ifndef LAYER_COMPOSITOR_H
+#define LAYER_COMPOSITOR_H
+
+#include "CommonIncludes.h"
+#include "Utils.h"
+
+class LayerCompositor {
+public:
+	// upper limit of baked frames per character
+	static const size_t MAX_FRAMES = 64;
+
+	LayerCompositor();
+	LayerCompositor(const LayerCompositor& other);
+	LayerCompositor& operator=(const LayerCompositor& other);
+	~LayerCompositor();
+
+	// true if the render device and settings allow baking layers
+	static bool isEnabled();
+
+	/**
+	 * Fills result with a single Renderable showing all layers, in order.
+	 * Only the image, src, offset and blend_mode of the result are set.
+	 * Returns false if the layers can't be baked (blending, color or alpha
+	 * modifiers of their own), in which case they should be drawn as they are.
+	 */
+	bool compose(const std::vector<Renderable>& layers, Renderable& result);
+
+	void clear();
+
+private:
+	class Layer {
+	public:
+		Image* image;
+		Rect src;
+		Point offset;
+
+		bool operator<(const Layer& other) const;
+	};
+
+	class Frame {
+	public:
+		Image* image;
+		Point offset;
+		unsigned last_used;
+	};
+
+	typedef std::map<std::vector<Layer>, Frame> FRAME_CONTAINER;
+	typedef FRAME_CONTAINER::iterator FRAME_CONTAINER_ITER;
+
+	Image* bake(const std::vector<Layer>& layers, Point& offset);
+	void release(FRAME_CONTAINER_ITER it);
+	void evict();
+
+	FRAME_CONTAINER frames;
+
+	// reused for lookups, to avoid allocating a key every frame
+	std::vector<Layer> key;
+
+	unsigned use_counter;
+	unsigned context_version;
+};
+
+#endif // LAYER_COMPOSITOR_H
@@ -59,8 +59,6 @@ LootManager::LootManager()
 	: sfx_loot(snd->load(eset->loot.sfx_loot, "LootManager dropping loot"))
 	, sfx_loot_channel("loot")
 {
-	loadGraphics();
-	loadLootTables();
 }
 
 /**
@@ -671,7 +669,7 @@ void LootManager::loadLootTables() {
 	// @CLASS LootManger|Description of loot tables in loot/
 	for (unsigned i=0; i<filenames.size(); i++) {
 		FileParser infile;
-		if (!infile.open(filenames[i], FileParser::MOD_FILE, FileParser::ERROR_NORMAL))
+		if (!infile.open(filenames[i], FileParser::MOD_FILE, FileParser::ERROR_NORMAL, FileParser::USE_CACHE))
 			continue;
 
 		std::vector<EventComponent> *ec_list = &loot_tables[filenames[i]];
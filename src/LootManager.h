@@ -49,10 +49,8 @@ private:
 	};
 
 	// functions
-	void loadGraphics();
 	void checkEnemiesForLoot();
 	void checkMapForLoot();
-	void loadLootTables();
 	void getLootTable(const std::string &filename, std::vector<EventComponent> *ec_list);
 	void checkLootComponent(EventComponent* ec, FPoint *pos, std::vector<ItemStack> *itemstack_vec);
 
@@ -81,6 +79,10 @@ public:
 	LootManager(const LootManager &copy); // not implemented
 	~LootManager();
 
+	// both need the item database. loadLootTables() only parses, so it may run on a worker thread
+	void loadGraphics();
+	void loadLootTables();
+
 	void handleNewMap();
 	void logic();
 	void renderTooltips(const FPoint& cam);
@@ -26,6 +26,7 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 #include "FileParser.h"
 #include "FogOfWar.h"
 #include "Map.h"
+#include "MapBinary.h"
 #include "MapRenderer.h"
 #include "MessageEngine.h"
 #include "ModManager.h"
@@ -76,7 +77,7 @@ void Map::removeLayer(unsigned index) {
 	layers.erase(layers.begin() + index);
 }
 
-int Map::load(const std::string& fname) {
+int Map::load(const std::string& fname, MapBinary* streamed) {
 	FileParser infile;
 
 	clearEvents();
@@ -95,11 +96,32 @@ int Map::load(const std::string& fname) {
 	hero_pos.x = 0;
 	hero_pos.y = 0;
 
+	// a converted copy of the map skips parsing the layer data, see MapBinary
+	MapBinary binary;
+	MapBinary* source = streamed;
+	std::string binary_fname = MapBinary::getBinaryFilename(fname);
+	if (!source && binary.loadBinary(fname))
+		source = &binary;
+
 	// @CLASS Map|Description of maps/
-	if (!infile.open(fname, FileParser::MOD_FILE, FileParser::ERROR_NORMAL))
-		return 0;
+	if (streamed) {
+		if (!infile.openData(fname, streamed->getSections(), FileParser::ERROR_NORMAL))
+			return 0;
+
+		Utils::logInfo("Map: Loading map '%s', prepared in the background", fname.c_str());
+	}
+	else if (source) {
+		if (!infile.openData(binary_fname, source->getSections(), FileParser::ERROR_NORMAL))
+			return 0;
 
-	Utils::logInfo("Map: Loading map '%s'", fname.c_str());
+		Utils::logInfo("Map: Loading map '%s' from '%s'", fname.c_str(), binary_fname.c_str());
+	}
+	else {
+		if (!infile.open(fname, FileParser::MOD_FILE, FileParser::ERROR_NORMAL))
+			return 0;
+
+		Utils::logInfo("Map: Loading map '%s'", fname.c_str());
+	}
 
 	this->filename = fname;
 
@@ -129,6 +151,16 @@ int Map::load(const std::string& fname) {
 
 	infile.close();
 
+	if (source) {
+		w = source->getWidth();
+		h = source->getHeight();
+		for (size_t i = 0; i < source->getLayerCount(); ++i) {
+			layernames.push_back(source->getLayerName(i));
+			layers.resize(layers.size()+1);
+			source->copyLayer(i, layers.back());
+		}
+	}
+
 	if (fogofwar) fow->load();
 
 	// create StatBlocks for events that need powers
@@ -271,26 +303,15 @@ void Map::loadLayer(FileParser &infile) {
 		// @ATTR layer.data|raw|Raw map layer data
 		// layer map data handled as a special case
 		// The next h lines must contain layer data.
-		for (int j=0; j<h; j++) {
+		for (unsigned short j=0; j<h; j++) {
 			std::string val = infile.getRawLine();
 			infile.incrementLineNum();
-			if (!val.empty() && val[val.length()-1] != ',') {
-				val += ',';
-			}
 
-			// verify the width of this row
-			int comma_count = 0;
-			for (unsigned i=0; i<val.length(); ++i) {
-				if (val[i] == ',') comma_count++;
-			}
-			if (comma_count != w) {
+			if (!parseLayerRow(val, layers.back(), j)) {
 				infile.error("Map: A row of layer data has a width not equal to %d.", w);
 				mods->resetModConfig();
 				Utils::Exit(1);
 			}
-
-			for (int i=0; i<w; i++)
-				layers.back()[i][j] = static_cast<unsigned short>(Parse::popFirstInt(val));
 		}
 	}
 	else {
@@ -298,6 +319,28 @@ void Map::loadLayer(FileParser &infile) {
 	}
 }
 
+bool Map::parseLayerRow(std::string_view row, Map_Layer& layer, unsigned short y) {
+	// the trailing comma is optional
+	size_t comma_count = std::count(row.begin(), row.end(), ',');
+	if (!row.empty() && row.back() != ',')
+		comma_count++;
+
+	if (comma_count != layer.size())
+		return false;
+
+	size_t pos = 0;
+	for (size_t x = 0; x < layer.size(); ++x) {
+		size_t end = row.find(',', pos);
+		if (end == std::string_view::npos)
+			end = row.size();
+
+		layer[x][y] = static_cast<unsigned short>(Parse::toInt(row.substr(pos, end - pos)));
+		pos = end + 1;
+	}
+
+	return true;
+}
+
 void Map::loadEnemyGroup(FileParser &infile, Map_Group *group) {
 	if (infile.key == "type") {
 		// @ATTR enemygroup.type|string|(IGNORED BY ENGINE) The "type" field, as used by Tiled and other mapping tools.
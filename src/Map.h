@@ -26,8 +26,11 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 #include "MapCollision.h"
 #include "Utils.h"
 
+#include <string_view>
+
 class Event;
 class FileParser;
+class MapBinary;
 class StatBlock;
 
 class SpawnLevel {
@@ -165,7 +168,11 @@ public:
 	void setTileset(const std::string& tset) { tileset = tset; }
 	void removeLayer(unsigned index);
 
-	int load(const std::string& filename);
+	// streamed is the map data prepared by MapStreamer, if any
+	int load(const std::string& filename, MapBinary* streamed = NULL);
+
+	// reads one comma-separated row of layer data into row y. Returns false if the width doesn't match
+	static bool parseLayerRow(std::string_view row, Map_Layer& layer, unsigned short y);
 
 	std::string music_filename;
 
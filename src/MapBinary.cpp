@@ -0,0 +1,404 @@
+/*
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+/**
+ * class MapBinary
+ */
+
+#include "FileParser.h"
+#include "Map.h"
+#include "MapBinary.h"
+#include "ModManager.h"
+#include "SharedResources.h"
+#include "Utils.h"
+#include "UtilsFileSystem.h"
+#include "UtilsParsing.h"
+
+#include <limits.h>
+#include <string.h>
+
+static uint32_t readU32(const unsigned char* src) {
+	return static_cast<uint32_t>(src[0]) | (static_cast<uint32_t>(src[1]) << 8) | (static_cast<uint32_t>(src[2]) << 16) | (static_cast<uint32_t>(src[3]) << 24);
+}
+
+static uint64_t readU64(const unsigned char* src) {
+	return static_cast<uint64_t>(readU32(src)) | (static_cast<uint64_t>(readU32(src + 4)) << 32);
+}
+
+static bool readString(const unsigned char*& pos, const unsigned char* end, std::string_view& out) {
+	if (end - pos < 4)
+		return false;
+	uint32_t length = readU32(pos);
+	pos += 4;
+
+	if (length > static_cast<size_t>(end - pos))
+		return false;
+	out = std::string_view(reinterpret_cast<const char*>(pos), length);
+	pos += length;
+	return true;
+}
+
+static void writeU32(std::string& out, uint32_t value) {
+	for (size_t i = 0; i < 4; ++i) {
+		out.push_back(static_cast<char>(value >> (i * 8)));
+	}
+}
+
+static void writeU64(std::string& out, uint64_t value) {
+	writeU32(out, static_cast<uint32_t>(value));
+	writeU32(out, static_cast<uint32_t>(value >> 32));
+}
+
+static void writeString(std::string& out, const std::string& value) {
+	writeU32(out, static_cast<uint32_t>(value.length()));
+	out += value;
+}
+
+MapBinary::MapBinary()
+	: width(0)
+	, height(0)
+{
+}
+
+MapBinary::~MapBinary() {
+}
+
+std::string MapBinary::getBinaryFilename(const std::string& filename) {
+	if (filename.length() > 4 && filename.compare(filename.length() - 4, 4, ".txt") == 0)
+		return filename.substr(0, filename.length() - 4) + ".map";
+	return filename + ".map";
+}
+
+void MapBinary::convertMods() {
+	std::vector<std::string> map_files = mods->list("maps", !ModManager::LIST_FULL_PATHS);
+
+	unsigned converted = 0;
+	for (size_t i = 0; i < map_files.size(); ++i) {
+		std::string text_path = mods->locate(map_files[i]);
+
+		// files in a mod pack can't be written next to, pack the converted maps instead
+		if (!Filesystem::fileExists(text_path)) {
+			Utils::logInfo("MapBinary: Skipping '%s', which is inside a mod pack.", map_files[i].c_str());
+			continue;
+		}
+
+		if (convert(map_files[i], getBinaryFilename(text_path)))
+			converted++;
+	}
+
+	Utils::logInfo("MapBinary: Converted %u of %u maps.", converted, static_cast<unsigned>(map_files.size()));
+}
+
+bool MapBinary::convert(const std::string& filename, const std::string& binary_path) {
+	std::string out;
+	if (!build(filename, out))
+		return false;
+
+	std::ofstream outfile(binary_path.c_str(), std::ios::out | std::ios::binary);
+	if (!outfile.is_open()) {
+		Utils::logError("MapBinary: Could not open '%s' for writing.", binary_path.c_str());
+		return false;
+	}
+
+	outfile.write(out.data(), static_cast<std::streamsize>(out.size()));
+	outfile.close();
+
+	if (outfile.fail()) {
+		Utils::logError("MapBinary: Unable to write '%s'. No write access or disk is full!", binary_path.c_str());
+		Filesystem::removeFile(binary_path);
+		return false;
+	}
+
+	Utils::logInfo("MapBinary: Wrote '%s'.", binary_path.c_str());
+	return true;
+}
+
+bool MapBinary::build(const std::string& filename, std::string& out) {
+	FileParser infile;
+	if (!infile.open(filename, FileParser::MOD_FILE, FileParser::ERROR_NORMAL))
+		return false;
+
+	unsigned short map_w = 1;
+	unsigned short map_h = 1;
+
+	std::string section_text;
+	std::vector<std::string> layer_names;
+	std::vector<Map_Layer> layer_data;
+
+	while (infile.next()) {
+		if (infile.section == "layer") {
+			if (infile.key == "type") {
+				layer_names.push_back(infile.val);
+				layer_data.resize(layer_data.size()+1);
+				layer_data.back().resize(map_w);
+				for (size_t i = 0; i < layer_data.back().size(); ++i) {
+					layer_data.back()[i].resize(map_h);
+				}
+			}
+			else if (infile.key == "format") {
+				if (infile.val != "dec") {
+					infile.error("MapBinary: The format of a layer must be 'dec'!");
+					return false;
+				}
+			}
+			else if (infile.key == "data" && !layer_data.empty()) {
+				for (unsigned short j = 0; j < map_h; ++j) {
+					std::string row = infile.getRawLine();
+					infile.incrementLineNum();
+
+					if (!Map::parseLayerRow(row, layer_data.back(), j)) {
+						infile.error("MapBinary: A row of layer data has a width not equal to %d.", map_w);
+						return false;
+					}
+				}
+			}
+			continue;
+		}
+
+		if (infile.section == "header") {
+			if (infile.key == "width")
+				map_w = static_cast<unsigned short>(std::max(Parse::toInt(infile.val), 1));
+			else if (infile.key == "height")
+				map_h = static_cast<unsigned short>(std::max(Parse::toInt(infile.val), 1));
+		}
+
+		if (infile.new_section || section_text.empty())
+			section_text += "\n[" + infile.section + "]\n";
+		section_text += infile.key + "=" + infile.val + "\n";
+	}
+
+	// the map itself (with the files APPENDed to it), then everything it INCLUDEd
+	std::vector<std::string> requested_filenames;
+	requested_filenames.push_back(filename);
+	requested_filenames.insert(requested_filenames.end(), infile.getIncludes().begin(), infile.getIncludes().end());
+	infile.close();
+
+	std::string source_text;
+	writeU32(source_text, static_cast<uint32_t>(requested_filenames.size()));
+	for (size_t i = 0; i < requested_filenames.size(); ++i) {
+		std::vector<std::string> paths = mods->list(Filesystem::convertSlashes(requested_filenames[i]), ModManager::LIST_FULL_PATHS);
+
+		writeString(source_text, requested_filenames[i]);
+		writeU32(source_text, static_cast<uint32_t>(paths.size()));
+		for (size_t j = 0; j < paths.size(); ++j) {
+			// a file without a stamp is written as 0, which makes the copy out of date rather than failing the conversion
+			uint64_t size = 0;
+			int64_t mtime = 0;
+			mods->getFileStamp(paths[j], size, mtime);
+
+			writeString(source_text, paths[j]);
+			writeU64(source_text, size);
+			writeU64(source_text, static_cast<uint64_t>(mtime));
+		}
+	}
+
+	out.assign(MAGIC, 8);
+	writeU32(out, VERSION);
+	writeU32(out, map_w);
+	writeU32(out, map_h);
+	writeU32(out, static_cast<uint32_t>(layer_names.size()));
+	writeU32(out, static_cast<uint32_t>(source_text.length()));
+	writeU32(out, static_cast<uint32_t>(section_text.length()));
+	out += source_text;
+	out += section_text;
+
+	for (size_t i = 0; i < layer_names.size(); ++i) {
+		writeU32(out, static_cast<uint32_t>(layer_names[i].length()));
+		out += layer_names[i];
+
+		for (unsigned short x = 0; x < map_w; ++x) {
+			for (unsigned short y = 0; y < map_h; ++y) {
+				out.push_back(static_cast<char>(layer_data[i][x][y] & 0xff));
+				out.push_back(static_cast<char>(layer_data[i][x][y] >> 8));
+			}
+		}
+	}
+
+	return true;
+}
+
+bool MapBinary::load(const std::string& path) {
+	// maps in a mod pack are already mapped by the pack, so they are copied out of it instead
+	if (file.open(path)) {
+		if (parse(file.getData(), file.getSize()))
+			return true;
+	}
+	else if (mods->readFile(path, buffer)) {
+		if (parse(reinterpret_cast<const unsigned char*>(buffer.data()), buffer.size()))
+			return true;
+	}
+
+	Utils::logError("MapBinary: '%s' is not a valid binary map, using the text map instead.", path.c_str());
+	return false;
+}
+
+bool MapBinary::loadText(const std::string& filename) {
+	if (!build(filename, buffer))
+		return false;
+
+	return parse(reinterpret_cast<const unsigned char*>(buffer.data()), buffer.size());
+}
+
+bool MapBinary::loadBinary(const std::string& filename) {
+	std::string binary_path = mods->locate(getBinaryFilename(filename));
+	if (binary_path.empty() || !load(binary_path))
+		return false;
+
+	if (!isUpToDate()) {
+		Utils::logInfo("MapBinary: '%s' is out of date, using the text map instead.", binary_path.c_str());
+		file.close();
+		buffer.clear();
+		return false;
+	}
+
+	return true;
+}
+
+bool MapBinary::isUpToDate() const {
+	const unsigned char* pos = reinterpret_cast<const unsigned char*>(sources.data());
+	const unsigned char* end = pos + sources.size();
+
+	if (end - pos < 4)
+		return false;
+	uint32_t source_count = readU32(pos);
+	pos += 4;
+
+	for (uint32_t i = 0; i < source_count; ++i) {
+		std::string_view requested_filename;
+		if (!readString(pos, end, requested_filename) || end - pos < 4)
+			return false;
+		uint32_t file_count = readU32(pos);
+		pos += 4;
+
+		// a mod that was added, removed or reordered changes which files are read
+		std::vector<std::string> paths = mods->list(Filesystem::convertSlashes(std::string(requested_filename)), ModManager::LIST_FULL_PATHS);
+		if (file_count != paths.size())
+			return false;
+
+		for (uint32_t j = 0; j < file_count; ++j) {
+			std::string_view path;
+			if (!readString(pos, end, path) || end - pos < 16 || path != paths[j])
+				return false;
+			uint64_t size = readU64(pos);
+			int64_t mtime = static_cast<int64_t>(readU64(pos + 8));
+			pos += 16;
+
+			uint64_t current_size = 0;
+			int64_t current_mtime = 0;
+			if (!mods->getFileStamp(paths[j], current_size, current_mtime) || size != current_size || mtime != current_mtime)
+				return false;
+		}
+	}
+
+	return true;
+}
+
+bool MapBinary::prepare(const std::string& filename) {
+	if (loadBinary(filename))
+		return true;
+
+	return loadText(filename);
+}
+
+bool MapBinary::parse(const unsigned char* data, size_t size) {
+	if (size < HEADER_SIZE || memcmp(data, MAGIC, 8) != 0 || readU32(data + 8) != VERSION)
+		return false;
+
+	uint32_t map_w = readU32(data + 12);
+	uint32_t map_h = readU32(data + 16);
+	uint32_t layer_count = readU32(data + 20);
+	uint32_t sources_size = readU32(data + 24);
+	uint32_t sections_size = readU32(data + 28);
+	if (map_w == 0 || map_h == 0 || map_w > USHRT_MAX || map_h > USHRT_MAX)
+		return false;
+
+	const unsigned char* pos = data + HEADER_SIZE;
+	const unsigned char* end = data + size;
+
+	if (sources_size > static_cast<size_t>(end - pos))
+		return false;
+	sources = std::string_view(reinterpret_cast<const char*>(pos), sources_size);
+	pos += sources_size;
+
+	if (sections_size > static_cast<size_t>(end - pos))
+		return false;
+	sections = std::string_view(reinterpret_cast<const char*>(pos), sections_size);
+	pos += sections_size;
+
+	size_t tiles_size = static_cast<size_t>(map_w) * map_h * 2;
+
+	layers.clear();
+	for (uint32_t i = 0; i < layer_count; ++i) {
+		if (static_cast<size_t>(end - pos) < 4)
+			return false;
+		uint32_t name_length = readU32(pos);
+		pos += 4;
+
+		if (name_length > static_cast<size_t>(end - pos))
+			return false;
+		Layer layer;
+		layer.name.assign(reinterpret_cast<const char*>(pos), name_length);
+		pos += name_length;
+
+		if (tiles_size > static_cast<size_t>(end - pos))
+			return false;
+		layer.tiles = pos;
+		pos += tiles_size;
+
+		layers.push_back(layer);
+	}
+
+	width = static_cast<unsigned short>(map_w);
+	height = static_cast<unsigned short>(map_h);
+	return true;
+}
+
+std::string_view MapBinary::getSections() const {
+	return sections;
+}
+
+unsigned short MapBinary::getWidth() const {
+	return width;
+}
+
+unsigned short MapBinary::getHeight() const {
+	return height;
+}
+
+size_t MapBinary::getLayerCount() const {
+	return layers.size();
+}
+
+const std::string& MapBinary::getLayerName(size_t index) const {
+	return layers[index].name;
+}
+
+void MapBinary::copyLayer(size_t index, Map_Layer& layer) const {
+	const unsigned char* src = layers[index].tiles;
+	size_t column_size = static_cast<size_t>(height) * 2;
+
+	layer.resize(width);
+	for (unsigned short x = 0; x < width; ++x) {
+		layer[x].resize(height);
+#if SDL_BYTEORDER == SDL_BIG_ENDIAN
+		for (unsigned short y = 0; y < height; ++y) {
+			layer[x][y] = static_cast<unsigned short>(src[y * 2] | (src[y * 2 + 1] << 8));
+		}
+#else
+		memcpy(&layer[x][0], src, column_size);
+#endif
+		src += column_size;
+	}
+}
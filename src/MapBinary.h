@@ -0,0 +1,105 @@
+/*
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+/**
+ * class MapBinary
+ *
+ * A converted copy of a text map (maps/<name>.map next to maps/<name>.txt) that can
+ * be loaded without parsing the layer data. Text maps remain the authoring format;
+ * the copies are written by running the engine with --convert-maps.
+ *
+ * Since INCLUDE and APPEND are resolved when converting, a copy records every file it
+ * was made from, like FileParserCache does. It is only used while the same files would
+ * be read for the map and none of them has changed.
+ *
+ * Layout, with all integers stored little-endian:
+ *   header:   "FLAREMAP", u32 version, u32 width, u32 height, u32 layer count, u32 sources size, u32 sections size
+ *   sources:  u32 source count, per source: requested filename, u32 file count, per file: path, u64 size, i64 mtime
+ *             (strings are stored as u32 length, then the characters)
+ *   sections: every section except [layer] (header, tilesets, enemies, NPCs, events) as
+ *             key=value text, with INCLUDE and APPEND already resolved
+ *   layers:   per layer u32 name length, name, then width * height u16 tiles, column by column
+ */
+
+#ifndef MAP_BINARY_H
+#define MAP_BINARY_H
+
+#include "CommonIncludes.h"
+#include "MapCollision.h"
+#include "MappedFile.h"
+
+#include <stdint.h>
+#include <string_view>
+
+class MapBinary {
+public:
+	static constexpr char MAGIC[9] = "FLAREMAP";
+	static const uint32_t VERSION = 2;
+	static const size_t HEADER_SIZE = 32;
+
+	MapBinary();
+	~MapBinary();
+
+	static std::string getBinaryFilename(const std::string& filename);
+
+	// writes binary copies of the maps in all enabled mods that aren't inside a mod pack
+	static void convertMods();
+	static bool convert(const std::string& filename, const std::string& binary_path);
+
+	// converts a text map in memory, without writing it
+	static bool build(const std::string& filename, std::string& out);
+
+	bool load(const std::string& path);
+	bool loadText(const std::string& filename);
+
+	// loads the binary copy of a text map, if there is one and it is up to date
+	bool loadBinary(const std::string& filename);
+
+	// true if the files the map was converted from are still the ones that would be read, unchanged
+	bool isUpToDate() const;
+
+	// loads the binary copy of a map if it is up to date, otherwise converts the text map in memory
+	bool prepare(const std::string& filename);
+
+	std::string_view getSections() const;
+	unsigned short getWidth() const;
+	unsigned short getHeight() const;
+	size_t getLayerCount() const;
+	const std::string& getLayerName(size_t index) const;
+	void copyLayer(size_t index, Map_Layer& layer) const;
+
+private:
+	class Layer {
+	public:
+		Layer()
+			: tiles(NULL)
+		{}
+		std::string name;
+		const unsigned char* tiles;
+	};
+
+	bool parse(const unsigned char* data, size_t size);
+
+	MappedFile file;
+	std::string buffer;
+
+	std::string_view sources;
+	std::string_view sections;
+	unsigned short width;
+	unsigned short height;
+	std::vector<Layer> layers;
+};
+
+#endif
@@ -34,6 +34,7 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 #include "AStarNode.h"
 #include "EngineSettings.h"
 #include "MapCollision.h"
+#include "Profiler.h"
 #include "SharedResources.h"
 
 #include <cfloat>
@@ -382,6 +383,7 @@ bool MapCollision::isFacing(const float& x1, const float& y1, char direction, co
 * @return true if a path is found
 */
 bool MapCollision::computePath(const FPoint& start_pos, const FPoint& end_pos, std::vector<FPoint> &path, int movement_type, unsigned int limit) {
+	Profiler::addCount(Profiler::COUNTER_PATH_QUERIES);
 
 	if (isOutsideMap(end_pos.x, end_pos.y)) return false;
 
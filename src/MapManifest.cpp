@@ -0,0 +1,242 @@
+/*
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+/**
+ * class MapManifest
+ */
+
+#include "FileParser.h"
+#include "MapBinary.h"
+#include "MapManifest.h"
+#include "ModManager.h"
+#include "SharedResources.h"
+#include "Utils.h"
+#include "UtilsFileSystem.h"
+#include "UtilsParsing.h"
+
+std::string MapManifest::getManifestFilename(const std::string& filename) {
+	if (filename.length() > 4 && filename.compare(filename.length() - 4, 4, ".txt") == 0)
+		return filename.substr(0, filename.length() - 4) + ".deps";
+	return filename + ".deps";
+}
+
+void MapManifest::writeMods() {
+	CategoryMap categories;
+	loadCategories(categories);
+
+	std::vector<std::string> map_files = mods->list("maps", !ModManager::LIST_FULL_PATHS);
+
+	unsigned written = 0;
+	for (size_t i = 0; i < map_files.size(); ++i) {
+		std::string text_path = mods->locate(map_files[i]);
+
+		if (!Filesystem::fileExists(text_path)) {
+			Utils::logInfo("MapManifest: Skipping '%s', which is inside a mod pack.", map_files[i].c_str());
+			continue;
+		}
+
+		if (write(map_files[i], getManifestFilename(text_path), categories))
+			written++;
+	}
+
+	Utils::logInfo("MapManifest: Wrote manifests for %u of %u maps.", written, static_cast<unsigned>(map_files.size()));
+}
+
+void MapManifest::read(const std::string& filename, std::vector<std::string>& images) {
+	FileParser infile;
+	if (!infile.open(getManifestFilename(filename), FileParser::MOD_FILE, FileParser::ERROR_NONE))
+		return;
+
+	while (infile.next()) {
+		if (infile.key == "image")
+			images.push_back(infile.val);
+	}
+	infile.close();
+}
+
+/**
+ * The same table EnemyGroupManager builds, which isn't available outside of the game
+ */
+void MapManifest::loadCategories(CategoryMap& categories) {
+	std::vector<std::string> enemy_files = mods->list("enemies", !ModManager::LIST_FULL_PATHS);
+
+	for (size_t i = 0; i < enemy_files.size(); ++i) {
+		FileParser infile;
+		if (!infile.open(enemy_files[i], FileParser::MOD_FILE, FileParser::ERROR_NORMAL))
+			continue;
+
+		Enemy enemy;
+		enemy.filename = enemy_files[i];
+		std::string category_str;
+
+		while (infile.next()) {
+			if (infile.key == "level")
+				enemy.level = Parse::toInt(infile.val);
+			else if (infile.key == "categories")
+				category_str = infile.val;
+		}
+		infile.close();
+
+		std::string cat;
+		while ((cat = Parse::popFirstString(category_str)) != "") {
+			categories[cat].push_back(enemy);
+		}
+	}
+}
+
+bool MapManifest::write(const std::string& filename, const std::string& path, const CategoryMap& categories) {
+	MapBinary map;
+	if (!map.loadText(filename))
+		return false;
+
+	std::string parallax_filename;
+	std::vector<std::string> enemy_animations;
+	std::vector<std::string> npc_animations;
+
+	std::string category;
+	Point level;
+
+	FileParser infile;
+	if (!infile.openData(filename, map.getSections(), FileParser::ERROR_NORMAL))
+		return false;
+
+	while (infile.next()) {
+		// an enemy group's category and level can come in any order, so it is added when it ends
+		if (infile.new_section) {
+			if (!category.empty())
+				addCategory(categories, category, level.x, level.y, enemy_animations);
+			category.clear();
+			level = Point();
+		}
+
+		if (infile.section == "header") {
+			if (infile.key == "parallax_layers")
+				parallax_filename = infile.val;
+		}
+		else if (infile.section == "enemy") {
+			if (infile.key == "category") {
+				category = infile.val;
+			}
+			else if (infile.key == "level") {
+				level.x = std::max(0, Parse::popFirstInt(infile.val));
+				level.y = std::max(std::max(0, Parse::toInt(Parse::popFirstString(infile.val))), level.x);
+			}
+		}
+		else if (infile.section == "npc") {
+			if (infile.key == "filename")
+				addAnimations(infile.val, npc_animations);
+		}
+		else if (infile.section == "event") {
+			if (infile.key == "spawn") {
+				std::string spawn_category;
+				while ((spawn_category = Parse::popFirstString(infile.val)) != "") {
+					addCategory(categories, spawn_category, 0, 0, enemy_animations);
+					Parse::popFirstInt(infile.val);
+					Parse::popFirstInt(infile.val);
+				}
+			}
+		}
+	}
+	infile.close();
+
+	if (!category.empty())
+		addCategory(categories, category, level.x, level.y, enemy_animations);
+
+	std::vector<std::string> images;
+
+	if (!parallax_filename.empty() && infile.open(parallax_filename, FileParser::MOD_FILE, FileParser::ERROR_NORMAL)) {
+		while (infile.next()) {
+			if (infile.key == "image")
+				addUnique(images, infile.val);
+		}
+		infile.close();
+	}
+
+	for (size_t i = 0; i < enemy_animations.size(); ++i) {
+		addImages(enemy_animations[i], images);
+	}
+	for (size_t i = 0; i < npc_animations.size(); ++i) {
+		addImages(npc_animations[i], images);
+	}
+
+	std::ofstream outfile(path.c_str(), std::ios::out);
+	if (!outfile.is_open()) {
+		Utils::logError("MapManifest: Could not open '%s' for writing.", path.c_str());
+		return false;
+	}
+
+	outfile << "# Images used by " << filename << ", written by --map-manifests" << std::endl;
+	for (size_t i = 0; i < images.size(); ++i) {
+		outfile << "image=" << images[i] << std::endl;
+	}
+	outfile.close();
+
+	if (outfile.fail()) {
+		Utils::logError("MapManifest: Unable to write '%s'. No write access or disk is full!", path.c_str());
+		Filesystem::removeFile(path);
+		return false;
+	}
+
+	Utils::logInfo("MapManifest: Wrote '%s' (%u images).", path.c_str(), static_cast<unsigned>(images.size()));
+	return true;
+}
+
+/**
+ * Adds the animations of the enemies that EnemyGroupManager::getRandomEnemy() can pick
+ */
+void MapManifest::addCategory(const CategoryMap& categories, const std::string& category, int level_min, int level_max, std::vector<std::string>& animations) {
+	CategoryMap::const_iterator it = categories.find(category);
+	if (it == categories.end())
+		return;
+
+	for (size_t i = 0; i < it->second.size(); ++i) {
+		const Enemy& enemy = it->second[i];
+		if ((enemy.level >= level_min && enemy.level <= level_max) || (level_min == 0 && level_max == 0))
+			addAnimations(enemy.filename, animations);
+	}
+}
+
+/**
+ * Adds the animation set of an enemy or NPC definition
+ */
+void MapManifest::addAnimations(const std::string& filename, std::vector<std::string>& animations) {
+	FileParser infile;
+	if (!infile.open(filename, FileParser::MOD_FILE, FileParser::ERROR_NORMAL))
+		return;
+
+	while (infile.next()) {
+		// "gfx" is the deprecated name used by NPCs
+		if (infile.key == "animations" || infile.key == "gfx")
+			addUnique(animations, infile.val);
+	}
+	infile.close();
+}
+
+void MapManifest::addImages(const std::string& animation, std::vector<std::string>& images) {
+	FileParser infile;
+	if (!infile.open(animation, FileParser::MOD_FILE, FileParser::ERROR_NORMAL))
+		return;
+
+	while (infile.next()) {
+		if (infile.section.empty() && infile.key == "image")
+			addUnique(images, Parse::popFirstString(infile.val));
+	}
+	infile.close();
+}
+
+void MapManifest::addUnique(std::vector<std::string>& list, const std::string& value) {
+	if (!value.empty() && std::find(list.begin(), list.end(), value) == list.end())
+		list.push_back(value);
+}
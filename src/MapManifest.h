@@ -0,0 +1,64 @@
+/*
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+/**
+ * class MapManifest
+ *
+ * Lists the images a map needs besides its tileset (maps/<name>.deps next to
+ * maps/<name>.txt), so MapStreamer can decode them all at once instead of waiting for
+ * the enemies and NPCs to load them one by one. The manifests are written by running
+ * the engine with --map-manifests. They are only a hint: a missing or outdated
+ * manifest makes loading slower, not wrong.
+ *
+ * The images are listed in the order they should be decoded: parallax layers, then
+ * the animations of the enemies that can spawn on the map, then those of its NPCs.
+ */
+
+#ifndef MAP_MANIFEST_H
+#define MAP_MANIFEST_H
+
+#include "CommonIncludes.h"
+
+class MapManifest {
+public:
+	static std::string getManifestFilename(const std::string& filename);
+
+	// writes manifests for the maps in all enabled mods that aren't inside a mod pack
+	static void writeMods();
+
+	// reads the images listed in the manifest of a map, if it has one
+	static void read(const std::string& filename, std::vector<std::string>& images);
+
+private:
+	class Enemy {
+	public:
+		Enemy()
+			: level(0)
+		{}
+		std::string filename;
+		int level;
+	};
+
+	typedef std::map<std::string, std::vector<Enemy> > CategoryMap;
+
+	static void loadCategories(CategoryMap& categories);
+	static bool write(const std::string& filename, const std::string& path, const CategoryMap& categories);
+	static void addCategory(const CategoryMap& categories, const std::string& category, int level_min, int level_max, std::vector<std::string>& animations);
+	static void addAnimations(const std::string& filename, std::vector<std::string>& animations);
+	static void addImages(const std::string& animation, std::vector<std::string>& images);
+	static void addUnique(std::vector<std::string>& list, const std::string& value);
+};
+
+#endif
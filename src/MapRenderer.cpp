@@ -42,6 +42,7 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 #include "NPC.h"
 #include "NPCManager.h"
 #include "PowerManager.h"
+#include "Profiler.h"
 #include "RenderDevice.h"
 #include "Settings.h"
 #include "SharedGameResources.h"
@@ -52,6 +53,7 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 #include "Utils.h"
 #include "UtilsFileSystem.h"
 #include "UtilsMath.h"
+#include "WidgetLabel.h"
 #include "WidgetTooltip.h"
 #include "CombatManager.h"
 
@@ -68,8 +70,13 @@ MapRenderer::MapRenderer()
 	, show_tooltip(false)
 	, entity_hidden_normal(NULL)
 	, entity_hidden_enemy(NULL)
+	, drawn_tiles_stamp(0)
+	, fow_covered_reach(0)
+	, perf_update()
+	, show_perf_hud(false)
 	, cam()
 	, map_change(false)
+	, map_change_area()
 	, teleportation(false)
 	, teleport_destination()
 	, respawn_point()
@@ -84,6 +91,8 @@ MapRenderer::MapRenderer()
 	, index_objectlayer(0)
 	, is_spawn_map(false)
 {
+	perf_update.setDuration(settings->max_frames_per_sec / 4);
+
 	// Load entity markers
 	Image *gfx = render_device->loadImage("images/menus/entity_hidden.png", RenderDevice::ERROR_NORMAL);
 	if (gfx) {
@@ -206,7 +215,13 @@ int MapRenderer::load(const std::string& fname) {
 	show_tooltip = false;
 	is_spawn_map = (fname == "maps/spawn.txt");
 
-	Map::load(fname);
+	// maps that weren't prepared ahead of time still have their images decoded in parallel
+	MapBinary* streamed = streamer.take(fname);
+	if (!streamed) {
+		streamer.request(fname, tileset);
+		streamed = streamer.take(fname);
+	}
+	Map::load(fname, streamed);
 
 	loadMusic();
 
@@ -274,6 +289,17 @@ int MapRenderer::load(const std::string& fname) {
 		}
 	}
 
+	fow_covered.clear();
+	fow_covered_reach = 0;
+	if (fogofwar == FogOfWar::TYPE_OVERLAY) {
+		// the reach has to be known before any update, since it sets the range of every later one
+		calcFogOfWarCoveredReach(tset);
+		calcFogOfWarCoveredReach(fow->tset_fog);
+
+		fow_covered.resize(static_cast<size_t>(w) * static_cast<size_t>(h), 0);
+		updateFogOfWarCoverage(0, 0, w-1, h-1);
+	}
+
 	setMapParallax(parallax_filename);
 
 	render_device->setBackgroundColor(background_color);
@@ -298,6 +324,8 @@ void MapRenderer::logic(bool paused) {
 		fow->logic();
 	}
 
+	streamNearbyMaps();
+
 	// handle tile set logic e.g. animations
 	tset.logic();
 	if (fogofwar == FogOfWar::TYPE_OVERLAY) {
@@ -369,21 +397,28 @@ void calculatePriosOrtho(std::vector<Renderable> &r) {
 }
 
 void MapRenderer::render(std::vector<Renderable> &r, std::vector<Renderable> &r_dead) {
+	Profiler::addCount(Profiler::COUNTER_RENDERABLES, static_cast<unsigned>(r.size() + r_dead.size()));
 
 	map_parallax.render(cam.shake, "");
 
 	if (eset->tileset.orientation == eset->tileset.TILESET_ORTHOGONAL) {
-		calculatePriosOrtho(r);
-		calculatePriosOrtho(r_dead);
-		std::sort(r.begin(), r.end(), priocompare);
-		std::sort(r_dead.begin(), r_dead.end(), priocompare);
+		{
+			PROFILE_ZONE(Profiler::ZONE_MAP_SORT);
+			calculatePriosOrtho(r);
+			calculatePriosOrtho(r_dead);
+			std::sort(r.begin(), r.end(), priocompare);
+			std::sort(r_dead.begin(), r_dead.end(), priocompare);
+		}
 		renderOrtho(r, r_dead);
 	}
 	else {
-		calculatePriosIso(r);
-		calculatePriosIso(r_dead);
-		std::sort(r.begin(), r.end(), priocompare);
-		std::sort(r_dead.begin(), r_dead.end(), priocompare);
+		{
+			PROFILE_ZONE(Profiler::ZONE_MAP_SORT);
+			calculatePriosIso(r);
+			calculatePriosIso(r_dead);
+			std::sort(r.begin(), r.end(), priocompare);
+			std::sort(r_dead.begin(), r_dead.end(), priocompare);
+		}
 		renderIso(r, r_dead);
 	}
 
@@ -449,7 +484,10 @@ void MapRenderer::drawRenderable(std::vector<Renderable>::iterator r_cursor) {
 	}
 }
 
-void MapRenderer::renderIsoLayer(const Map_Layer& layerdata, const TileSet& tile_set) {
+void MapRenderer::renderIsoLayer(const unsigned layer_id, const TileSet& tile_set) {
+	PROFILE_ZONE(Profiler::ZONE_MAP_LAYERS);
+
+	const Map_Layer& layerdata = layers[layer_id];
 	int_fast16_t i; // first index of the map array
 	int_fast16_t j; // second index of the map array
 	Point dest;
@@ -499,49 +537,8 @@ void MapRenderer::renderIsoLayer(const Map_Layer& layerdata, const TileSet& tile
 					dest.y = p.y - tile.offset.y;
 
 					//skip rendering tiles that are underneath fow hidden tiles
-					if (fogofwar == FogOfWar::TYPE_OVERLAY) {
-						if (&layerdata != &layers[fow->dark_layer_id]) {
-							if (layers[fow->dark_layer_id][i][j] == FogOfWar::TILE_HIDDEN) {
-
-								//check tile's corners
-								Point t_l(Utils::screenToMap(dest.x, dest.y, cam.shake.x, cam.shake.y));
-								Point t_r(Utils::screenToMap(dest.x + tile.tile->getClip().w, dest.y, cam.shake.x, cam.shake.y));
-								Point b_l(Utils::screenToMap(dest.x, dest.y + tile.tile->getClip().h, cam.shake.x, cam.shake.y));
-								Point b_r(Utils::screenToMap(dest.x + tile.tile->getClip().w, dest.y + tile.tile->getClip().h, cam.shake.x, cam.shake.y));
-
-								//limit to map bounds
-								if (t_l.x < 0) t_l.x = 0;
-								if (t_l.x >= w) t_l.x = w-1;
-								if (t_l.y < 0) t_l.y = 0;
-								if (t_l.y >= h) t_l.y = h-1;
-
-								if (t_r.x < 0) t_r.x = 0;
-								if (t_r.x >= w) t_r.x = w-1;
-								if (t_r.y < 0) t_r.y = 0;
-								if (t_r.y >= h) t_r.y = h-1;
-
-								if (b_l.x < 0) b_l.x = 0;
-								if (b_l.x >= w) b_l.x = w-1;
-								if (b_l.y < 0) b_l.y = 0;
-								if (b_l.y >= h) b_l.y = h-1;
-
-								if (b_r.x < 0) b_r.x = 0;
-								if (b_r.x >= w) b_r.x = w-1;
-								if (b_r.y < 0) b_r.y = 0;
-								if (b_r.y >= h) b_r.y = h-1;
-
-								if (layers[fow->dark_layer_id][t_l.x][t_l.y] == FogOfWar::TILE_HIDDEN) {
-									if (layers[fow->dark_layer_id][t_r.x][t_r.y] == FogOfWar::TILE_HIDDEN) {
-										if (layers[fow->dark_layer_id][b_l.x][b_l.y] == FogOfWar::TILE_HIDDEN) {
-											if (layers[fow->dark_layer_id][b_r.x][b_r.y] == FogOfWar::TILE_HIDDEN) {
-												continue;
-											}
-										}
-									}
-								}
-							}
-						}
-					}
+					if (isCoveredByFogOfWar(layer_id, i, j))
+						continue;
 
 					// no need to set w and h in dest, as it is ignored
 					// by SDL_BlitSurface
@@ -563,6 +560,34 @@ void MapRenderer::renderIsoLayer(const Map_Layer& layerdata, const TileSet& tile
 	}
 }
 
+/**
+ * Invalidate the drawn tiles of the previous frame by bumping the stamp.
+ * The backing storage is only reallocated when the map size changes.
+ */
+void MapRenderer::resetDrawnTiles() {
+	const size_t tile_count = static_cast<size_t>(w) * static_cast<size_t>(h);
+	if (drawn_tiles.size() != tile_count) {
+		drawn_tiles.assign(tile_count, 0);
+		drawn_tiles_stamp = 0;
+	}
+
+	++drawn_tiles_stamp;
+
+	// the stamp wrapped around, so old entries could be mistaken for current ones
+	if (drawn_tiles_stamp == 0) {
+		std::fill(drawn_tiles.begin(), drawn_tiles.end(), 0);
+		drawn_tiles_stamp = 1;
+	}
+}
+
+void MapRenderer::drawRenderableQueue(std::vector<std::vector<Renderable>::iterator> &queue) {
+	for (size_t k = 0; k < queue.size(); ++k) {
+		drawRenderable(queue[k]);
+	}
+	// clear() keeps the capacity, so the queues stop allocating once they've grown
+	queue.clear();
+}
+
 void MapRenderer::renderIsoBackObjects(std::vector<Renderable> &r) {
 	std::vector<Renderable>::iterator it;
 	for (it = r.begin(); it != r.end(); ++it)
@@ -589,11 +614,7 @@ void MapRenderer::renderIsoFrontObjects(std::vector<Renderable> &r) {
 	if (index_objectlayer >= layers.size())
 		return;
 
-	std::queue<std::vector<Renderable>::iterator> render_behind_SW;
-	std::queue<std::vector<Renderable>::iterator> render_behind_NE;
-	std::queue<std::vector<Renderable>::iterator> render_behind_none;
-
-	Map_Layer drawn_tiles(w, std::vector<unsigned short>(h, 0));
+	resetDrawnTiles();
 
 	for (uint_fast16_t y = max_tiles_height ; y; --y) {
 		int_fast16_t tiles_width = 0;
@@ -640,7 +661,7 @@ void MapRenderer::renderIsoFrontObjects(std::vector<Renderable> &r) {
 				++r_pre_cursor;
 			}
 
-			if (draw_tile && !drawn_tiles[i][j]) {
+			if (draw_tile && !isTileDrawn(i, j)) {
 				if (const uint_fast16_t current_tile = current_layer[i][j]) {
 					const Tile_Def &tile = tset.tiles[current_tile];
 					if (tile.tile) {
@@ -649,56 +670,15 @@ void MapRenderer::renderIsoFrontObjects(std::vector<Renderable> &r) {
 						tile.tile->setDestFromPoint(dest);
 
 						//skip rendering tiles that are underneath fow hidden tiles
-						if (fogofwar == FogOfWar::TYPE_OVERLAY) {
-							if (&current_layer != &layers[fow->dark_layer_id]) {
-								if (layers[fow->dark_layer_id][i][j] == FogOfWar::TILE_HIDDEN) {
-
-									//check tile's corners
-									Point t_l(Utils::screenToMap(dest.x, dest.y, cam.shake.x, cam.shake.y));
-									Point t_r(Utils::screenToMap(dest.x + tile.tile->getClip().w, dest.y, cam.shake.x, cam.shake.y));
-									Point b_l(Utils::screenToMap(dest.x, dest.y + tile.tile->getClip().h, cam.shake.x, cam.shake.y));
-									Point b_r(Utils::screenToMap(dest.x + tile.tile->getClip().w, dest.y + tile.tile->getClip().h, cam.shake.x, cam.shake.y));
-
-									//limit to map bounds
-									if (t_l.x < 0) t_l.x = 0;
-									if (t_l.x >= w) t_l.x = w-1;
-									if (t_l.y < 0) t_l.y = 0;
-									if (t_l.y >= h) t_l.y = h-1;
-
-									if (t_r.x < 0) t_r.x = 0;
-									if (t_r.x >= w) t_r.x = w-1;
-									if (t_r.y < 0) t_r.y = 0;
-									if (t_r.y >= h) t_r.y = h-1;
-
-									if (b_l.x < 0) b_l.x = 0;
-									if (b_l.x >= w) b_l.x = w-1;
-									if (b_l.y < 0) b_l.y = 0;
-									if (b_l.y >= h) b_l.y = h-1;
-
-									if (b_r.x < 0) b_r.x = 0;
-									if (b_r.x >= w) b_r.x = w-1;
-									if (b_r.y < 0) b_r.y = 0;
-									if (b_r.y >= h) b_r.y = h-1;
-
-									if (layers[fow->dark_layer_id][t_l.x][t_l.y] == FogOfWar::TILE_HIDDEN) {
-										if (layers[fow->dark_layer_id][t_r.x][t_r.y] == FogOfWar::TILE_HIDDEN) {
-											if (layers[fow->dark_layer_id][b_l.x][b_l.y] == FogOfWar::TILE_HIDDEN) {
-												if (layers[fow->dark_layer_id][b_r.x][b_r.y] == FogOfWar::TILE_HIDDEN) {
-													continue;
-												}
-											}
-										}
-									}
-								}
-							}
-						}
+						if (isCoveredByFogOfWar(index_objectlayer, i, j))
+							continue;
 
 						checkHiddenEntities(i, j, current_layer, r);
 						if (fogofwar == FogOfWar::TYPE_TINT) {
 							tile.tile->color_mod = fow->getTileColorMod(i, j);
 						}
 						render_device->render(tile.tile);
-						drawn_tiles[i][j] = 1;
+						setTileDrawn(i, j);
 					}
 				}
 			}
@@ -754,11 +734,11 @@ do_last_NE_tile:
 					}
 
 					if (is_behind_SW)
-						render_behind_SW.push(r_cursor);
+						render_behind_SW.push_back(r_cursor);
 					else if (is_behind_NE)
-						render_behind_NE.push(r_cursor);
+						render_behind_NE.push_back(r_cursor);
 					else
-						render_behind_none.push(r_cursor);
+						render_behind_none.push_back(r_cursor);
 
 					++r_cursor;
 				}
@@ -767,13 +747,10 @@ do_last_NE_tile:
 				}
 			}
 
-			while (!render_behind_SW.empty()) {
-				drawRenderable(render_behind_SW.front());
-				render_behind_SW.pop();
-			}
+			drawRenderableQueue(render_behind_SW);
 
 			// draw the south-west tile
-			if (draw_SW_tile && i-2 >= 0 && j+2 < h && !drawn_tiles[i-2][j+2]) {
+			if (draw_SW_tile && i-2 >= 0 && j+2 < h && !isTileDrawn(static_cast<int_fast16_t>(i-2), static_cast<int_fast16_t>(j+2))) {
 				if (const uint_fast16_t current_tile = current_layer[i-2][j+2]) {
 					const Tile_Def &tile = tset.tiles[current_tile];
 					if (tile.tile) {
@@ -785,18 +762,15 @@ do_last_NE_tile:
 							tile.tile->color_mod = fow->getTileColorMod(i, j);
 						}
 						render_device->render(tile.tile);
-						drawn_tiles[i-2][j+2] = 1;
+						setTileDrawn(static_cast<int_fast16_t>(i-2), static_cast<int_fast16_t>(j+2));
 					}
 				}
 			}
 
-			while (!render_behind_NE.empty()) {
-				drawRenderable(render_behind_NE.front());
-				render_behind_NE.pop();
-			}
+			drawRenderableQueue(render_behind_NE);
 
 			// draw the north-east tile
-			if (draw_NE_tile && !draw_tile && !drawn_tiles[i][j]) {
+			if (draw_NE_tile && !draw_tile && !isTileDrawn(i, j)) {
 				if (const uint_fast16_t current_tile = current_layer[i][j]) {
 					const Tile_Def &tile = tset.tiles[current_tile];
 					if (tile.tile) {
@@ -808,15 +782,12 @@ do_last_NE_tile:
 							tile.tile->color_mod = fow->getTileColorMod(i, j);
 						}
 						render_device->render(tile.tile);
-						drawn_tiles[i][j] = 1;
+						setTileDrawn(i, j);
 					}
 				}
 			}
 
-			while (!render_behind_none.empty()) {
-				drawRenderable(render_behind_none.front());
-				render_behind_none.pop();
-			}
+			drawRenderableQueue(render_behind_none);
 
 			// Okay, this is a bit of a HACK
 			// In order to properly render the first row and last column of the map, we need to advance to an imaginary tile
@@ -849,30 +820,33 @@ void MapRenderer::renderIso(std::vector<Renderable> &r, std::vector<Renderable>
 	size_t index = 0;
 
 	while (index < index_objectlayer) {
-		renderIsoLayer(layers[index], tset);
+		renderIsoLayer(static_cast<unsigned>(index), tset);
 		map_parallax.render(cam.shake, layernames[index]);
 		index++;
 	}
 
-	renderIsoBackObjects(r_dead);
-	renderIsoFrontObjects(r);
+	{
+		PROFILE_ZONE(Profiler::ZONE_MAP_OBJECTS);
+		renderIsoBackObjects(r_dead);
+		renderIsoFrontObjects(r);
+	}
 	map_parallax.render(cam.shake, layernames[index]);
 
 	index++;
 	while (index < layers.size()) {
 		if (fogofwar == FogOfWar::TYPE_OVERLAY) {
 			if (layernames[index] == "fow_dark") {
-				renderIsoLayer(layers[index],fow->tset_dark);
+				renderIsoLayer(static_cast<unsigned>(index), fow->tset_dark);
 			}
 			else if (layernames[index] == "fow_fog") {
-				renderIsoLayer(layers[index],fow->tset_fog);
+				renderIsoLayer(static_cast<unsigned>(index), fow->tset_fog);
 			}
 			else {
-				renderIsoLayer(layers[index], tset);
+				renderIsoLayer(static_cast<unsigned>(index), tset);
 			}
 		}
 		else if (layernames[index] != "fow_dark" && layernames[index] != "fow_fog") {
-			renderIsoLayer(layers[index], tset);
+			renderIsoLayer(static_cast<unsigned>(index), tset);
 		}
 		map_parallax.render(cam.shake, layernames[index]);
 		index++;
@@ -884,7 +858,10 @@ void MapRenderer::renderIso(std::vector<Renderable> &r, std::vector<Renderable>
 	drawDevCursor();
 }
 
-void MapRenderer::renderOrthoLayer(const Map_Layer& layerdata, const TileSet& tile_set) {
+void MapRenderer::renderOrthoLayer(const unsigned layer_id, const TileSet& tile_set) {
+	PROFILE_ZONE(Profiler::ZONE_MAP_LAYERS);
+
+	const Map_Layer& layerdata = layers[layer_id];
 
 	Point dest;
 	const Point upperleft(Utils::screenToMap(0, 0, cam.shake.x, cam.shake.y));
@@ -908,52 +885,8 @@ void MapRenderer::renderOrthoLayer(const Map_Layer& layerdata, const TileSet& ti
 					dest.x = p.x - tile.offset.x;
 					dest.y = p.y - tile.offset.y;
 
-					bool skip_tile_render = false;
-
 					//skip rendering tiles that are underneath fow hidden tiles
-					if (fogofwar == FogOfWar::TYPE_OVERLAY) {
-						if (&layerdata != &layers[fow->dark_layer_id]) {
-							if (layers[fow->dark_layer_id][i][j] == FogOfWar::TILE_HIDDEN) {
-
-								//check tile's corners
-								Point t_l(Utils::screenToMap(dest.x, dest.y, cam.shake.x, cam.shake.y));
-								Point t_r(Utils::screenToMap(dest.x + tile.tile->getClip().w, dest.y, cam.shake.x, cam.shake.y));
-								Point b_l(Utils::screenToMap(dest.x, dest.y + tile.tile->getClip().h, cam.shake.x, cam.shake.y));
-								Point b_r(Utils::screenToMap(dest.x + tile.tile->getClip().w, dest.y + tile.tile->getClip().h, cam.shake.x, cam.shake.y));
-
-								//limit to map bounds
-								if (t_l.x < 0) t_l.x = 0;
-								if (t_l.x >= w) t_l.x = w-1;
-								if (t_l.y < 0) t_l.y = 0;
-								if (t_l.y >= h) t_l.y = h-1;
-
-								if (t_r.x < 0) t_r.x = 0;
-								if (t_r.x >= w) t_r.x = w-1;
-								if (t_r.y < 0) t_r.y = 0;
-								if (t_r.y >= h) t_r.y = h-1;
-
-								if (b_l.x < 0) b_l.x = 0;
-								if (b_l.x >= w) b_l.x = w-1;
-								if (b_l.y < 0) b_l.y = 0;
-								if (b_l.y >= h) b_l.y = h-1;
-
-								if (b_r.x < 0) b_r.x = 0;
-								if (b_r.x >= w) b_r.x = w-1;
-								if (b_r.y < 0) b_r.y = 0;
-								if (b_r.y >= h) b_r.y = h-1;
-
-								if (layers[fow->dark_layer_id][t_l.x][t_l.y] == FogOfWar::TILE_HIDDEN) {
-									if (layers[fow->dark_layer_id][t_r.x][t_r.y] == FogOfWar::TILE_HIDDEN) {
-										if (layers[fow->dark_layer_id][b_l.x][b_l.y] == FogOfWar::TILE_HIDDEN) {
-											if (layers[fow->dark_layer_id][b_r.x][b_r.y] == FogOfWar::TILE_HIDDEN) {
-												skip_tile_render = true;
-											}
-										}
-									}
-								}
-							}
-						}
-					}
+					const bool skip_tile_render = isCoveredByFogOfWar(layer_id, i, j);
 
 					tile.tile->setDestFromPoint(dest);
 					if (!skip_tile_render) {
@@ -1009,52 +942,8 @@ void MapRenderer::renderOrthoFrontObjects(std::vector<Renderable> &r) {
 					dest.y = p.y - tile.offset.y;
 					tile.tile->setDestFromPoint(dest);
 
-					bool skip_tile_render = false;
-
 					//skip rendering tiles that are underneath fow hidden tiles
-					if (fogofwar == FogOfWar::TYPE_OVERLAY) {
-						if (&layers[index_objectlayer] != &layers[fow->dark_layer_id]) {
-							if (layers[fow->dark_layer_id][i][j] == FogOfWar::TILE_HIDDEN) {
-
-								//check tile's corners
-								Point t_l(Utils::screenToMap(dest.x, dest.y, cam.shake.x, cam.shake.y));
-								Point t_r(Utils::screenToMap(dest.x + tile.tile->getClip().w, dest.y, cam.shake.x, cam.shake.y));
-								Point b_l(Utils::screenToMap(dest.x, dest.y + tile.tile->getClip().h, cam.shake.x, cam.shake.y));
-								Point b_r(Utils::screenToMap(dest.x + tile.tile->getClip().w, dest.y + tile.tile->getClip().h, cam.shake.x, cam.shake.y));
-
-								//limit to map bounds
-								if (t_l.x < 0) t_l.x = 0;
-								if (t_l.x >= w) t_l.x = w-1;
-								if (t_l.y < 0) t_l.y = 0;
-								if (t_l.y >= h) t_l.y = h-1;
-
-								if (t_r.x < 0) t_r.x = 0;
-								if (t_r.x >= w) t_r.x = w-1;
-								if (t_r.y < 0) t_r.y = 0;
-								if (t_r.y >= h) t_r.y = h-1;
-
-								if (b_l.x < 0) b_l.x = 0;
-								if (b_l.x >= w) b_l.x = w-1;
-								if (b_l.y < 0) b_l.y = 0;
-								if (b_l.y >= h) b_l.y = h-1;
-
-								if (b_r.x < 0) b_r.x = 0;
-								if (b_r.x >= w) b_r.x = w-1;
-								if (b_r.y < 0) b_r.y = 0;
-								if (b_r.y >= h) b_r.y = h-1;
-
-								if (layers[fow->dark_layer_id][t_l.x][t_l.y] == FogOfWar::TILE_HIDDEN) {
-									if (layers[fow->dark_layer_id][t_r.x][t_r.y] == FogOfWar::TILE_HIDDEN) {
-										if (layers[fow->dark_layer_id][b_l.x][b_l.y] == FogOfWar::TILE_HIDDEN) {
-											if (layers[fow->dark_layer_id][b_r.x][b_r.y] == FogOfWar::TILE_HIDDEN) {
-												skip_tile_render = true;
-											}
-										}
-									}
-								}
-							}
-						}
-					}
+					const bool skip_tile_render = isCoveredByFogOfWar(index_objectlayer, i, j);
 
 					checkHiddenEntities(i, j, layers[index_objectlayer], r);
 					if (!skip_tile_render) {
@@ -1082,30 +971,33 @@ void MapRenderer::renderOrthoFrontObjects(std::vector<Renderable> &r) {
 void MapRenderer::renderOrtho(std::vector<Renderable> &r, std::vector<Renderable> &r_dead) {
 	unsigned index = 0;
 	while (index < index_objectlayer) {
-		renderOrthoLayer(layers[index], tset);
+		renderOrthoLayer(index, tset);
 		map_parallax.render(cam.shake, layernames[index]);
 		index++;
 	}
 
-	renderOrthoBackObjects(r_dead);
-	renderOrthoFrontObjects(r);
+	{
+		PROFILE_ZONE(Profiler::ZONE_MAP_OBJECTS);
+		renderOrthoBackObjects(r_dead);
+		renderOrthoFrontObjects(r);
+	}
 	map_parallax.render(cam.shake, layernames[index]);
 
 	index++;
 	while (index < layers.size()) {
 		if (fogofwar == FogOfWar::TYPE_OVERLAY) {
 			if (layernames[index] == "fow_dark") {
-				renderOrthoLayer(layers[index],fow->tset_dark);
+				renderOrthoLayer(index, fow->tset_dark);
 			}
 			else if (layernames[index] == "fow_fog") {
-				renderOrthoLayer(layers[index],fow->tset_fog);
+				renderOrthoLayer(index, fow->tset_fog);
 			}
 			else {
-				renderOrthoLayer(layers[index], tset);
+				renderOrthoLayer(index, tset);
 			}
 		}
 		else if (layernames[index] != "fow_dark" && layernames[index] != "fow_fog") {
-			renderOrthoLayer(layers[index], tset);
+			renderOrthoLayer(index, tset);
 		}
 		map_parallax.render(cam.shake, layernames[index]);
 		index++;
@@ -1181,6 +1073,36 @@ void MapRenderer::executeOnMapExitEvents() {
 	}
 }
 
+/**
+ * When the hero approaches an intermap event, its map is prepared in the background
+ * so that the map change doesn't need to parse it or decode its tileset.
+ */
+void MapRenderer::streamNearbyMaps() {
+	if (!pc || streamer.isBusy())
+		return;
+
+	for (size_t i = 0; i < events.size(); ++i) {
+		EventComponent* ec = events[i].getComponent(EventComponent::INTERMAP);
+
+		// intermap_random only picks its map when triggered
+		if (!ec || ec->data[2].Bool)
+			continue;
+
+		if (Utils::calcDist(pc->stats.pos, events[i].center) > static_cast<float>(MapStreamer::PREFETCH_RANGE))
+			continue;
+
+		if (!EventManager::isActive(events[i]))
+			continue;
+
+		streamer.request(ec->s, tileset);
+		return;
+	}
+}
+
+void MapRenderer::releaseStreamedMap() {
+	streamer.release();
+}
+
 void MapRenderer::checkEvents(const FPoint& loc) {
 	Point maploc;
 	maploc.x = int(loc.x);
@@ -1479,6 +1401,22 @@ void MapRenderer::activatePower(PowerID power_index, unsigned statblock_index, c
 	}
 }
 
+/**
+ * Adds a tile to the area the mini map needs to redraw
+ */
+void MapRenderer::setMapChange(int x, int y) {
+	if (!map_change) {
+		map_change_area = Rect(x, y, x+1, y+1);
+		map_change = true;
+		return;
+	}
+
+	map_change_area.x = std::min(map_change_area.x, x);
+	map_change_area.y = std::min(map_change_area.y, y);
+	map_change_area.w = std::max(map_change_area.w, x+1);
+	map_change_area.h = std::max(map_change_area.h, y+1);
+}
+
 bool MapRenderer::isValidTile(const unsigned &tile) {
 	if (tile == 0)
 		return true;
@@ -1489,6 +1427,127 @@ bool MapRenderer::isValidTile(const unsigned &tile) {
 	return tset.tiles[tile].tile != NULL;
 }
 
+/**
+ * A tile is covered by fog of war if it is on a hidden tile and all corners of its image are on hidden tiles too.
+ * The corners are projected relative to the tile's own map position, so the result doesn't depend on the camera.
+ */
+bool MapRenderer::calcCoveredByFogOfWar(const Map_Layer& layerdata, const TileSet& tile_set, const int x, const int y) {
+	const uint_fast16_t current_tile = layerdata[x][y];
+	if (current_tile == 0 || current_tile >= tile_set.tiles.size())
+		return false;
+
+	const Tile_Def &tile = tile_set.tiles[current_tile];
+	if (!tile.tile)
+		return false;
+
+	FPoint deltas[4];
+	calcTileCornerDeltas(tile, deltas);
+
+	Point corner_tiles[4];
+
+	for (int k = 0; k < 4; ++k) {
+		//limit to map bounds
+		corner_tiles[k].x = static_cast<int>(floorf(static_cast<float>(x) + deltas[k].x));
+		corner_tiles[k].y = static_cast<int>(floorf(static_cast<float>(y) + deltas[k].y));
+		corner_tiles[k].x = std::min(std::max(corner_tiles[k].x, 0), w-1);
+		corner_tiles[k].y = std::min(std::max(corner_tiles[k].y, 0), h-1);
+	}
+
+	const Map_Layer& dark_layer = layers[fow->dark_layer_id];
+	if (dark_layer[x][y] != FogOfWar::TILE_HIDDEN)
+		return false;
+
+	for (int k = 0; k < 4; ++k) {
+		if (dark_layer[corner_tiles[k].x][corner_tiles[k].y] != FogOfWar::TILE_HIDDEN)
+			return false;
+	}
+
+	return true;
+}
+
+/**
+ * Gets the map offsets of the corners of a tile's image, relative to the tile's own map position.
+ */
+void MapRenderer::calcTileCornerDeltas(const Tile_Def& tile, FPoint deltas[4]) {
+	const Point origin = centerTile(Point(0, 0));
+	const int left = origin.x - tile.offset.x;
+	const int top = origin.y - tile.offset.y;
+	const int right = left + tile.tile->getClip().w;
+	const int bottom = top + tile.tile->getClip().h;
+
+	const Point corners[4] = {
+		Point(left, top),
+		Point(right, top),
+		Point(left, bottom),
+		Point(right, bottom)
+	};
+
+	for (int k = 0; k < 4; ++k) {
+		if (eset->tileset.orientation == eset->tileset.TILESET_ISOMETRIC) {
+			const float scrx = static_cast<float>(corners[k].x) * 0.5f;
+			const float scry = static_cast<float>(corners[k].y) * 0.5f;
+			deltas[k].x = (eset->tileset.units_per_pixel_x * scrx) + (eset->tileset.units_per_pixel_y * scry);
+			deltas[k].y = (eset->tileset.units_per_pixel_y * scry) - (eset->tileset.units_per_pixel_x * scrx);
+		}
+		else {
+			deltas[k].x = static_cast<float>(corners[k].x) * eset->tileset.units_per_pixel_x;
+			deltas[k].y = static_cast<float>(corners[k].y) * eset->tileset.units_per_pixel_y;
+		}
+	}
+}
+
+/**
+ * Grows fow_covered_reach to cover every tile in the tileset, including ones the map only places later through events.
+ */
+void MapRenderer::calcFogOfWarCoveredReach(const TileSet& tile_set) {
+	for (size_t i = 0; i < tile_set.tiles.size(); ++i) {
+		if (!tile_set.tiles[i].tile)
+			continue;
+
+		FPoint deltas[4];
+		calcTileCornerDeltas(tile_set.tiles[i], deltas);
+
+		for (int k = 0; k < 4; ++k) {
+			const int reach = static_cast<int>(ceilf(std::max(fabsf(deltas[k].x), fabsf(deltas[k].y))));
+			if (reach > fow_covered_reach)
+				fow_covered_reach = reach;
+		}
+	}
+}
+
+/**
+ * Called when the fog of war dark layer (or a map layer) changes within the given tile range.
+ * Since a tile's image can extend over its neighbors, the range is grown by how far tile corners can reach.
+ */
+void MapRenderer::updateFogOfWarCoverage(int x0, int y0, int x1, int y1) {
+	if (fogofwar != FogOfWar::TYPE_OVERLAY || fow_covered.empty() || fow->dark_layer_id >= layers.size())
+		return;
+
+	x0 = std::max(x0 - fow_covered_reach, 0);
+	y0 = std::max(y0 - fow_covered_reach, 0);
+	x1 = std::min(x1 + fow_covered_reach, w-1);
+	y1 = std::min(y1 + fow_covered_reach, h-1);
+
+	const unsigned layer_count = std::min(static_cast<unsigned>(layers.size()), 32u);
+
+	for (int y = y0; y <= y1; ++y) {
+		for (int x = x0; x <= x1; ++x) {
+			uint32_t covered = 0;
+
+			for (unsigned layer_id = 0; layer_id < layer_count; ++layer_id) {
+				if (layer_id == fow->dark_layer_id)
+					continue;
+
+				const TileSet& tile_set = (layer_id == fow->fog_layer_id) ? fow->tset_fog : tset;
+				if (calcCoveredByFogOfWar(layers[layer_id], tile_set, x, y))
+					covered |= (1u << layer_id);
+			}
+
+			fow_covered[x + y * w] = covered;
+		}
+	}
+}
+
 Point MapRenderer::centerTile(const Point& p) {
 	Point r = p;
 
@@ -1643,6 +1702,65 @@ void MapRenderer::drawDevHUD() {
 
 		render_device->drawEllipse(p0.x - radius, p0.y - radius/distort, p0.x + radius, p0.y + radius/distort, color_hazard, 15);
 	}
+
+	if (show_perf_hud)
+		drawPerfHUD();
+}
+
+void MapRenderer::getPerfReport(std::vector<std::string>& lines) {
+	Profiler::getReport(lines);
+
+	std::stringstream ss;
+	ss << "hazards alive: " << hazards->h.size();
+	lines.push_back(ss.str());
+
+	ss.str("");
+	ss << "entities: " << entitym->entities.size();
+	lines.push_back(ss.str());
+
+	ss.str("");
+	ss << "texture memory: " << std::fixed << std::setprecision(1) << static_cast<float>(render_device->getCacheMemory()) / (1024.f * 1024.f) << " MiB";
+	ss << " (unused " << static_cast<float>(render_device->getCacheUnusedMemory()) / (1024.f * 1024.f) << ")";
+	lines.push_back(ss.str());
+
+	const char* const CACHE_CATEGORY_NAMES[RenderDevice::CACHE_CATEGORY_COUNT] = {"tiles", "animations", "ui", "portraits", "other"};
+	ss.str("");
+	for (int i = 0; i < RenderDevice::CACHE_CATEGORY_COUNT; ++i) {
+		if (i > 0)
+			ss << ", ";
+		ss << CACHE_CATEGORY_NAMES[i] << " " << static_cast<float>(render_device->getCacheMemory(i)) / (1024.f * 1024.f);
+	}
+	lines.push_back(ss.str());
+}
+
+void MapRenderer::drawPerfHUD() {
+	if (perf_update.isEnd() || perf_labels.empty()) {
+		perf_update.reset(Timer::BEGIN);
+
+		std::vector<std::string> lines;
+		getPerfReport(lines);
+
+		while (perf_labels.size() < lines.size()) {
+			perf_labels.push_back(new WidgetLabel());
+		}
+
+		const int line_height = font->getLineHeight();
+		for (size_t i = 0; i < perf_labels.size(); ++i) {
+			perf_labels[i]->setHidden(i >= lines.size());
+			if (i >= lines.size())
+				continue;
+
+			perf_labels[i]->setJustify(FontEngine::JUSTIFY_RIGHT);
+			perf_labels[i]->setPos(settings->view_w - line_height, line_height * (static_cast<int>(i) + 2));
+			perf_labels[i]->setText(lines[i]);
+			perf_labels[i]->setColor(font->getColor(FontEngine::COLOR_WIDGET_NORMAL));
+		}
+	}
+
+	for (size_t i = 0; i < perf_labels.size(); ++i) {
+		perf_labels[i]->render();
+	}
+	perf_update.tick();
 }
 
 void MapRenderer::drawHiddenEntityMarkers() {
@@ -1788,5 +1906,9 @@ MapRenderer::~MapRenderer() {
 
 	delete entity_hidden_normal;
 	delete entity_hidden_enemy;
+
+	for (size_t i = 0; i < perf_labels.size(); ++i) {
+		delete perf_labels[i];
+	}
 }
 
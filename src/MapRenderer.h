@@ -33,12 +33,14 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 #include "Map.h"
 #include "MapCollision.h"
 #include "MapParallax.h"
+#include "MapStreamer.h"
 #include "TileSet.h"
 #include "TooltipData.h"
 #include "Utils.h"
 
 class FileParser;
 class Sprite;
+class WidgetLabel;
 class WidgetTooltip;
 
 class MapRenderer : public Map {
@@ -56,7 +58,7 @@ private:
 
 	void drawRenderable(std::vector<Renderable>::iterator r_cursor);
 
-	void renderIsoLayer(const Map_Layer& layerdata, const TileSet& tile_set);
+	void renderIsoLayer(const unsigned layer_id, const TileSet& tile_set);
 
 	// renders only objects
 	void renderIsoBackObjects(std::vector<Renderable> &r);
@@ -65,7 +67,7 @@ private:
 	void renderIsoFrontObjects(std::vector<Renderable> &r);
 	void renderIso(std::vector<Renderable> &r, std::vector<Renderable> &r_dead);
 
-	void renderOrthoLayer(const Map_Layer& layerdata, const TileSet& tile_set);
+	void renderOrthoLayer(const unsigned layer_id, const TileSet& tile_set);
 	void renderOrthoBackObjects(std::vector<Renderable> &r);
 	void renderOrthoFrontObjects(std::vector<Renderable> &r);
 	void renderOrtho(std::vector<Renderable> &r, std::vector<Renderable> &r_dead);
@@ -78,6 +80,7 @@ private:
 
 	void drawDevCursor();
 	void drawDevHUD();
+	void drawPerfHUD();
 	void drawHiddenEntityMarkers();
 	void drawMovementRange(const FPoint& center, float range);
 
@@ -87,11 +90,43 @@ private:
 
 	MapParallax map_parallax;
 
+	MapStreamer streamer;
+
 	Sprite* entity_hidden_normal;
 	Sprite* entity_hidden_enemy;
 
 	std::vector<std::vector<Renderable>::iterator> hidden_entities;
 
+	// persistent scratch state for renderIsoFrontObjects(), so that the pass doesn't allocate every frame
+	// a tile has been drawn this frame if its entry in drawn_tiles matches drawn_tiles_stamp
+	std::vector<unsigned> drawn_tiles;
+	unsigned drawn_tiles_stamp;
+	std::vector<std::vector<Renderable>::iterator> render_behind_SW;
+	std::vector<std::vector<Renderable>::iterator> render_behind_NE;
+	std::vector<std::vector<Renderable>::iterator> render_behind_none;
+
+	void resetDrawnTiles();
+	bool isTileDrawn(const int_fast16_t x, const int_fast16_t y) { return drawn_tiles[x + y * w] == drawn_tiles_stamp; }
+	void setTileDrawn(const int_fast16_t x, const int_fast16_t y) { drawn_tiles[x + y * w] = drawn_tiles_stamp; }
+	void drawRenderableQueue(std::vector<std::vector<Renderable>::iterator> &queue);
+
+	// per-tile bitmask of layers whose tile is completely covered by hidden fog of war tiles (bit n is layer n)
+	// this is only used by FogOfWar::TYPE_OVERLAY, to skip rendering tiles that can't be seen anyway
+	std::vector<uint32_t> fow_covered;
+	// how far (in tiles) a tile's corners can reach from its map position
+	int fow_covered_reach;
+
+	bool isCoveredByFogOfWar(const unsigned layer_id, const int_fast16_t x, const int_fast16_t y) {
+		return layer_id < 32 && !fow_covered.empty() && (fow_covered[x + y * w] & (1u << layer_id));
+	}
+	bool calcCoveredByFogOfWar(const Map_Layer& layerdata, const TileSet& tile_set, const int x, const int y);
+	void calcTileCornerDeltas(const Tile_Def& tile, FPoint deltas[4]);
+	void calcFogOfWarCoveredReach(const TileSet& tile_set);
+
+	// performance overlay for the dev HUD. The text is only updated a few times per second
+	std::vector<WidgetLabel*> perf_labels;
+	Timer perf_update;
+
 public:
 	// functions
 	MapRenderer();
@@ -101,6 +136,10 @@ public:
 
 	int load(const std::string& filename);
 	void logic(bool paused);
+	void streamNearbyMaps();
+
+	// called once the entities of a new map have loaded the images prepared for it
+	void releaseStreamedMap();
 	void render(std::vector<Renderable> &r, std::vector<Renderable> &r_dead);
 
 	void checkEvents(const FPoint& loc);
@@ -118,10 +157,20 @@ public:
 	void activatePower(PowerID power_index, unsigned statblock_index, const FPoint &target);
 
 	bool isValidTile(const unsigned &tile);
+	void setMapChange(int x, int y);
 	Point centerTile(const Point& p);
 
 	void setMapParallax(const std::string& mp_filename);
 
+	// recalculates which tiles are hidden by fog of war in the given (inclusive) tile range
+	void updateFogOfWarCoverage(int x0, int y0, int x1, int y1);
+
+	// the profiler's frame statistics, plus what's currently alive on the map and in the image cache
+	void getPerfReport(std::vector<std::string>& lines);
+
+	// shows the performance overlay as part of the dev HUD (see the "perf" console command)
+	bool show_perf_hud;
+
 	// cam is where on the map the camera is pointing
 	Camera cam;
 
@@ -129,6 +178,9 @@ public:
 	// will tell the mini map to update.
 	bool map_change;
 
+	// the changed tiles, where w and h are the end points (like FogOfWar's dirty areas)
+	Rect map_change_area;
+
 	MapCollision collider;
 
 	// event-created loot or items
@@ -0,0 +1,197 @@
+/*
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+/**
+ * class MapStreamer
+ */
+
+#include "FileParser.h"
+#include "MapBinary.h"
+#include "MapManifest.h"
+#include "MapStreamer.h"
+#include "ModManager.h"
+#include "RenderDevice.h"
+#include "SharedResources.h"
+#include "TaskGraph.h"
+#include "Utils.h"
+
+#include <SDL_image.h>
+
+MapStreamer::MapStreamer()
+	: decode_images(true)
+	, map(NULL)
+	, thread(NULL)
+{
+	SDL_AtomicSet(&done, 0);
+}
+
+MapStreamer::~MapStreamer() {
+	wait();
+	clear();
+}
+
+void MapStreamer::request(const std::string& _filename, const std::string& current_tileset) {
+	if (_filename == filename && (thread || map))
+		return;
+
+	// don't block the game to replace a map that is still being prepared
+	if (isBusy())
+		return;
+
+	wait();
+	clear();
+
+	filename = _filename;
+	skip_tileset = current_tileset;
+
+	// the pixels would only be thrown away by a render device that doesn't keep them
+	decode_images = render_device->needsPixels();
+
+	SDL_AtomicSet(&done, 0);
+	thread = SDL_CreateThread(threadFunction, "map_streamer", this);
+	if (!thread) {
+		Utils::logError("MapStreamer: Unable to create thread, '%s' will be loaded on demand. %s", filename.c_str(), SDL_GetError());
+		filename.clear();
+	}
+}
+
+MapBinary* MapStreamer::take(const std::string& _filename) {
+	wait();
+
+	if (!map || _filename != filename) {
+		clear();
+		return NULL;
+	}
+
+	for (size_t i = 0; i < decodes.size(); ++i) {
+		if (!decodes[i].surface)
+			continue;
+
+		Image* image = render_device->loadImageFromSurface(decodes[i].filename, decodes[i].surface);
+		if (image)
+			images.push_back(image);
+		SDL_FreeSurface(decodes[i].surface);
+	}
+	decodes.clear();
+
+	return map;
+}
+
+void MapStreamer::release() {
+	wait();
+	clear();
+}
+
+bool MapStreamer::isBusy() {
+	return thread && !SDL_AtomicGet(&done);
+}
+
+int MapStreamer::threadFunction(void* data) {
+	MapStreamer* streamer = static_cast<MapStreamer*>(data);
+	streamer->prepare();
+	SDL_AtomicSet(&streamer->done, 1);
+	return 0;
+}
+
+/**
+ * Runs on the worker thread. Only reads and decodes files, so it doesn't touch the
+ * render device or any of the game's managers.
+ */
+void MapStreamer::prepare() {
+	map = new MapBinary();
+	if (!map->prepare(filename)) {
+		delete map;
+		map = NULL;
+		return;
+	}
+
+	if (!decode_images)
+		return;
+
+	std::string tileset;
+	FileParser infile;
+	if (infile.openData(filename, map->getSections(), FileParser::ERROR_NONE)) {
+		while (infile.next()) {
+			if (infile.section == "header" && infile.key == "tileset")
+				tileset = infile.val;
+		}
+		infile.close();
+	}
+
+	// the tileset is needed first, unless it is the current one and already loaded
+	std::vector<std::string> image_filenames;
+	if (!tileset.empty() && tileset != skip_tileset && infile.open(tileset, FileParser::MOD_FILE, FileParser::ERROR_NONE)) {
+		while (infile.next()) {
+			if (infile.key == "img")
+				image_filenames.push_back(infile.val);
+		}
+		infile.close();
+	}
+
+	MapManifest::read(filename, image_filenames);
+
+	for (size_t i = 0; i < image_filenames.size(); ++i) {
+		bool found = false;
+		for (size_t j = 0; j < decodes.size(); ++j) {
+			if (decodes[j].filename == image_filenames[i]) {
+				found = true;
+				break;
+			}
+		}
+		if (!found) {
+			decodes.resize(decodes.size() + 1);
+			decodes.back().filename = image_filenames[i];
+		}
+	}
+
+	// tasks start in the order they were added, so the tileset is decoded first
+	TaskGraph graph;
+	for (size_t i = 0; i < decodes.size(); ++i) {
+		graph.add(decodes[i].filename, decodeTask, &decodes[i]);
+	}
+	graph.run();
+}
+
+void MapStreamer::decodeTask(void* data) {
+	// images that fail to decode here are loaded (and their errors logged) when they are used
+	Decode* decode = static_cast<Decode*>(data);
+	decode->surface = IMG_Load_RW(mods->openRW(mods->locate(decode->filename)), 1);
+}
+
+void MapStreamer::wait() {
+	if (thread) {
+		SDL_WaitThread(thread, NULL);
+		thread = NULL;
+	}
+}
+
+void MapStreamer::clear() {
+	delete map;
+	map = NULL;
+
+	for (size_t i = 0; i < decodes.size(); ++i) {
+		if (decodes[i].surface)
+			SDL_FreeSurface(decodes[i].surface);
+	}
+	decodes.clear();
+
+	for (size_t i = 0; i < images.size(); ++i) {
+		images[i]->unref();
+	}
+	images.clear();
+
+	filename.clear();
+	skip_tileset.clear();
+}
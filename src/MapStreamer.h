@@ -0,0 +1,79 @@
+/*
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+/**
+ * class MapStreamer
+ *
+ * Prepares the next map on a worker thread while the current one is played. The map
+ * and its layers are read into a MapBinary, and the images of its tileset and those
+ * listed in its MapManifest are decoded in parallel. MapRenderer::load() then only
+ * parses the small sections of the map (events, enemies, NPCs) and uploads the
+ * decoded images.
+ */
+
+#ifndef MAP_STREAMER_H
+#define MAP_STREAMER_H
+
+#include "CommonIncludes.h"
+
+class MapBinary;
+
+class MapStreamer {
+public:
+	// intermap events closer than this many tiles to the hero are prepared in advance
+	static const int PREFETCH_RANGE = 8;
+
+	MapStreamer();
+	~MapStreamer();
+
+	// starts preparing a map, unless that map is already prepared or another one is still in progress
+	void request(const std::string& filename, const std::string& current_tileset);
+
+	// waits for the map to be prepared and uploads its images. Returns NULL if a different map was prepared
+	MapBinary* take(const std::string& filename);
+
+	// drops the prepared map and the references to its images once the map and its entities have loaded
+	void release();
+
+	bool isBusy();
+
+private:
+	class Decode {
+	public:
+		Decode()
+			: surface(NULL)
+		{}
+		std::string filename;
+		SDL_Surface* surface;
+	};
+
+	static int threadFunction(void* data);
+	static void decodeTask(void* data);
+	void prepare();
+	void wait();
+	void clear();
+
+	std::string filename;
+	std::string skip_tileset;
+	bool decode_images;
+	MapBinary* map;
+	std::vector<Decode> decodes;
+	std::vector<Image*> images;
+
+	SDL_Thread* thread;
+	SDL_atomic_t done;
+};
+
+#endif
@@ -0,0 +1,125 @@
+/*
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+/**
+ * class MappedFile
+ */
+
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile()
+	: data(NULL)
+	, data_size(0)
+	, is_mapped(false)
+	, file_handle(NULL)
+	, map_handle(NULL)
+{
+}
+
+MappedFile::~MappedFile() {
+	close();
+}
+
+bool MappedFile::open(const std::string& filename) {
+	close();
+
+#ifdef _WIN32
+	HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file != INVALID_HANDLE_VALUE) {
+		LARGE_INTEGER file_size;
+		HANDLE mapping = NULL;
+		if (GetFileSizeEx(file, &file_size) && file_size.QuadPart > 0)
+			mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+
+		const void* view = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : NULL;
+		if (view) {
+			data = static_cast<const unsigned char*>(view);
+			data_size = static_cast<size_t>(file_size.QuadPart);
+			file_handle = file;
+			map_handle = mapping;
+			is_mapped = true;
+			return true;
+		}
+
+		if (mapping) CloseHandle(mapping);
+		CloseHandle(file);
+	}
+#else
+	int fd = ::open(filename.c_str(), O_RDONLY);
+	if (fd != -1) {
+		struct stat st;
+		if (fstat(fd, &st) == 0 && st.st_size > 0) {
+			void* view = mmap(NULL, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+			if (view != MAP_FAILED) {
+				data = static_cast<const unsigned char*>(view);
+				data_size = static_cast<size_t>(st.st_size);
+				is_mapped = true;
+			}
+		}
+
+		// the mapping stays valid after the descriptor is closed
+		::close(fd);
+		if (is_mapped)
+			return true;
+	}
+#endif
+
+	SDL_RWops* rw = SDL_RWFromFile(filename.c_str(), "rb");
+	if (!rw)
+		return false;
+
+	Sint64 rw_size = SDL_RWsize(rw);
+	if (rw_size > 0) {
+		buffer.resize(static_cast<size_t>(rw_size));
+		if (SDL_RWread(rw, &buffer[0], 1, buffer.size()) != buffer.size())
+			buffer.clear();
+	}
+	SDL_RWclose(rw);
+
+	if (buffer.empty())
+		return false;
+
+	data = &buffer[0];
+	data_size = buffer.size();
+	return true;
+}
+
+void MappedFile::close() {
+	if (is_mapped) {
+#ifdef _WIN32
+		UnmapViewOfFile(data);
+		CloseHandle(static_cast<HANDLE>(map_handle));
+		CloseHandle(static_cast<HANDLE>(file_handle));
+#else
+		munmap(const_cast<unsigned char*>(data), data_size);
+#endif
+	}
+
+	data = NULL;
+	data_size = 0;
+	is_mapped = false;
+	file_handle = NULL;
+	map_handle = NULL;
+	buffer.clear();
+}
@@ -0,0 +1,53 @@
+/*
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+/**
+ * class MappedFile
+ *
+ * Read-only access to the whole contents of a file. The file is memory-mapped
+ * where the platform allows it, otherwise it is read into a buffer.
+ */
+
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include "CommonIncludes.h"
+
+class MappedFile {
+public:
+	MappedFile();
+	~MappedFile();
+
+	bool open(const std::string& filename);
+	void close();
+
+	const unsigned char* getData() const { return data; }
+	size_t getSize() const { return data_size; }
+
+private:
+	MappedFile(const MappedFile&);
+	MappedFile& operator=(const MappedFile&);
+
+	const unsigned char* data;
+	size_t data_size;
+
+	// set when the file is memory-mapped, otherwise data points into buffer
+	bool is_mapped;
+	void* file_handle;
+	void* map_handle;
+	std::vector<unsigned char> buffer;
+};
+
+#endif
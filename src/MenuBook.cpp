@@ -167,7 +167,7 @@ void MenuBook::loadImage(FileParser &infile, BookImage& bimage) {
 		}
 
 		Image *graphics;
-		graphics = render_device->loadImage(Parse::popFirstString(infile.val), RenderDevice::ERROR_NORMAL);
+		graphics = render_device->loadImageAsync(Parse::popFirstString(infile.val), RenderDevice::ERROR_NORMAL);
 		if (graphics) {
 		  bimage.image = graphics->createSprite();
 		  graphics->unref();
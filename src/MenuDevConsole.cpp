@@ -36,6 +36,7 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 #include "NPC.h"
 #include "NPCManager.h"
 #include "PowerManager.h"
+#include "Profiler.h"
 #include "Settings.h"
 #include "SharedGameResources.h"
 #include "SharedResources.h"
@@ -430,6 +431,7 @@ void MenuDevConsole::execute() {
 		log_history->add("toggle_fps - " + msg->get("turns on/off the display of the FPS counter"), WidgetLog::MSG_UNIQUE);
 		log_history->add("toggle_hud - " + msg->get("turns on/off all of the HUD elements"), WidgetLog::MSG_UNIQUE);
 		log_history->add("toggle_devhud - " + msg->get("turns on/off the developer hud"), WidgetLog::MSG_UNIQUE);
+		log_history->add("perf - " + msg->get("Prints frame times and per-frame counters. 'perf hud' toggles the overlay in the developer hud, 'perf reset' clears the counters and 'perf stop' stops collecting them."), WidgetLog::MSG_UNIQUE);
 		log_history->add("list_powers - " + msg->get("Prints a list of powers that match a search term. No search term will list all items"), WidgetLog::MSG_UNIQUE);
 		log_history->add("list_maps - " + msg->get("Prints out all the map filenames located in the \"maps/\" directory."), WidgetLog::MSG_UNIQUE);
 		log_history->add("list_status - " + msg->get("Prints out the active campaign statuses that match a search term. No search term will list all active statuses"), WidgetLog::MSG_UNIQUE);
@@ -447,6 +449,39 @@ void MenuDevConsole::execute() {
 		settings->dev_hud = !settings->dev_hud;
 		log_history->add(msg->get("Toggled the developer hud"), WidgetLog::MSG_UNIQUE);
 	}
+	else if (args[0] == "perf") {
+		std::string perf_cmd = args.size() > 1 ? args[1] : "";
+
+		if (perf_cmd == "hud") {
+			mapr->show_perf_hud = !mapr->show_perf_hud;
+			if (mapr->show_perf_hud && !Profiler::enabled) {
+				Profiler::reset();
+				Profiler::setEnabled(true);
+			}
+			log_history->add(msg->get("Toggled the performance overlay"), WidgetLog::MSG_UNIQUE);
+		}
+		else if (perf_cmd == "reset") {
+			Profiler::reset();
+			log_history->add(msg->get("Performance counters reset."), WidgetLog::MSG_UNIQUE);
+		}
+		else if (perf_cmd == "stop") {
+			mapr->show_perf_hud = false;
+			Profiler::setEnabled(false);
+			log_history->add(msg->get("Stopped collecting performance counters."), WidgetLog::MSG_UNIQUE);
+		}
+		else if (!Profiler::enabled) {
+			Profiler::reset();
+			Profiler::setEnabled(true);
+			log_history->add(msg->get("Started collecting performance counters. Use 'perf' again to see them."), WidgetLog::MSG_UNIQUE);
+		}
+		else {
+			std::vector<std::string> lines;
+			mapr->getPerfReport(lines);
+			for (size_t i = 0; i < lines.size(); ++i) {
+				log_history->add(lines[i], WidgetLog::MSG_UNIQUE);
+			}
+		}
+	}
 	else if (args[0] == "toggle_hud") {
 		settings->show_hud = !settings->show_hud;
 		log_history->add(msg->get("Toggled the hud"), WidgetLog::MSG_UNIQUE);
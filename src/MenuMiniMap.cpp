@@ -65,6 +65,9 @@ MenuMiniMap::MenuMiniMap()
 	, map_surface_2x(NULL)
 	, map_surface_entities(NULL)
 	, map_surface_entities_2x(NULL)
+	, map_pixels(NULL)
+	, map_pixels_2x(NULL)
+	, prerender_thread(NULL)
 	, label(new WidgetLabel())
 	, compass(NULL)
 	, button_config(NULL)
@@ -75,6 +78,8 @@ MenuMiniMap::MenuMiniMap()
 	, clicked_config(false)
 
 {
+	SDL_AtomicSet(&prerender_done, 0);
+
 	// Load config settings
 	FileParser infile;
 	// @CLASS MenuMiniMap|Description of menus/minimap.txt
@@ -255,6 +260,9 @@ void MenuMiniMap::render(const FPoint& hero_pos) {
 	else if (settings->minimap_mode == Settings::MINIMAP_2X)
 		current_zoom = 2 * base_zoom;
 
+	if (prerender_thread && SDL_AtomicGet(&prerender_done))
+		finishPrerender();
+
 	renderMapSurface(hero_pos);
 
 	if (compass) {
@@ -265,32 +273,123 @@ void MenuMiniMap::render(const FPoint& hero_pos) {
 		button_config->render();
 }
 
+static Uint32 toARGB(const Color& color) {
+	// fully transparent colors aren't drawn at all
+	if (color.a == 0)
+		return 0;
+
+	return (static_cast<Uint32>(color.a) << 24) | (static_cast<Uint32>(color.r) << 16) | (static_cast<Uint32>(color.g) << 8) | static_cast<Uint32>(color.b);
+}
+
 void MenuMiniMap::prerender(MapCollision *collider, int map_w, int map_h) {
+	// a previous map may still be drawing
+	if (prerender_thread) {
+		SDL_WaitThread(prerender_thread, NULL);
+		prerender_thread = NULL;
+	}
+
 	map_size.x = map_w;
 	map_size.y = map_h;
 
-	if (eset->tileset.orientation == eset->tileset.TILESET_ISOMETRIC) {
-		prerenderIso(collider, &map_surface, &map_surface_entities, base_zoom);
-		prerenderIso(collider, &map_surface_2x, &map_surface_entities_2x, base_zoom*2);
+	delete map_surface;
+	map_surface = NULL;
+	delete map_surface_2x;
+	map_surface_2x = NULL;
+
+	createMapSurface(&map_surface_entities, pos.w, pos.h);
+	createMapSurface(&map_surface_entities_2x, pos.w, pos.h);
+
+	if (map_pixels)
+		SDL_FreeSurface(map_pixels);
+	if (map_pixels_2x)
+		SDL_FreeSurface(map_pixels_2x);
+	map_pixels = createMapPixels(base_zoom);
+	map_pixels_2x = createMapPixels(base_zoom*2);
+
+	tile_colors[MAP_TILE_NONE] = 0;
+	tile_colors[MAP_TILE_WALL] = toARGB(color_wall);
+	tile_colors[MAP_TILE_OBST] = toARGB(color_obst);
+
+	// the worker thread only reads this copy, so the map is free to change while it runs
+	map_tiles.resize(static_cast<size_t>(map_size.x * map_size.y));
+	for (int j = 0; j < map_size.y; ++j) {
+		for (int i = 0; i < map_size.x; ++i) {
+			map_tiles[j * map_size.x + i] = getTileType(collider, i, j);
+		}
 	}
-	else {
-		// eset->tileset.TILESET_ORTHOGONAL
-		prerenderOrtho(collider, &map_surface, &map_surface_entities, base_zoom);
-		prerenderOrtho(collider, &map_surface_2x, &map_surface_entities_2x, base_zoom*2);
+
+	SDL_AtomicSet(&prerender_done, 0);
+	prerender_thread = SDL_CreateThread(prerenderThread, "minimap_prerender", this);
+	if (!prerender_thread) {
+		Utils::logError("MenuMiniMap: Unable to create prerender thread, drawing on the main thread. %s", SDL_GetError());
+		prerenderThread(this);
+		uploadMapSurface(&map_surface, map_pixels);
+		uploadMapSurface(&map_surface_2x, map_pixels_2x);
 	}
 }
+
+int MenuMiniMap::prerenderThread(void* data) {
+	MenuMiniMap* mini = static_cast<MenuMiniMap*>(data);
+
+	Rect bounds(0, 0, mini->map_size.x, mini->map_size.y);
+	mini->drawTiles(mini->map_pixels, mini->base_zoom, bounds);
+	mini->drawTiles(mini->map_pixels_2x, mini->base_zoom*2, bounds);
+
+	SDL_AtomicSet(&mini->prerender_done, 1);
+	return 0;
+}
+
+/**
+ * Waits for the prerender thread and uploads its result
+ * Images can only be created on the main thread
+ */
+void MenuMiniMap::finishPrerender() {
+	if (!prerender_thread)
+		return;
+
+	SDL_WaitThread(prerender_thread, NULL);
+	prerender_thread = NULL;
+
+	uploadMapSurface(&map_surface, map_pixels);
+	uploadMapSurface(&map_surface_2x, map_pixels_2x);
+}
+
 void MenuMiniMap::update(MapCollision *collider, Rect *bounds) {
-	if (eset->tileset.orientation == eset->tileset.TILESET_ISOMETRIC) {
-		updateIso(collider, &map_surface, base_zoom, bounds);
-		updateIso(collider, &map_surface_2x, base_zoom*2, bounds);
+	finishPrerender();
+
+	// bounds are given as tile coordinates, where w and h are the end points
+	Rect area;
+	area.x = std::max(bounds->x, 0);
+	area.y = std::max(bounds->y, 0);
+	area.w = std::min(bounds->w, map_size.x);
+	area.h = std::min(bounds->h, map_size.y);
+
+	if (area.x >= area.w || area.y >= area.h || map_tiles.size() != static_cast<size_t>(map_size.x * map_size.y))
+		return;
+
+	for (int j = area.y; j < area.h; ++j) {
+		for (int i = area.x; i < area.w; ++i) {
+			map_tiles[j * map_size.x + i] = getTileType(collider, i, j);
+		}
 	}
-	else {
-		// eset->tileset.TILESET_ORTHOGONAL
-		updateOrtho(collider, &map_surface, base_zoom, bounds);
-		updateOrtho(collider, &map_surface_2x, base_zoom*2, bounds);
+
+	SDL_Surface* pixels[2] = {map_pixels, map_pixels_2x};
+	Sprite* surfaces[2] = {map_surface, map_surface_2x};
+	int zoom[2] = {base_zoom, base_zoom*2};
+
+	for (int i = 0; i < 2; ++i) {
+		if (!pixels[i])
+			continue;
+
+		drawTiles(pixels[i], zoom[i], area);
+
+		Rect pixel_area = getPixelArea(pixels[i], zoom[i], area);
+		if (surfaces[i] && pixel_area.w > 0 && pixel_area.h > 0)
+			surfaces[i]->getGraphics()->copyFromSurface(pixels[i], pixel_area);
 	}
 }
 
+
 void MenuMiniMap::renderMapSurface(const FPoint& hero_pos) {
 
 	Point hero_offset;
@@ -348,150 +447,141 @@ void MenuMiniMap::renderMapSurface(const FPoint& hero_pos) {
 	}
 }
 
-void MenuMiniMap::prerenderOrtho(MapCollision *collider, Sprite** tile_surface, Sprite** entity_surface, int zoom) {
+SDL_Surface* MenuMiniMap::createMapPixels(int zoom) {
 	int surface_size = std::max(map_size.x + zoom, map_size.y + zoom) * zoom;
-	createMapSurface(tile_surface, surface_size, surface_size);
-	createMapSurface(entity_surface, pos.w, pos.h);
+	if (eset->tileset.orientation == eset->tileset.TILESET_ISOMETRIC)
+		surface_size *= 2;
 
-	if (!(*tile_surface))
-		return;
+	// new surfaces are cleared to transparent
+	SDL_Surface* surface = SDL_CreateRGBSurfaceWithFormat(0, surface_size, surface_size, 32, SDL_PIXELFORMAT_ARGB8888);
+	if (!surface)
+		Utils::logError("MenuMiniMap: Unable to create map surface. %s", SDL_GetError());
 
-	Rect bounds(0, 0, map_size.x, map_size.y);
-	updateOrtho(collider, tile_surface, zoom, &bounds);
+	return surface;
 }
 
-void MenuMiniMap::updateOrtho(MapCollision *collider, Sprite** tile_surface, int zoom, Rect *bounds) {
+void MenuMiniMap::uploadMapSurface(Sprite** tile_surface, SDL_Surface* pixels) {
+	delete *tile_surface;
+	*tile_surface = NULL;
 
-	if (!(*tile_surface))
+	if (!pixels)
 		return;
 
-	Image* target_img = (*tile_surface)->getGraphics();
-
-	Color draw_color;
-
-	if (bounds->x == 0 && bounds->y == 0 && bounds->w == map_size.x && bounds->h == map_size.y) {
-		target_img->beginPixelBatch();
+	Image *graphics = render_device->createImageFromSurface(pixels);
+	if (graphics) {
+		*tile_surface = graphics->createSprite();
+		graphics->unref();
 	}
-	else {
-		Point hero(pc->stats.pos);
-
-		Rect clip;
-		clip.x = (zoom * hero.x) - pos.w/2;
-		clip.y = (zoom * hero.y) - pos.h/2;
-		clip.w = pos.w;
-		clip.h = pos.h;
+}
 
-		if (clip.x<0) clip.x=0;
-		if (clip.y<0) clip.y=0;
-		if (clip.x + clip.w > target_img->getWidth()) clip.w = target_img->getWidth() - clip.x;
-		if (clip.y + clip.h > target_img->getHeight()) clip.h = target_img->getHeight() - clip.y;
+unsigned char MenuMiniMap::getTileType(MapCollision *collider, int x, int y) {
+	// fog of war
+	if (eset->misc.fogofwar > 0 && mapr->layers[fow->dark_layer_id][x][y] != 0)
+		return MAP_TILE_NONE;
 
-		target_img->beginPixelBatch(clip);
-	}
+	int tile_type = collider->colmap[x][y];
+	if (tile_type == MapCollision::BLOCKS_ALL || tile_type == MapCollision::MAP_ONLY)
+		return MAP_TILE_WALL;
+	else if (tile_type == MapCollision::BLOCKS_MOVEMENT || tile_type == MapCollision::MAP_ONLY_ALT)
+		return MAP_TILE_OBST;
 
-	for (int i=bounds->x; i<bounds->w; i++) {
-		for (int j=bounds->y; j<bounds->h; j++) {
-			bool draw_tile = true;
-			int tile_type = collider->colmap[i][j];
+	return MAP_TILE_NONE;
+}
 
-			if (tile_type == 1 || tile_type == 5) draw_color = color_wall;
-			else if (tile_type == 2 || tile_type == 6) draw_color = color_obst;
-			else draw_tile = false;
+/**
+ * Redraws the tiles within bounds (w and h are end points) from map_tiles
+ * Tiles without a color are cleared, so removed walls disappear too
+ */
+void MenuMiniMap::drawTiles(SDL_Surface* surface, int zoom, const Rect& bounds) {
+	if (!surface)
+		return;
 
-			if (eset->misc.fogofwar > 0) {
-				tile_type = mapr->layers[fow->dark_layer_id][i][j];
-				if (tile_type != 0) draw_tile = false;
-			}
+	if (SDL_MUSTLOCK(surface))
+		SDL_LockSurface(surface);
 
-			if (draw_tile && draw_color.a != 0) {
-				for (int l = 0; l < zoom; l++) {
-					for (int k =0; k < zoom; k++) {
-						target_img->drawPixel((zoom*i)+k-1, (zoom*j)+l-1, draw_color);
-					}
-				}
-			}
-		}
-	}
+	if (eset->tileset.orientation == eset->tileset.TILESET_ISOMETRIC)
+		drawTilesIso(surface, zoom, bounds);
+	else
+		drawTilesOrtho(surface, zoom, bounds);
 
-	target_img->endPixelBatch();
+	if (SDL_MUSTLOCK(surface))
+		SDL_UnlockSurface(surface);
 }
 
-void MenuMiniMap::prerenderIso(MapCollision *collider, Sprite** tile_surface, Sprite** entity_surface, int zoom) {
-	int surface_size = std::max(map_size.x + zoom, map_size.y + zoom) * 2 * zoom;
-	createMapSurface(tile_surface, surface_size, surface_size);
-	createMapSurface(entity_surface, pos.w, pos.h);
+static void fillSpan(SDL_Surface* surface, int x, int y, int w, Uint32 color) {
+	if (y < 0 || y >= surface->h)
+		return;
 
-	if (!(*tile_surface))
+	int x_end = std::min(x + w, surface->w);
+	x = std::max(x, 0);
+	if (x >= x_end)
 		return;
 
-	Rect bounds(0, 0, map_size.x, map_size.y);
-	updateIso(collider, tile_surface, zoom, &bounds);
+	Uint32* row = reinterpret_cast<Uint32*>(static_cast<Uint8*>(surface->pixels) + y * surface->pitch);
+	std::fill(row + x, row + x_end, color);
 }
 
-void MenuMiniMap::updateIso(MapCollision *collider, Sprite** tile_surface, int zoom, Rect *bounds) {
-
-	if (!(*tile_surface))
-		return;
+void MenuMiniMap::drawTilesOrtho(SDL_Surface* surface, int zoom, const Rect& bounds) {
+	// each tile is a zoom*zoom square, offset by one pixel
+	for (int j = bounds.y; j < bounds.h; ++j) {
+		const unsigned char* tiles = &map_tiles[j * map_size.x];
 
-	Color draw_color;
-	int tile_type;
+		for (int l = 0; l < zoom; ++l) {
+			int y = (zoom * j) + l - 1;
+			for (int i = bounds.x; i < bounds.w; ++i) {
+				fillSpan(surface, (zoom * i) - 1, y, zoom, tile_colors[tiles[i]]);
+			}
+		}
+	}
+}
 
-	Point ent_pos;
-	Image* target_img = (*tile_surface)->getGraphics();
+void MenuMiniMap::drawTilesIso(SDL_Surface* surface, int zoom, const Rect& bounds) {
+	// each tile is a (zoom*2)*zoom rectangle; neighbouring tiles never overlap
+	int max_size = std::max(map_size.x, map_size.y);
 
-	if (bounds->x == 0 && bounds->y == 0 && bounds->w == map_size.x && bounds->h == map_size.y) {
-		target_img->beginPixelBatch();
-	}
-	else {
-		Point hero(pc->stats.pos);
-		Point hero_offset;
-		hero_offset.x = hero.x - hero.y + std::max(map_size.x, map_size.y);
-		hero_offset.y = hero.x + hero.y;
-
-		Rect clip;
-		clip.x = (zoom * hero_offset.x) - pos.w/2;
-		clip.y = (zoom * hero_offset.y) - pos.h/2;
-		clip.w = pos.w;
-		clip.h = pos.h;
-
-		if (clip.x<0) clip.x=0;
-		if (clip.y<0) clip.y=0;
-		if (clip.x + clip.w > target_img->getWidth()) clip.w = target_img->getWidth() - clip.x;
-		if (clip.y + clip.h > target_img->getHeight()) clip.h = target_img->getHeight() - clip.y;
-
-		target_img->beginPixelBatch(clip);
-	}
-
-	for (int i=bounds->x; i<bounds->w; i++) {
-		for (int j=bounds->y; j<bounds->h; j++) {
-			tile_type = collider->colmap[i][j];
-			bool draw_tile = true;
-
-			if (tile_type == 1 || tile_type == 5) draw_color = color_wall;
-			else if (tile_type == 2 || tile_type == 6) draw_color = color_obst;
-			else draw_tile = false;
-
-			// fog of war
-			if (eset->misc.fogofwar > 0) {
-				tile_type = mapr->layers[fow->dark_layer_id][i][j];
-				if (tile_type != 0) draw_tile = false;
-			}
+	for (int j = bounds.y; j < bounds.h; ++j) {
+		const unsigned char* tiles = &map_tiles[j * map_size.x];
 
-			if (draw_tile) {
-				ent_pos.x = zoom*(i - j + std::max(map_size.x, map_size.y));
-				ent_pos.y = zoom*(i + j) - 1;
+		for (int i = bounds.x; i < bounds.w; ++i) {
+			Uint32 color = tile_colors[tiles[i]];
+			int x = zoom * (i - j + max_size) - zoom;
+			int y = zoom * (i + j) - 1;
 
-				for (int l = 0; l < zoom; l++) {
-					for (int k = 0; k < zoom; k++) {
-						target_img->drawPixel(ent_pos.x+k, ent_pos.y+l, draw_color);
-						target_img->drawPixel(ent_pos.x+k-zoom, ent_pos.y+l, draw_color);
-					}
-				}
+			for (int l = 0; l < zoom; ++l) {
+				fillSpan(surface, x, y + l, zoom * 2, color);
 			}
 		}
 	}
+}
 
-	target_img->endPixelBatch();
+/**
+ * Returns the area of the surface covered by the tiles within bounds, clipped to the surface
+ */
+Rect MenuMiniMap::getPixelArea(SDL_Surface* surface, int zoom, const Rect& bounds) {
+	Rect area;
+	int x_end, y_end;
+
+	if (eset->tileset.orientation == eset->tileset.TILESET_ISOMETRIC) {
+		int max_size = std::max(map_size.x, map_size.y);
+		area.x = zoom * (bounds.x - (bounds.h - 1) + max_size) - zoom;
+		area.y = zoom * (bounds.x + bounds.y) - 1;
+		x_end = zoom * ((bounds.w - 1) - bounds.y + max_size) + zoom;
+		y_end = zoom * ((bounds.w - 1) + (bounds.h - 1)) - 1 + zoom;
+	}
+	else {
+		// eset->tileset.TILESET_ORTHOGONAL
+		area.x = (zoom * bounds.x) - 1;
+		area.y = (zoom * bounds.y) - 1;
+		x_end = (zoom * bounds.w) - 1;
+		y_end = (zoom * bounds.h) - 1;
+	}
+
+	area.x = std::max(area.x, 0);
+	area.y = std::max(area.y, 0);
+	area.w = std::min(x_end, surface->w) - area.x;
+	area.h = std::min(y_end, surface->h) - area.y;
+
+	return area;
 }
 
 void MenuMiniMap::renderEntitiesOrtho(Sprite* entity_surface, int zoom, const Point& entity_offset) {
@@ -618,6 +708,13 @@ void MenuMiniMap::fillEntities() {
 }
 
 MenuMiniMap::~MenuMiniMap() {
+	if (prerender_thread)
+		SDL_WaitThread(prerender_thread, NULL);
+	if (map_pixels)
+		SDL_FreeSurface(map_pixels);
+	if (map_pixels_2x)
+		SDL_FreeSurface(map_pixels_2x);
+
 	delete map_surface;
 	delete map_surface_2x;
 	delete map_surface_entities;
@@ -50,6 +50,13 @@ private:
 		TILE_ALLY = 5
 	};
 
+	enum {
+		MAP_TILE_NONE = 0,
+		MAP_TILE_WALL = 1,
+		MAP_TILE_OBST = 2,
+		MAP_TILE_COUNT = 3
+	};
+
 	Color color_wall;
 	Color color_obst;
 	Color color_hero;
@@ -64,6 +71,21 @@ private:
 	Sprite *map_surface_entities_2x;
 	Point map_size;
 
+	// ARGB8888 copies of map_surface and map_surface_2x
+	// tiles are drawn here first, then only the changed area is uploaded to the map surface
+	SDL_Surface *map_pixels;
+	SDL_Surface *map_pixels_2x;
+
+	// the MAP_TILE_* type of every map tile, with fog of war applied, stored row by row
+	std::vector<unsigned char> map_tiles;
+
+	// ARGB8888 color of each MAP_TILE_* type; 0 means the tile isn't drawn
+	Uint32 tile_colors[MAP_TILE_COUNT];
+
+	// the full map is drawn to map_pixels on a worker thread after loading
+	SDL_Thread *prerender_thread;
+	SDL_atomic_t prerender_done;
+
 	Rect pos;
 	WidgetLabel *label;
 	Sprite *compass;
@@ -79,10 +101,15 @@ private:
 
 	void createMapSurface(Sprite** target_surface, int w, int h);
 	void renderMapSurface(const FPoint& hero_pos);
-	void prerenderOrtho(MapCollision *collider, Sprite** tile_surface, Sprite** entity_surface, int zoom);
-	void prerenderIso(MapCollision *collider, Sprite** tile_surface, Sprite** entity_surface, int zoom);
-	void updateIso(MapCollision *collider, Sprite** tile_surface, int zoom, Rect *bounds);
-	void updateOrtho(MapCollision *collider, Sprite** tile_surface, int zoom, Rect *bounds);
+	SDL_Surface* createMapPixels(int zoom);
+	unsigned char getTileType(MapCollision *collider, int x, int y);
+	void drawTiles(SDL_Surface* surface, int zoom, const Rect& bounds);
+	void drawTilesOrtho(SDL_Surface* surface, int zoom, const Rect& bounds);
+	void drawTilesIso(SDL_Surface* surface, int zoom, const Rect& bounds);
+	Rect getPixelArea(SDL_Surface* surface, int zoom, const Rect& bounds);
+	void uploadMapSurface(Sprite** tile_surface, SDL_Surface* pixels);
+	void finishPrerender();
+	static int prerenderThread(void* data);
 	void renderEntitiesOrtho(Sprite* entity_surface, int zoom, const Point& entity_offset);
 	void renderEntitiesIso(Sprite* entity_surface, int zoom, const Point& entity_offset);
 	void clearEntities();
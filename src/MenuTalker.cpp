@@ -421,7 +421,7 @@ void MenuTalker::setHero(StatBlock &stats) {
 	if (stats.gfx_portrait == "") return;
 
 	Image *graphics;
-	graphics = render_device->loadImage(stats.gfx_portrait, RenderDevice::ERROR_NORMAL);
+	graphics = render_device->loadImageAsync(stats.gfx_portrait, RenderDevice::ERROR_NORMAL);
 	if (graphics) {
 		portrait = graphics->createSprite();
 		graphics->unref();
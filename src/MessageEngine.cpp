@@ -104,14 +104,17 @@ MessageEngine::MessageEngine() {
  * We also use this where possible for engine strings, since it should be more efficient than rebuilding the string as getv() does.
  */
 std::string MessageEngine::get(const std::string& key) {
-	std::string message = messages[key];
+	// find() doesn't insert missing keys, so lookups are safe while loaders run on worker threads
+	std::map<std::string, std::string>::const_iterator it = messages.find(key);
+	std::string message = (it != messages.end()) ? it->second : "";
 	if (message == "") message = key;
 	return unescape(message);
 }
 
 // NOTE: key is not passed by reference because doing so would result in undefined behavior when using va_start()
 std::string MessageEngine::getv(const std::string key, ...) {
-	std::string message = messages[key];
+	std::map<std::string, std::string>::const_iterator it = messages.find(key);
+	std::string message = (it != messages.end()) ? it->second : "";
 	if (message == "") message = key;
 
 	va_list args;
@@ -18,6 +18,7 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 
 #include "CommonIncludes.h"
 #include "ModManager.h"
+#include "ModPack.h"
 #include "Platform.h"
 #include "Settings.h"
 #include "SharedResources.h"
@@ -26,6 +27,7 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 #include "Version.h"
 
 #include <cassert>
+#include <unordered_set>
 
 Mod::Mod()
 	: is_game_mod(false)
@@ -115,11 +117,18 @@ std::string Mod::getLocaleDescription(const std::string& lang) {
 
 const std::string ModManager::FALLBACK_MOD = "default";
 const std::string ModManager::FALLBACK_GAME = "default";
+const std::string ModManager::PACK_EXTENSION = ".pack";
+
+/**
+ * Files in a directory that list() returns when given that directory
+ */
+static bool isListedFile(const std::string& name) {
+	return name.length() > 3 && name.compare(name.length() - 3, 3, "txt") == 0;
+}
 
 ModManager::ModManager(const std::vector<std::string> *_cmd_line_mods)
 	: cmd_line_mods(_cmd_line_mods)
 {
-	loc_cache.clear();
 	mod_dirs.clear();
 	mod_list.clear();
 	setPaths();
@@ -128,6 +137,20 @@ ModManager::ModManager(const std::vector<std::string> *_cmd_line_mods)
 	Filesystem::getDirList(settings->path_data + "mods", mod_dirs_other);
 	Filesystem::getDirList(settings->path_user + "mods", mod_dirs_other);
 
+	// mods can also be shipped as a single pack file
+	std::vector<std::string> pack_files;
+	Filesystem::getFileList(settings->path_data + "mods", PACK_EXTENSION, pack_files);
+	Filesystem::getFileList(settings->path_user + "mods", PACK_EXTENSION, pack_files);
+
+	for (size_t i = 0; i < pack_files.size(); ++i) {
+		std::string pack_name = pack_files[i].substr(0, pack_files[i].length() - PACK_EXTENSION.length());
+		size_t sep = pack_name.find_last_of("/\\");
+		if (sep != std::string::npos)
+			pack_name = pack_name.substr(sep + 1);
+		if (!pack_name.empty())
+			mod_dirs_other.push_back(pack_name);
+	}
+
 	for (unsigned i=0; i<mod_dirs_other.size(); ++i) {
 		if (find(mod_dirs.begin(), mod_dirs.end(), mod_dirs_other[i]) == mod_dirs.end())
 			mod_dirs.push_back(mod_dirs_other[i]);
@@ -135,6 +158,7 @@ ModManager::ModManager(const std::vector<std::string> *_cmd_line_mods)
 
 	loadModList();
 	applyDepends();
+	buildIndex();
 
 	std::string active_mods_str = "Active mods: ";
 	for (size_t i = 0; i < mod_list.size(); ++i) {
@@ -232,81 +256,312 @@ void ModManager::loadModList() {
 }
 
 /**
- * Find the location (mod file name) for this data file.
- * Use private loc_cache to prevent excessive disk I/O
+ * Converts a relative data path to the form used as a key in the index
+ * Separators are unified and "." / ".." are resolved. Platforms with
+ * case-insensitive filesystems also ignore case here, like fopen() would.
  */
-std::string ModManager::locate(const std::string& _filename) {
-	std::string filename = Filesystem::convertSlashes(_filename);
+std::string ModManager::getIndexKey(const std::string& path) {
+	std::vector<std::string> parts;
+	std::string part;
+
+	for (size_t i = 0; i <= path.length(); ++i) {
+		if (i == path.length() || path[i] == '/' || path[i] == '\\') {
+			if (part == "..") {
+				if (!parts.empty())
+					parts.pop_back();
+			}
+			else if (!part.empty() && part != ".") {
+				parts.push_back(part);
+			}
+			part.clear();
+		}
+		else {
+#if defined(_WIN32) || defined(__APPLE__)
+			part += static_cast<char>(tolower(static_cast<unsigned char>(path[i])));
+#else
+			part += path[i];
+#endif
+		}
+	}
 
-	// if we have this location already cached, return it
-	if (loc_cache.find(filename) != loc_cache.end()) {
-		return loc_cache[filename];
+	std::string key;
+	for (size_t i = 0; i < parts.size(); ++i) {
+		if (i > 0)
+			key += '/';
+		key += parts[i];
 	}
+	return key;
+}
+
+/**
+ * Walks every active mod directory once and records which of them provide each file and directory.
+ * The roots are stored in the same order that list() returns files in, so locate() walks them backwards.
+ */
+void ModManager::buildIndex() {
+	vfs_index.clear();
+	vfs_roots.clear();
+	vfs_mods.clear();
 
-	// search through mods for the first instance of this filename
-	std::string test_path;
+	for (size_t i = 0; i < mod_list.size(); ++i) {
+		vfs_mods.push_back(mod_list[i].name);
+
+		// packed files come first, so that loose files of the same mod override them
+		for (size_t j = mod_paths.size(); j > 0; j--) {
+			VFSRoot root;
+			root.path = Filesystem::convertSlashes(mod_paths[j-1] + "mods/" + mod_list[i].name + PACK_EXTENSION);
+			root.pack = ModPack::get(root.path);
+			if (!root.pack)
+				continue;
 
-	for (size_t i = mod_list.size(); i > 0; i--) {
-		for (size_t j = 0; j < mod_paths.size(); j++) {
-			test_path = Filesystem::convertSlashes(mod_paths[j] + "mods/" + mod_list[i-1].name + "/" + filename);
-			if (Filesystem::fileExists(test_path)) {
-				loc_cache[filename] = test_path;
-				return test_path;
+			vfs_roots.push_back(root);
+			indexPack(vfs_roots.size() - 1);
+		}
+
+		for (size_t j = mod_paths.size(); j > 0; j--) {
+			VFSRoot root;
+			root.path = mod_paths[j-1] + "mods/" + mod_list[i].name;
+			if (!Filesystem::isDirectory(Filesystem::convertSlashes(root.path)))
+				continue;
+
+			vfs_roots.push_back(root);
+			indexDir(vfs_roots.size() - 1, Filesystem::convertSlashes(root.path), "", 0);
+		}
+	}
+
+	Utils::logInfo("ModManager: Indexed %u paths in %u mod directories.", static_cast<unsigned>(vfs_index.size()), static_cast<unsigned>(vfs_roots.size()));
+}
+
+void ModManager::indexDir(size_t root, const std::string& dir, const std::string& key, int depth) {
+	// guards against symlink loops
+	const int MAX_DEPTH = 32;
+	if (depth > MAX_DEPTH) {
+		Utils::logError("ModManager: Directory nesting is too deep, skipping '%s'.", dir.c_str());
+		return;
+	}
+
+	std::vector<std::string> files;
+	std::vector<std::string> dirs;
+	if (Filesystem::getDirContents(dir, files, dirs) != 0)
+		return;
+
+	VFSSource dir_source;
+	dir_source.root = root;
+	dir_source.is_dir = true;
+
+	for (size_t i = 0; i < files.size(); ++i) {
+		VFSSource file_source;
+		file_source.root = root;
+		vfs_index[getIndexKey(key + "/" + files[i])].push_back(file_source);
+
+		if (isListedFile(files[i]))
+			dir_source.txt_files.push_back(files[i]);
+	}
+	vfs_index[key].push_back(dir_source);
+
+	for (size_t i = 0; i < dirs.size(); ++i) {
+		indexDir(root, Filesystem::convertSlashes(dir + "/" + dirs[i]), getIndexKey(key + "/" + dirs[i]), depth + 1);
+	}
+}
+
+void ModManager::indexPack(size_t root) {
+	ModPack* pack = vfs_roots[root].pack;
+
+	// directories only exist implicitly in a pack, so collect them from the file paths
+	std::map<std::string, std::vector<std::string> > dirs;
+	dirs[""];
+
+	for (size_t i = 0; i < pack->getEntryCount(); ++i) {
+		const std::string& entry_path = pack->getEntryPath(i);
+
+		VFSSource file_source;
+		file_source.root = root;
+		file_source.pack_entry = i;
+		vfs_index[getIndexKey(entry_path)].push_back(file_source);
+
+		size_t sep = entry_path.rfind('/');
+		std::string dir_key = (sep == std::string::npos) ? "" : getIndexKey(entry_path.substr(0, sep));
+		std::string name = (sep == std::string::npos) ? entry_path : entry_path.substr(sep + 1);
+
+		if (dirs.find(dir_key) == dirs.end()) {
+			// make sure the parent directories exist as well
+			std::string parent_key = dir_key;
+			while (!parent_key.empty() && dirs.find(parent_key) == dirs.end()) {
+				dirs[parent_key];
+				size_t parent_sep = parent_key.rfind('/');
+				parent_key = (parent_sep == std::string::npos) ? "" : parent_key.substr(0, parent_sep);
 			}
 		}
+
+		if (isListedFile(name))
+			dirs[dir_key].push_back(name);
+	}
+
+	std::map<std::string, std::vector<std::string> >::iterator it;
+	for (it = dirs.begin(); it != dirs.end(); ++it) {
+		VFSSource dir_source;
+		dir_source.root = root;
+		dir_source.is_dir = true;
+		dir_source.txt_files.swap(it->second);
+		vfs_index[it->first].push_back(dir_source);
+	}
+}
+
+/**
+ * The mod list is public and the config menu edits it in place, so rebuild the index when it no longer matches
+ */
+void ModManager::checkIndex() {
+	bool changed = (vfs_mods.size() != mod_list.size());
+	for (size_t i = 0; !changed && i < mod_list.size(); ++i) {
+		changed = (vfs_mods[i] != mod_list[i].name);
+	}
+
+	if (changed)
+		buildIndex();
+}
+
+/**
+ * Find the location (mod file name) for this data file.
+ * Uses the index built from the mod directories, so there is no disk I/O here
+ */
+std::string ModManager::locate(const std::string& _filename) {
+	checkIndex();
+
+	std::string filename = Filesystem::convertSlashes(_filename);
+
+	// search through mods for the last instance of this filename
+	VFSIndex::const_iterator it = vfs_index.find(getIndexKey(filename));
+	if (it != vfs_index.end()) {
+		const std::vector<VFSSource>& sources = it->second;
+		for (size_t i = sources.size(); i > 0; i--) {
+			if (!sources[i-1].is_dir)
+				return Filesystem::convertSlashes(vfs_roots[sources[i-1].root].path + "/" + filename);
+		}
 	}
 
 	// all else failing, simply return the filename if it exists
-	test_path = Filesystem::convertSlashes(settings->path_data + filename);
+	std::string test_path = Filesystem::convertSlashes(settings->path_data + filename);
 	if (!Filesystem::fileExists(test_path))
 		test_path = "";
 
 	return test_path;
 }
 
-void amendPathToVector(const std::string &path, std::vector<std::string> &vec) {
-	if (Filesystem::pathExists(path)) {
-		if (Filesystem::isDirectory(path)) {
-			Filesystem::getFileList(path, "txt", vec);
+std::vector<std::string> ModManager::list(const std::string &path, bool full_paths) {
+	checkIndex();
+
+	std::vector<std::string> ret;
+
+	VFSIndex::const_iterator it = vfs_index.find(getIndexKey(path));
+	if (it == vfs_index.end())
+		return ret;
+
+	const std::vector<VFSSource>& sources = it->second;
+	for (size_t i = 0; i < sources.size(); ++i) {
+		const VFSSource& source = sources[i];
+
+		if (!source.is_dir) {
+			ret.push_back(full_paths ? Filesystem::convertSlashes(vfs_roots[source.root].path + "/" + path) : path);
+			continue;
 		}
-		else {
-			vec.push_back(path);
+
+		std::string dir_path = Filesystem::convertSlashes(full_paths ? vfs_roots[source.root].path + "/" + path : path);
+		for (size_t j = 0; j < source.txt_files.size(); ++j) {
+			ret.push_back(Filesystem::convertSlashes(dir_path + "/" + source.txt_files[j]));
 		}
 	}
-}
-
-std::vector<std::string> ModManager::list(const std::string &path, bool full_paths) {
-	std::vector<std::string> ret;
-	std::string test_path;
 
-	for (size_t i = 0; i < mod_list.size(); ++i) {
-		for (size_t j = mod_paths.size(); j > 0; j--) {
-			test_path = Filesystem::convertSlashes(mod_paths[j-1] + "mods/" + mod_list[i].name + "/" + path);
-			amendPathToVector(test_path, ret);
+	if (!full_paths && ret.size() > 1) {
+		// remove duplicates, keeping the last copy of each file since later mods override earlier ones
+		std::unordered_set<std::string> found;
+		std::vector<std::string> unique;
+		for (size_t i = ret.size(); i > 0; i--) {
+			if (found.insert(ret[i-1]).second)
+				unique.push_back(ret[i-1]);
 		}
+		ret.assign(unique.rbegin(), unique.rend());
 	}
 
-	// we don't need to check for duplicates if there are no paths
-	if (ret.empty()) return ret;
+	return ret;
+}
 
-	if (!full_paths) {
-		// reduce the each file path down to be relative to mods/
-		for (unsigned i=0; i<ret.size(); ++i) {
-			ret[i] = ret[i].substr(ret[i].rfind(path), ret[i].length());
-		}
+/**
+ * Checks if a path returned by locate() or list() points into one of the indexed mod packs
+ */
+bool ModManager::findPacked(const std::string& path, ModPack*& pack, size_t& entry) {
+	for (size_t i = 0; i < vfs_roots.size(); ++i) {
+		const std::string& prefix = vfs_roots[i].path;
+		if (!vfs_roots[i].pack || path.length() <= prefix.length() + 1 || path.compare(0, prefix.length(), prefix) != 0)
+			continue;
+		if (path[prefix.length()] != '/' && path[prefix.length()] != '\\')
+			continue;
 
-		// remove duplicates
-		for (unsigned i = 0; i < ret.size(); ++i) {
-			for (unsigned j = 0; j < i; ++j) {
-				if (ret[i] == ret[j]) {
-					ret.erase(ret.begin()+j);
-					break;
-				}
+		VFSIndex::const_iterator it = vfs_index.find(getIndexKey(path.substr(prefix.length() + 1)));
+		if (it == vfs_index.end())
+			return false;
+
+		const std::vector<VFSSource>& sources = it->second;
+		for (size_t j = 0; j < sources.size(); ++j) {
+			if (sources[j].root == i && !sources[j].is_dir) {
+				pack = vfs_roots[i].pack;
+				entry = sources[j].pack_entry;
+				return true;
 			}
 		}
+		return false;
 	}
+	return false;
+}
 
-	return ret;
+SDL_RWops* ModManager::openRW(const std::string& path) {
+	ModPack* pack = NULL;
+	size_t entry = 0;
+	if (findPacked(path, pack, entry))
+		return pack->openRW(entry);
+
+	return SDL_RWFromFile(path.c_str(), "rb");
+}
+
+bool ModManager::readFile(const std::string& path, std::string& data) {
+	ModPack* pack = NULL;
+	size_t entry = 0;
+	if (findPacked(path, pack, entry))
+		return pack->read(entry, data);
+
+	std::ifstream infile(path.c_str(), std::ios::in | std::ios::binary);
+	if (!infile.is_open())
+		return false;
+
+	std::stringstream contents;
+	contents << infile.rdbuf();
+	data = contents.str();
+	return true;
+}
+
+bool ModManager::getFileStamp(const std::string& path, uint64_t& size, int64_t& mtime) {
+	ModPack* pack = NULL;
+	size_t entry = 0;
+	if (findPacked(path, pack, entry)) {
+		uint64_t pack_size = 0;
+		if (!Filesystem::getFileStamp(pack->getFilename(), pack_size, mtime))
+			return false;
+		size = pack->getEntrySize(entry);
+		return true;
+	}
+
+	return Filesystem::getFileStamp(path, size, mtime);
+}
+
+/**
+ * Reads a file from a single mod in a single data path, before the index is built
+ * A loose file is preferred over the one in the mod's pack.
+ */
+bool ModManager::readModFile(const std::string& mod_path, const std::string& name, const std::string& filename, std::string& data) {
+	if (readFile(Filesystem::convertSlashes(mod_path + "mods/" + name + "/" + filename), data))
+		return true;
+
+	ModPack* pack = ModPack::get(Filesystem::convertSlashes(mod_path + "mods/" + name + PACK_EXTENSION));
+	size_t entry = 0;
+	return pack && pack->find(filename, entry) && pack->read(entry, data);
 }
 
 void ModManager::setPaths() {
@@ -325,7 +580,8 @@ void ModManager::setPaths() {
 
 Mod ModManager::loadMod(const std::string& name) {
 	Mod mod;
-	std::ifstream infile;
+	std::istringstream infile;
+	std::string file_data;
 	std::string line, key, val;
 
 	mod.name = name;
@@ -334,12 +590,12 @@ Mod ModManager::loadMod(const std::string& name) {
 
 	// @CLASS ModManager|Description of mod settings.txt
 	for (size_t i = 0; i < mod_paths.size(); ++i) {
-		std::string path = Filesystem::convertSlashes(mod_paths[i] + "mods/" + name + "/settings.txt");
-		infile.open(path.c_str(), std::ios::in);
-
-		if (infile.is_open()) {
+		file_data.clear();
+		if (readModFile(mod_paths[i], name, "settings.txt", file_data)) {
 			settings_loaded = true;
 		}
+		infile.clear();
+		infile.str(file_data);
 
 		while (infile.good()) {
 			line = Parse::getLine(infile);
@@ -410,15 +666,13 @@ Mod ModManager::loadMod(const std::string& name) {
 				Utils::logError("ModManager: Mod '%s' contains invalid key: '%s'", name.c_str(), key.c_str());
 			}
 		}
-		infile.close();
-		infile.clear();
-
-		path = Filesystem::convertSlashes(mod_paths[i] + "mods/" + name + "/engine/gameplay.txt");
-		infile.open(path.c_str(), std::ios::in);
 
-		if (infile.is_open()) {
+		file_data.clear();
+		if (readModFile(mod_paths[i], name, "engine/gameplay.txt", file_data)) {
 			gameplay_loaded = true;
 		}
+		infile.clear();
+		infile.str(file_data);
 
 		while (infile.good()) {
 			line = Parse::getLine(infile);
@@ -435,8 +689,6 @@ Mod ModManager::loadMod(const std::string& name) {
 				mod.is_game_mod = Parse::toBool(val);
 			}
 		}
-		infile.close();
-		infile.clear();
 
 		if (settings_loaded && gameplay_loaded)
 			break;
@@ -28,6 +28,9 @@ mods in priority order when loading data files.
 
 #include "CommonIncludes.h"
 
+#include <unordered_map>
+
+class ModPack;
 class Version;
 
 class Mod {
@@ -56,12 +59,50 @@ public:
 
 class ModManager {
 private:
+	// one mod directory that provides a path in the virtual filesystem index
+	class VFSSource {
+	public:
+		VFSSource()
+			: root(0)
+			, is_dir(false)
+			, pack_entry(0)
+		{}
+		size_t root; // index into vfs_roots
+		bool is_dir;
+		size_t pack_entry; // only for files in a mod pack
+		std::vector<std::string> txt_files; // only for directories, in directory order
+	};
+
+	// a mod directory, or a mod pack if pack is set
+	class VFSRoot {
+	public:
+		VFSRoot()
+			: pack(NULL)
+		{}
+		std::string path;
+		ModPack* pack;
+	};
+
+	typedef std::unordered_map<std::string, std::vector<VFSSource> > VFSIndex;
+
 	void loadModList();
 	void setPaths();
 
-	std::map<std::string,std::string> loc_cache;
+	void checkIndex();
+	void buildIndex();
+	void indexDir(size_t root, const std::string& dir, const std::string& key, int depth);
+	void indexPack(size_t root);
+	bool findPacked(const std::string& path, ModPack*& pack, size_t& entry);
+	bool readModFile(const std::string& mod_path, const std::string& name, const std::string& filename, std::string& data);
+	static std::string getIndexKey(const std::string& path);
+
 	std::vector<std::string> mod_paths;
 
+	// relative path -> mod directories that contain it, in the same order as list()
+	VFSIndex vfs_index;
+	std::vector<VFSRoot> vfs_roots;
+	std::vector<std::string> vfs_mods;
+
 	const std::vector<std::string> *cmd_line_mods;
 
 public:
@@ -69,6 +110,7 @@ public:
 
 	static const std::string FALLBACK_MOD;
 	static const std::string FALLBACK_GAME;
+	static const std::string PACK_EXTENSION;
 
 	explicit ModManager(const std::vector<std::string> *_cmd_line_mods);
 	~ModManager();
@@ -91,6 +133,15 @@ public:
 	// that can be passed to locate() later
 	std::vector<std::string> list(const std::string& path, bool full_paths);
 
+	// Opens a file returned by locate() or list(). These may point into a mod pack,
+	// so they should be read through here rather than opened directly.
+	SDL_RWops* openRW(const std::string& path);
+	bool readFile(const std::string& path, std::string& data);
+
+	// Gets the size and modification time of a file returned by locate() or list().
+	// Packed files use the time of their pack.
+	bool getFileStamp(const std::string& path, uint64_t& size, int64_t& mtime);
+
 	std::vector<std::string> mod_dirs;
 	std::vector<Mod> mod_list;
 };
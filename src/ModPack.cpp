@@ -0,0 +1,189 @@
+/*
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+/**
+ * class ModPack
+ */
+
+#include "ModPack.h"
+#include "UtilsFileSystem.h"
+#include "Utils.h"
+
+#include <limits.h>
+#include <string.h>
+
+std::map<std::string, ModPack*> ModPack::packs;
+
+static uint32_t readU32(const unsigned char* src) {
+	return static_cast<uint32_t>(src[0]) | (static_cast<uint32_t>(src[1]) << 8) | (static_cast<uint32_t>(src[2]) << 16) | (static_cast<uint32_t>(src[3]) << 24);
+}
+
+static uint64_t readU64(const unsigned char* src) {
+	return static_cast<uint64_t>(readU32(src)) | (static_cast<uint64_t>(readU32(src + 4)) << 32);
+}
+
+ModPack::ModPack(const std::string& _filename)
+	: filename(_filename)
+	, data(NULL)
+	, data_size(0)
+{
+}
+
+ModPack::~ModPack() {
+}
+
+ModPack* ModPack::get(const std::string& _filename) {
+	std::map<std::string, ModPack*>::iterator it = packs.find(_filename);
+	if (it != packs.end())
+		return it->second;
+
+	// failures are remembered too, so a broken pack is only reported once
+	ModPack* pack = NULL;
+	if (Filesystem::fileExists(_filename)) {
+		pack = new ModPack(_filename);
+		if (!pack->load()) {
+			delete pack;
+			pack = NULL;
+		}
+	}
+
+	packs[_filename] = pack;
+	return pack;
+}
+
+void ModPack::closeAll() {
+	std::map<std::string, ModPack*>::iterator it;
+	for (it = packs.begin(); it != packs.end(); ++it) {
+		delete it->second;
+	}
+	packs.clear();
+}
+
+bool ModPack::load() {
+	if (!file.open(filename)) {
+		Utils::logError("ModPack: Unable to read '%s'.", filename.c_str());
+		return false;
+	}
+	data = file.getData();
+	data_size = file.getSize();
+
+	if (!parseIndex()) {
+		Utils::logError("ModPack: '%s' is not a valid mod pack.", filename.c_str());
+		return false;
+	}
+
+	Utils::logInfo("ModPack: Loaded '%s' with %u files.", filename.c_str(), static_cast<unsigned>(entries.size()));
+	return true;
+}
+
+bool ModPack::parseIndex() {
+	if (data_size < HEADER_SIZE || memcmp(data, MAGIC, 8) != 0)
+		return false;
+
+	uint32_t version = readU32(data + 8);
+	if (version != VERSION) {
+		Utils::logError("ModPack: '%s' has version %u, but only version %u is supported.", filename.c_str(), version, VERSION);
+		return false;
+	}
+
+	uint32_t entry_count = readU32(data + 12);
+	uint64_t index_offset = readU64(data + 16);
+	uint64_t index_size = readU64(data + 24);
+	if (index_offset < HEADER_SIZE || index_offset > data_size || index_size > data_size - index_offset)
+		return false;
+
+	// every entry takes at least ENTRY_SIZE bytes of the index, so a larger count is corrupt
+	if (entry_count > index_size / ENTRY_SIZE)
+		return false;
+
+	const unsigned char* pos = data + index_offset;
+	const unsigned char* end = pos + index_size;
+
+	entries.reserve(entry_count);
+	for (uint32_t i = 0; i < entry_count; ++i) {
+		if (static_cast<size_t>(end - pos) < ENTRY_SIZE)
+			return false;
+
+		uint64_t offset = readU64(pos);
+		uint64_t size = readU64(pos + 8);
+		uint32_t compression = readU32(pos + 16);
+		uint32_t path_length = readU32(pos + 20);
+		pos += ENTRY_SIZE;
+
+		if (path_length == 0 || path_length > static_cast<size_t>(end - pos))
+			return false;
+
+		Entry entry;
+		entry.path.assign(reinterpret_cast<const char*>(pos), path_length);
+		pos += path_length;
+
+		// file data lives between the header and the index, and SDL_RWFromConstMem() takes an int
+		if (offset < HEADER_SIZE || offset > index_offset || size > index_offset - offset || size > INT_MAX)
+			return false;
+
+		if (compression != COMPRESSION_NONE) {
+			Utils::logError("ModPack: '%s' in '%s' uses unsupported compression %u, skipping.", entry.path.c_str(), filename.c_str(), compression);
+			continue;
+		}
+
+		entry.offset = static_cast<size_t>(offset);
+		entry.size = static_cast<size_t>(size);
+
+		entry_lookup[entry.path] = entries.size();
+		entries.push_back(entry);
+	}
+
+	return true;
+}
+
+const std::string& ModPack::getFilename() const {
+	return filename;
+}
+
+size_t ModPack::getEntryCount() const {
+	return entries.size();
+}
+
+const std::string& ModPack::getEntryPath(size_t index) const {
+	return entries[index].path;
+}
+
+size_t ModPack::getEntrySize(size_t index) const {
+	return entries[index].size;
+}
+
+bool ModPack::find(const std::string& entry_path, size_t& index) const {
+	std::unordered_map<std::string, size_t>::const_iterator it = entry_lookup.find(entry_path);
+	if (it == entry_lookup.end())
+		return false;
+
+	index = it->second;
+	return true;
+}
+
+SDL_RWops* ModPack::openRW(size_t index) const {
+	if (index >= entries.size())
+		return NULL;
+
+	return SDL_RWFromConstMem(data + entries[index].offset, static_cast<int>(entries[index].size));
+}
+
+bool ModPack::read(size_t index, std::string& _data) const {
+	if (index >= entries.size())
+		return false;
+
+	_data.assign(reinterpret_cast<const char*>(data + entries[index].offset), entries[index].size);
+	return true;
+}
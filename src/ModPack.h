@@ -0,0 +1,95 @@
+/*
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+/**
+ * class ModPack
+ *
+ * A whole mod stored in a single file (mods/<name>.pack), created with the flare-pack tool.
+ * The file is memory-mapped once and the files inside it are handed out as SDL_RWops
+ * that read straight from the mapping, so loading an asset doesn't touch the filesystem.
+ *
+ * Layout, with all integers stored little-endian:
+ *   header: "FLAREPAK", u32 version, u32 entry count, u64 index offset, u64 index size
+ *   data:   the contents of each file, starting on a DATA_ALIGNMENT boundary
+ *   index:  per file u64 offset, u64 size, u32 compression, u32 path length, path
+ *
+ * Paths are relative to the mod directory and always use '/' as the separator.
+ */
+
+#ifndef MOD_PACK_H
+#define MOD_PACK_H
+
+#include "CommonIncludes.h"
+#include "MappedFile.h"
+
+#include <stdint.h>
+#include <unordered_map>
+
+class ModPack {
+public:
+	static constexpr char MAGIC[9] = "FLAREPAK";
+	static const uint32_t VERSION = 1;
+	static const size_t HEADER_SIZE = 32;
+	static const size_t ENTRY_SIZE = 24; // fixed part of an index entry, followed by the path
+	static const size_t DATA_ALIGNMENT = 16;
+
+	enum {
+		COMPRESSION_NONE = 0
+	};
+
+	// returns the pack at the given path, which stays open until closeAll(). NULL if it doesn't exist or is invalid
+	static ModPack* get(const std::string& filename);
+	static void closeAll();
+
+	const std::string& getFilename() const;
+	size_t getEntryCount() const;
+	const std::string& getEntryPath(size_t index) const;
+	size_t getEntrySize(size_t index) const;
+	bool find(const std::string& entry_path, size_t& index) const;
+
+	// the returned SDL_RWops reads from the mapping, so it may outlive the caller but not closeAll()
+	SDL_RWops* openRW(size_t index) const;
+	bool read(size_t index, std::string& data) const;
+
+private:
+	class Entry {
+	public:
+		Entry()
+			: offset(0)
+			, size(0)
+		{}
+		size_t offset;
+		size_t size;
+		std::string path;
+	};
+
+	explicit ModPack(const std::string& _filename);
+	~ModPack();
+
+	bool load();
+	bool parseIndex();
+
+	std::string filename;
+	std::vector<Entry> entries;
+	std::unordered_map<std::string, size_t> entry_lookup;
+
+	MappedFile file;
+	const unsigned char* data;
+	size_t data_size;
+
+	static std::map<std::string, ModPack*> packs;
+};
+
+#endif
@@ -0,0 +1,187 @@
+/*
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+/**
+ * flare-pack
+ *
+ * Command line tool that turns a mod directory into a single ModPack file:
+ *   flare-pack <mod directory> [output file]
+ * The output defaults to the directory name with ".pack" appended, which is where
+ * the engine looks for it. Files are sorted by path so the output is reproducible.
+ */
+
+// this is a plain command line program, don't let SDL replace main()
+#define SDL_MAIN_HANDLED
+
+#include "ModPack.h"
+
+#include <dirent.h>
+#include <limits.h>
+#include <stdio.h>
+#include <sys/stat.h>
+
+static const int MAX_DEPTH = 32;
+
+static void appendU32(std::vector<unsigned char>& out, uint32_t value) {
+	for (int i = 0; i < 4; ++i) {
+		out.push_back(static_cast<unsigned char>(value >> (i * 8)));
+	}
+}
+
+static void appendU64(std::vector<unsigned char>& out, uint64_t value) {
+	appendU32(out, static_cast<uint32_t>(value));
+	appendU32(out, static_cast<uint32_t>(value >> 32));
+}
+
+static bool collectFiles(const std::string& dir, const std::string& rel_dir, std::vector<std::string>& files, int depth) {
+	if (depth > MAX_DEPTH) {
+		fprintf(stderr, "flare-pack: Directory nesting is too deep at '%s'\n", dir.c_str());
+		return false;
+	}
+
+	DIR* dp = opendir(dir.c_str());
+	if (!dp) {
+		fprintf(stderr, "flare-pack: Unable to open directory '%s'\n", dir.c_str());
+		return false;
+	}
+
+	bool ok = true;
+	struct dirent* dirp;
+	while (ok && (dirp = readdir(dp)) != NULL) {
+		std::string name = dirp->d_name;
+		if (name == "." || name == "..")
+			continue;
+
+		std::string path = dir + "/" + name;
+		std::string rel_path = rel_dir.empty() ? name : rel_dir + "/" + name;
+
+		struct stat st;
+		if (stat(path.c_str(), &st) == -1)
+			continue;
+
+		if (S_ISDIR(st.st_mode))
+			ok = collectFiles(path, rel_path, files, depth + 1);
+		else
+			files.push_back(rel_path);
+	}
+	closedir(dp);
+
+	return ok;
+}
+
+static bool readFile(const std::string& path, std::vector<unsigned char>& contents) {
+	FILE* file = fopen(path.c_str(), "rb");
+	if (!file)
+		return false;
+
+	contents.clear();
+	unsigned char chunk[65536];
+	size_t count;
+	while ((count = fread(chunk, 1, sizeof(chunk), file)) > 0) {
+		contents.insert(contents.end(), chunk, chunk + count);
+	}
+
+	bool ok = (ferror(file) == 0);
+	fclose(file);
+	return ok;
+}
+
+static bool writePack(const std::string& src_dir, const std::string& dest_file) {
+	std::vector<std::string> files;
+	if (!collectFiles(src_dir, "", files, 0))
+		return false;
+
+	std::sort(files.begin(), files.end());
+
+	FILE* out = fopen(dest_file.c_str(), "wb");
+	if (!out) {
+		fprintf(stderr, "flare-pack: Unable to create '%s'\n", dest_file.c_str());
+		return false;
+	}
+
+	// the header is written last, once the index position is known
+	std::vector<unsigned char> padding(ModPack::HEADER_SIZE, 0);
+	bool ok = (fwrite(&padding[0], 1, padding.size(), out) == padding.size());
+	uint64_t offset = ModPack::HEADER_SIZE;
+
+	std::vector<unsigned char> index;
+	std::vector<unsigned char> contents;
+	for (size_t i = 0; ok && i < files.size(); ++i) {
+		if (!readFile(src_dir + "/" + files[i], contents)) {
+			fprintf(stderr, "flare-pack: Unable to read '%s'\n", files[i].c_str());
+			ok = false;
+			break;
+		}
+		if (contents.size() > INT_MAX) {
+			fprintf(stderr, "flare-pack: '%s' is too large\n", files[i].c_str());
+			ok = false;
+			break;
+		}
+
+		size_t align = static_cast<size_t>(offset % ModPack::DATA_ALIGNMENT);
+		if (align != 0) {
+			size_t pad = ModPack::DATA_ALIGNMENT - align;
+			ok = (fwrite(&padding[0], 1, pad, out) == pad);
+			offset += pad;
+		}
+
+		if (!contents.empty())
+			ok = ok && (fwrite(&contents[0], 1, contents.size(), out) == contents.size());
+
+		appendU64(index, offset);
+		appendU64(index, contents.size());
+		appendU32(index, ModPack::COMPRESSION_NONE);
+		appendU32(index, static_cast<uint32_t>(files[i].length()));
+		index.insert(index.end(), files[i].begin(), files[i].end());
+
+		offset += contents.size();
+	}
+
+	if (ok && !index.empty())
+		ok = (fwrite(&index[0], 1, index.size(), out) == index.size());
+
+	std::vector<unsigned char> header(ModPack::MAGIC, ModPack::MAGIC + 8);
+	appendU32(header, ModPack::VERSION);
+	appendU32(header, static_cast<uint32_t>(files.size()));
+	appendU64(header, offset);
+	appendU64(header, index.size());
+
+	ok = ok && fseek(out, 0, SEEK_SET) == 0 && fwrite(&header[0], 1, header.size(), out) == header.size();
+	ok = (fclose(out) == 0) && ok;
+
+	if (!ok) {
+		fprintf(stderr, "flare-pack: Failed to write '%s'\n", dest_file.c_str());
+		remove(dest_file.c_str());
+		return false;
+	}
+
+	printf("flare-pack: Packed %u files into '%s'\n", static_cast<unsigned>(files.size()), dest_file.c_str());
+	return true;
+}
+
+int main(int argc, char* argv[]) {
+	if (argc < 2 || argc > 3) {
+		fprintf(stderr, "Usage: flare-pack <mod directory> [output file]\n");
+		return 1;
+	}
+
+	std::string src_dir = argv[1];
+	while (src_dir.length() > 1 && (src_dir.back() == '/' || src_dir.back() == '\\'))
+		src_dir.pop_back();
+
+	std::string dest_file = (argc == 3) ? argv[2] : src_dir + ".pack";
+
+	return writePack(src_dir, dest_file) ? 0 : 1;
+}
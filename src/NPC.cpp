@@ -315,7 +315,7 @@ void NPC::loadGraphics() {
 	for (size_t i = 0; i < portrait_filenames.size(); ++i) {
 		if (!portrait_filenames[i].empty()) {
 			Image *graphics;
-			graphics = render_device->loadImage(portrait_filenames[i], RenderDevice::ERROR_NORMAL);
+			graphics = render_device->loadImageAsync(portrait_filenames[i], RenderDevice::ERROR_NORMAL);
 			if (graphics) {
 				portraits[i] = graphics->createSprite();
 				graphics->unref();
@@ -0,0 +1,295 @@
+/*
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+#include <SDL_image.h>
+
+#include <stdio.h>
+#include <string.h>
+
+#include "CursorManager.h"
+#include "EngineSettings.h"
+#include "IconManager.h"
+#include "InputState.h"
+#include "ModManager.h"
+#include "Profiler.h"
+#include "SharedResources.h"
+#include "Settings.h"
+
+#include "NullRenderDevice.h"
+#include "SDLFontEngine.h"
+
+NullImage::NullImage(RenderDevice *_device, int _width, int _height)
+	: Image(_device)
+	, width(_width)
+	, height(_height) {
+}
+
+NullImage::~NullImage() {
+}
+
+int NullImage::getWidth() const {
+	return width;
+}
+
+int NullImage::getHeight() const {
+	return height;
+}
+
+void NullImage::fillWithColor(const Color&) {
+}
+
+void NullImage::drawPixel(int, int, const Color&) {
+}
+
+void NullImage::drawLine(int, int, int, int, const Color&) {
+}
+
+/**
+ * There are no pixels to replace
+ */
+void NullImage::copyFromSurface(SDL_Surface*, const Rect&) {
+}
+
+/**
+ * Resizes an image
+ * Deletes the original image and returns a pointer to the resized version
+ */
+Image* NullImage::resize(int _width, int _height) {
+	if (_width <= 0 || _height <= 0)
+		return NULL;
+
+	NullImage *scaled = new NullImage(device, _width, _height);
+
+	// delete the old image and return the new one
+	this->unref();
+	return scaled;
+}
+
+NullRenderDevice::NullRenderDevice() {
+	Utils::logInfo("RenderDevice: Using NullRenderDevice (headless, nothing is drawn)");
+
+	fullscreen = false;
+	hwsurface = false;
+	vsync = false;
+	texture_filter = false;
+
+	min_screen.x = eset->resolutions.min_screen_w;
+	min_screen.y = eset->resolutions.min_screen_h;
+}
+
+int NullRenderDevice::createContextInternal() {
+	if (settings->safe_video) {
+		settings->safe_video = false;
+		settings->screen_w = eset->resolutions.min_screen_w;
+		settings->screen_h = eset->resolutions.min_screen_h;
+	}
+
+	// there's no window to go fullscreen with, and vsync would make no sense
+	settings->fullscreen = false;
+	settings->vsync = false;
+
+	if (!is_initialized) {
+		Utils::logInfo("RenderDevice: Virtual window size is %dx%d", settings->screen_w, settings->screen_h);
+		is_initialized = true;
+	}
+
+	windowResize();
+
+	// load persistent resources
+	delete icons;
+	icons = new IconManager();
+	delete curs;
+	curs = new CursorManager();
+
+	return 0;
+}
+
+void NullRenderDevice::createContextError() {
+	Utils::logError("NullRenderDevice: createContext() failed");
+}
+
+int NullRenderDevice::render(Renderable&, Rect&) {
+	Profiler::addCount(Profiler::COUNTER_DRAW_CALLS);
+	return 0;
+}
+
+int NullRenderDevice::render(Sprite *r) {
+	if (r == NULL || !localToGlobal(r))
+		return -1;
+
+	Profiler::addCount(Profiler::COUNTER_DRAW_CALLS);
+	return 0;
+}
+
+int NullRenderDevice::renderToImage(Image* src_image, Rect&, Image* dest_image, Rect&) {
+	if (!src_image || !dest_image) return -1;
+
+	return 0;
+}
+
+int NullRenderDevice::renderToImageBatch(Image* src_image, const std::vector<Rect>&, Image* dest_image, const std::vector<Rect>&, const Color&) {
+	if (!src_image || !dest_image) return -1;
+
+	return 0;
+}
+
+Image* NullRenderDevice::renderTextToImage(FontStyle* font_style, const std::string& text, const Color&, bool) {
+	// the font engine still measures text with SDL_ttf, so use the same size the SDL renderers would
+	int w = 0;
+	int h = 0;
+	TTF_Font *ttfont = static_cast<SDLFontStyle *>(font_style)->ttfont;
+	if (!ttfont || TTF_SizeUTF8(ttfont, text.c_str(), &w, &h) != 0 || w <= 0 || h <= 0)
+		return NULL;
+
+	return new NullImage(this, w, h);
+}
+
+void NullRenderDevice::drawPixel(int, int, const Color&) {
+}
+
+void NullRenderDevice::drawLine(int, int, int, int, const Color&) {
+}
+
+void NullRenderDevice::drawRectangle(const Point&, const Point&, const Color&) {
+}
+
+void NullRenderDevice::blankScreen() {
+}
+
+void NullRenderDevice::commitFrame() {
+	inpt->window_resized = false;
+}
+
+void NullRenderDevice::destroyContext() {
+	RenderDevice::cacheRemoveAll();
+	reload_graphics = true;
+
+	if (icons) {
+		delete icons;
+		icons = NULL;
+	}
+	if (curs) {
+		delete curs;
+		curs = NULL;
+	}
+}
+
+void NullRenderDevice::windowResize() {
+	windowResizeInternal();
+	settings->updateScreenVars();
+}
+
+void NullRenderDevice::setBackgroundColor(Color) {
+}
+
+void NullRenderDevice::setFullscreen(bool) {
+}
+
+Image *NullRenderDevice::createImage(int width, int height) {
+	if (width <= 0 || height <= 0)
+		return NULL;
+
+	return new NullImage(this, width, height);
+}
+
+Image *NullRenderDevice::createImageFromSurface(SDL_Surface *surface) {
+	if (!surface)
+		return NULL;
+
+	return createImage(surface->w, surface->h);
+}
+
+void NullRenderDevice::setGamma(float) {
+}
+
+void NullRenderDevice::resetGamma() {
+}
+
+void NullRenderDevice::updateTitleBar() {
+}
+
+unsigned short NullRenderDevice::getRefreshRate() {
+	return 0;
+}
+
+bool NullRenderDevice::needsPixels() {
+	return false;
+}
+
+/**
+ * PNG files store their dimensions in the IHDR chunk, which always comes first.
+ * Reading that is enough for us, so the image data never needs to be decoded.
+ */
+bool NullRenderDevice::getImageSize(const std::string& path, int *w, int *h) {
+	SDL_RWops *rw = mods->openRW(path);
+	if (!rw)
+		return false;
+
+	unsigned char header[24];
+	size_t header_size = SDL_RWread(rw, header, 1, sizeof(header));
+
+	static const unsigned char png_signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+	if (header_size == sizeof(header) && memcmp(header, png_signature, 8) == 0 && memcmp(header + 12, "IHDR", 4) == 0) {
+		*w = (header[16] << 24) | (header[17] << 16) | (header[18] << 8) | header[19];
+		*h = (header[20] << 24) | (header[21] << 16) | (header[22] << 8) | header[23];
+		SDL_RWclose(rw);
+		return true;
+	}
+
+	// some other format, so let SDL_image figure it out
+	SDL_RWseek(rw, 0, RW_SEEK_SET);
+	SDL_Surface *surface = IMG_Load_RW(rw, 1);
+	if (!surface)
+		return false;
+
+	*w = surface->w;
+	*h = surface->h;
+	SDL_FreeSurface(surface);
+	return true;
+}
+
+Image *NullRenderDevice::loadImage(const std::string& filename, int error_type) {
+	// lookup image in cache
+	Image *img;
+	img = cacheLookup(filename);
+	if (img != NULL) return img;
+
+	int w = 0;
+	int h = 0;
+	if (!getImageSize(mods->locate(filename), &w, &h)) {
+		if (error_type != ERROR_NONE)
+			Utils::logError("NullRenderDevice: Couldn't load image: '%s'.", filename.c_str());
+
+		if (error_type == ERROR_EXIT) {
+			Utils::logErrorDialog("NullRenderDevice: Couldn't load image: '%s'.", filename.c_str());
+			mods->resetModConfig();
+			Utils::Exit(1);
+		}
+
+		return NULL;
+	}
+
+	NullImage *image = new NullImage(this, w, h);
+
+	// store image to cache
+	cacheStore(filename, image);
+	return image;
+}
+
+void NullRenderDevice::getWindowSize(short unsigned *screen_w, short unsigned *screen_h) {
+	// the virtual window keeps whatever size the settings ask for
+	*screen_w = settings->screen_w;
+	*screen_h = settings->screen_h;
+}
@@ -0,0 +1,89 @@
+/*
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+#ifndef NULLRENDERDEVICE_H
+#define NULLRENDERDEVICE_H
+
+#include "RenderDevice.h"
+
+/** Provide a rendering device that doesn't draw anything.
+ *
+ * Images only keep their dimensions (and the usual reference counts), so
+ * sprites, clipping and layout work the same as with the SDL renderers, but
+ * no pixels are ever decoded or drawn and no window is needed.
+ * Selected with --renderer=null, for running the game on headless machines.
+ *
+ * @class NullRenderDevice
+ * @see RenderDevice
+ */
+
+class NullImage : public Image {
+public:
+	NullImage(RenderDevice *device, int _width, int _height);
+	virtual ~NullImage();
+	int getWidth() const;
+	int getHeight() const;
+
+	void fillWithColor(const Color& color);
+	void drawPixel(int x, int y, const Color& color);
+	void drawLine(int x0, int y0, int x1, int y1, const Color& color);
+	void copyFromSurface(SDL_Surface* src, const Rect& area);
+	Image* resize(int width, int height);
+
+private:
+	int width;
+	int height;
+};
+
+class NullRenderDevice : public RenderDevice {
+public:
+
+	NullRenderDevice();
+
+	virtual int render(Renderable& r, Rect& dest);
+	virtual int render(Sprite* r);
+	virtual int renderToImage(Image* src_image, Rect& src, Image* dest_image, Rect& dest);
+	virtual int renderToImageBatch(Image* src_image, const std::vector<Rect>& src, Image* dest_image, const std::vector<Rect>& dest, const Color& color_mod);
+
+	Image* renderTextToImage(FontStyle* font_style, const std::string& text, const Color& color, bool blended);
+	void drawPixel(int x, int y, const Color& color);
+	void drawLine(int x0, int y0, int x1, int y1, const Color& color);
+	void drawRectangle(const Point& p0, const Point& p1, const Color& color);
+	void blankScreen();
+	void commitFrame();
+	void destroyContext();
+	void windowResize();
+	void setBackgroundColor(Color color);
+	void setFullscreen(bool enable_fullscreen);
+	Image *createImage(int width, int height);
+	Image *createImageFromSurface(SDL_Surface *surface);
+	void setGamma(float g);
+	void resetGamma();
+	void updateTitleBar();
+	unsigned short getRefreshRate();
+	bool needsPixels();
+
+	Image* loadImage(const std::string& filename, int error_type);
+
+protected:
+	int createContextInternal();
+	void createContextError();
+
+private:
+	void getWindowSize(short unsigned *screen_w, short unsigned *screen_h);
+	bool getImageSize(const std::string& path, int *w, int *h);
+};
+
+#endif // NULLRENDERDEVICE_H
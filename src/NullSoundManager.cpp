@@ -0,0 +1,92 @@
+/*
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+/**
+ * class NullSoundManager
+ */
+
+#include "ModManager.h"
+#include "NullSoundManager.h"
+#include "SharedResources.h"
+
+NullSoundManager::NullSoundManager()
+	: SoundManager()
+	, last_played_sid(-1)
+{
+	Utils::logInfo("SoundManager: Using NullSoundManager (audio disabled)");
+}
+
+NullSoundManager::~NullSoundManager() {
+}
+
+SoundID NullSoundManager::load(const std::string& filename, const std::string&) {
+	if (filename.empty())
+		return 0;
+
+	// same ID as SDLSoundManager would give it, so that subtitles can find it
+	return Utils::hashString(mods->locate(filename));
+}
+
+void NullSoundManager::unload(SoundID) {
+}
+
+void NullSoundManager::play(SoundID sid, const std::string&, const FPoint&, bool loop, bool) {
+	// since last_played_sid is primarily used for subtitles, it doesn't make sense to count looped sounds
+	if (!loop && sid)
+		last_played_sid = sid;
+}
+
+void NullSoundManager::pauseChannel(const std::string&) {
+}
+
+void NullSoundManager::pauseAll() {
+}
+
+void NullSoundManager::resumeAll() {
+}
+
+void NullSoundManager::setVolumeSFX(int) {
+}
+
+void NullSoundManager::loadMusic(const std::string&) {
+}
+
+void NullSoundManager::unloadMusic() {
+}
+
+void NullSoundManager::playMusic() {
+}
+
+void NullSoundManager::stopMusic() {
+}
+
+void NullSoundManager::setVolumeMusic(int) {
+}
+
+bool NullSoundManager::isPlayingMusic() {
+	return false;
+}
+
+void NullSoundManager::logic(const FPoint&) {
+}
+
+void NullSoundManager::reset() {
+}
+
+SoundID NullSoundManager::getLastPlayedSID() {
+	SoundID ret = last_played_sid;
+	last_played_sid = -1;
+	return ret;
+}
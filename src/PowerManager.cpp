@@ -44,6 +44,7 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 #include "MenuManager.h"
 #include "MessageEngine.h"
 #include "PowerManager.h"
+#include "Profiler.h"
 #include "Settings.h"
 #include "SharedGameResources.h"
 #include "SharedResources.h"
@@ -116,6 +117,7 @@ Power::Power()
 	, requires_hpmp_state_mode(RESOURCESTATE_ANY)
 	, requires_resource_stat_state_mode(RESOURCESTATE_ALL)
 	, sfx_index(-1)
+	, sfx_hit_index(-1)
 	, visual_random(0)
 	, visual_option(0)
 	, lifespan(0)
@@ -183,8 +185,6 @@ PowerManager::PowerManager()
 	: collider(NULL)
 	, used_items()
 	, used_equipped_items() {
-	loadEffects();
-	loadPowers();
 }
 
 bool PowerManager::isValid(PowerID power_id) {
@@ -195,7 +195,7 @@ void PowerManager::loadEffects() {
 	FileParser infile;
 
 	// @CLASS PowerManager: Effects|Description of powers/effects.txt
-	if (!infile.open("powers/effects.txt", FileParser::MOD_FILE, FileParser::ERROR_NORMAL))
+	if (!infile.open("powers/effects.txt", FileParser::MOD_FILE, FileParser::ERROR_NORMAL, FileParser::USE_CACHE))
 		return;
 
 	while (infile.next()) {
@@ -275,21 +275,13 @@ void PowerManager::loadEffects() {
 	if (!effects.empty() && effects.back().id == "") {
 		effects.pop_back();
 	}
-
-	// load animations
-	for (size_t i = 0; i < effects.size(); ++i) {
-		if (!effects[i].animation.empty()) {
-			anim->increaseCount(effects[i].animation);
-			effect_animations[i] = anim->getAnimationSet(effects[i].animation)->getAnimation("");
-		}
-	}
 }
 
 void PowerManager::loadPowers() {
 	FileParser infile;
 
 	// @CLASS PowerManager: Powers|Description of powers/powers.txt
-	if (!infile.open("powers/powers.txt", FileParser::MOD_FILE, FileParser::ERROR_NORMAL))
+	if (!infile.open("powers/powers.txt", FileParser::MOD_FILE, FileParser::ERROR_NORMAL, FileParser::USE_CACHE))
 		return;
 
 	bool clear_post_effects = false;
@@ -612,9 +604,8 @@ void PowerManager::loadPowers() {
 		}
 		else if (infile.key == "soundfx_hit") {
 			// @ATTR power.soundfx_hit|filename|Filename of a sound effect to play when the power's hazard hits a valid target.
-			int sfx_id = loadSFX(infile.val);
-			if (sfx_id != -1) {
-				power->sfx_hit = sfx[sfx_id];
+			power->sfx_hit_index = loadSFX(infile.val);
+			if (power->sfx_hit_index != -1) {
 				power->sfx_hit_enable = true;
 			}
 		}
@@ -1128,12 +1119,6 @@ void PowerManager::loadPowers() {
 		else
 			count_allocated++;
 
-		// load animations
-		if (!power->animation_name.empty()) {
-			anim->increaseCount(power->animation_name);
-			power_animations[i] = anim->getAnimationSet(power->animation_name)->getAnimation("");
-		}
-
 		// verify power ids
 		power->buff_party_power_id = verifyID(power->buff_party_power_id, NULL, ALLOW_ZERO_ID);
 
@@ -1260,21 +1245,47 @@ bool PowerManager::isValidEffect(const std::string& type) {
 }
 
 /**
- * Load the specified sound effect for this power
+ * Register the specified sound effect for this power. It is loaded later by loadResources()
  *
  * @param filename The .ogg file containing the sound for this power, assumed to be in soundfx/powers/
- * @return The sfx[] array index for this mix chunk, or -1 upon load failure
+ * @return The sfx[] array index for this mix chunk
  */
 int PowerManager::loadSFX(const std::string& filename) {
+	std::vector<std::string>::iterator it = std::find(sfx_filenames.begin(), sfx_filenames.end(), filename);
+	if (it == sfx_filenames.end()) {
+		sfx_filenames.push_back(filename);
+		return static_cast<int>(sfx_filenames.size()) - 1;
+	}
+
+	return static_cast<int>(it - sfx_filenames.begin());
+}
+
+void PowerManager::loadResources() {
+	// load animations
+	for (size_t i = 0; i < effects.size(); ++i) {
+		if (!effects[i].animation.empty()) {
+			anim->increaseCount(effects[i].animation);
+			effect_animations[i] = anim->getAnimationSet(effects[i].animation)->getAnimation("");
+		}
+	}
 
-	SoundID sid = snd->load(filename, "PowerManager sfx");
-	std::vector<SoundID>::iterator it = std::find(sfx.begin(), sfx.end(), sid);
-	if (it == sfx.end()) {
-		sfx.push_back(sid);
-		return static_cast<int>(sfx.size()) - 1;
+	for (size_t i = 0; i < powers.size(); ++i) {
+		if (powers[i] && !powers[i]->animation_name.empty()) {
+			anim->increaseCount(powers[i]->animation_name);
+			power_animations[i] = anim->getAnimationSet(powers[i]->animation_name)->getAnimation("");
+		}
+	}
+
+	// load sound effects
+	sfx.resize(sfx_filenames.size(), 0);
+	for (size_t i = 0; i < sfx_filenames.size(); ++i) {
+		sfx[i] = snd->load(sfx_filenames[i], "PowerManager sfx");
 	}
 
-	return static_cast<int>(it - sfx.begin());
+	for (size_t i = 0; i < powers.size(); ++i) {
+		if (powers[i] && powers[i]->sfx_hit_index != -1)
+			powers[i]->sfx_hit = sfx[powers[i]->sfx_hit_index];
+	}
 }
 
 
@@ -1866,6 +1877,8 @@ PowerID PowerManager::checkReplaceByEffect(PowerID power_index, StatBlock *src_s
  * Activate is basically a switch/redirect to the appropriate function
  */
 bool PowerManager::activate(PowerID power_index, StatBlock *src_stats, const FPoint& origin, const FPoint& target) {
+	PROFILE_ZONE(Profiler::ZONE_POWERS);
+
 	if (!isValid(power_index))
 		return false;
 
@@ -238,6 +238,7 @@ public:
 	int requires_hpmp_state_mode;
 	int requires_resource_stat_state_mode;
 	int sfx_index;
+	int sfx_hit_index;
 	int visual_random; // sprite sheet contains rows of random options
 	int visual_option; // sprite sheet contains rows of similar effects.  use a specific option
 	int lifespan; // how long the hazard/animation lasts
@@ -314,9 +315,6 @@ private:
 
 	MapCollision *collider;
 
-	void loadEffects();
-	void loadPowers();
-
 	bool isValidEffect(const std::string& type);
 	int loadSFX(const std::string& filename);
 
@@ -339,11 +337,21 @@ private:
 	std::vector<Animation*> power_animations;
 	std::vector<Animation*> effect_animations;
 
+	// sound effects are named while parsing and loaded by loadResources()
+	std::vector<std::string> sfx_filenames;
+
 public:
 	static const bool ALLOW_ZERO_ID = true;
 
 	explicit PowerManager();
 	~PowerManager();
+
+	// loadEffects() and loadPowers() only parse, so they may run on a worker thread
+	void loadEffects();
+	void loadPowers();
+	// loads the animations and sound effects used by effects and powers on the main thread
+	void loadResources();
+
 	bool isValid(PowerID power_id);
 
 	void handleNewMap(MapCollision *_collider);
@@ -0,0 +1,343 @@
+/*
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+/**
+ * namespace Profiler
+ */
+
+#include "Profiler.h"
+#include "Utils.h"
+#include "UtilsFileSystem.h"
+
+#include <cstdlib>
+#include <fstream>
+#include <new>
+
+namespace Profiler {
+
+bool enabled = false;
+
+class ZoneInfo {
+public:
+	const char* name;
+	int depth; // zones nested in another zone are indented in the summary
+};
+
+const ZoneInfo ZONES[ZONE_COUNT] = {
+	{"input", 0},
+	{"logic", 0},
+	{"menu logic", 1},
+	{"avatar", 1},
+	{"entities", 1},
+	{"hazards", 1},
+	{"loot", 1},
+	{"npcs", 1},
+	{"powers", 2},
+	{"map logic", 1},
+	{"quests", 1},
+	{"render", 0},
+	{"render map", 1},
+	{"sort", 2},
+	{"tile layers", 2},
+	{"objects", 2},
+	{"render menus", 1},
+	{"commit frame", 0}
+};
+
+const char* COUNTER_NAMES[COUNTER_COUNT] = {
+	"draw calls",
+	"renderables sorted",
+	"path queries",
+	"entities ticked",
+	"allocations"
+};
+
+uint64_t zone_ticks[ZONE_COUNT];
+unsigned zone_calls[ZONE_COUNT];
+
+// the current frame, and the rolling history of the previous ones. The extra zone holds the whole frame
+uint64_t frame_zone_ticks[ZONE_COUNT];
+unsigned frame_counters[COUNTER_COUNT];
+uint64_t history_ticks[FRAME_HISTORY][ZONE_COUNT + 1];
+unsigned history_counters[FRAME_HISTORY][COUNTER_COUNT];
+unsigned history_pos = 0;
+unsigned history_size = 0;
+
+// allocations can come from any thread
+SDL_atomic_t allocations;
+
+class TraceEvent {
+public:
+	uint64_t start;
+	uint64_t end;
+	SDL_threadID thread;
+	int zone;
+};
+
+// must be a power of two. At ~30 zones per frame, this holds a couple of minutes of play
+const unsigned TRACE_BUFFER_SIZE = 1 << 18;
+
+std::vector<TraceEvent> trace_buffer;
+SDL_atomic_t trace_head;
+bool tracing = false;
+std::string trace_filename;
+uint64_t trace_start = 0;
+SDL_threadID main_thread = 0;
+
+void setEnabled(bool enable) {
+	// tracing keeps the profiler enabled until the trace is written
+	enabled = enable || tracing;
+}
+
+void reset() {
+	for (int i = 0; i < ZONE_COUNT; ++i) {
+		zone_ticks[i] = 0;
+		zone_calls[i] = 0;
+		frame_zone_ticks[i] = 0;
+	}
+	for (int i = 0; i < COUNTER_COUNT; ++i) {
+		frame_counters[i] = 0;
+	}
+	history_pos = 0;
+	history_size = 0;
+	SDL_AtomicSet(&allocations, 0);
+}
+
+void endZone(int zone, uint64_t start, uint64_t end) {
+	if (tracing) {
+		// writers claim a slot with a single atomic add, so no lock is needed. Once the buffer is full, the oldest events are overwritten
+		unsigned index = static_cast<unsigned>(SDL_AtomicAdd(&trace_head, 1)) & (TRACE_BUFFER_SIZE - 1);
+		TraceEvent& event = trace_buffer[index];
+		event.start = start;
+		event.end = end;
+		event.thread = SDL_ThreadID();
+		event.zone = zone;
+	}
+
+	zone_ticks[zone] += end - start;
+	zone_calls[zone]++;
+	frame_zone_ticks[zone] += end - start;
+}
+
+void endFrame(uint64_t frame_ticks) {
+	frame_counters[COUNTER_ALLOCATIONS] = static_cast<unsigned>(SDL_AtomicSet(&allocations, 0));
+
+	for (int i = 0; i < ZONE_COUNT; ++i) {
+		history_ticks[history_pos][i] = frame_zone_ticks[i];
+		frame_zone_ticks[i] = 0;
+	}
+	history_ticks[history_pos][ZONE_COUNT] = frame_ticks;
+
+	for (int i = 0; i < COUNTER_COUNT; ++i) {
+		history_counters[history_pos][i] = frame_counters[i];
+		frame_counters[i] = 0;
+	}
+
+	history_pos = (history_pos + 1) % FRAME_HISTORY;
+	if (history_size < FRAME_HISTORY)
+		history_size++;
+}
+
+void getFrameTime(int zone, float* avg_ms, float* p99_ms) {
+	*avg_ms = 0;
+	*p99_ms = 0;
+	if (history_size == 0)
+		return;
+
+	uint64_t samples[FRAME_HISTORY];
+	uint64_t total = 0;
+	for (unsigned i = 0; i < history_size; ++i) {
+		samples[i] = history_ticks[i][zone];
+		total += samples[i];
+	}
+
+	unsigned p99_index = (history_size * 99) / 100;
+	std::nth_element(samples, samples + p99_index, samples + history_size);
+
+	const float ms_per_tick = 1000.f / static_cast<float>(SDL_GetPerformanceFrequency());
+	*avg_ms = static_cast<float>(total) * ms_per_tick / static_cast<float>(history_size);
+	*p99_ms = static_cast<float>(samples[p99_index]) * ms_per_tick;
+}
+
+void getCounter(int counter, float* avg, unsigned* last) {
+	*avg = 0;
+	*last = 0;
+	if (history_size == 0)
+		return;
+
+	uint64_t total = 0;
+	for (unsigned i = 0; i < history_size; ++i) {
+		total += history_counters[i][counter];
+	}
+
+	*avg = static_cast<float>(total) / static_cast<float>(history_size);
+	*last = history_counters[(history_pos + FRAME_HISTORY - 1) % FRAME_HISTORY][counter];
+}
+
+void getReport(std::vector<std::string>& lines) {
+	char buf[128];
+	float avg_ms, p99_ms;
+
+	getFrameTime(ZONE_COUNT, &avg_ms, &p99_ms);
+	snprintf(buf, sizeof(buf), "frame: %.2f ms avg, %.2f ms p99 (%u frames)", avg_ms, p99_ms, history_size);
+	lines.push_back(buf);
+
+	for (int i = 0; i < ZONE_COUNT; ++i) {
+		getFrameTime(i, &avg_ms, &p99_ms);
+		if (p99_ms == 0)
+			continue;
+
+		snprintf(buf, sizeof(buf), "%*s%s: %.2f / %.2f ms", ZONES[i].depth * 2 + 2, "", ZONES[i].name, avg_ms, p99_ms);
+		lines.push_back(buf);
+	}
+
+	float avg;
+	unsigned last;
+	for (int i = 0; i < COUNTER_COUNT; ++i) {
+		getCounter(i, &avg, &last);
+		snprintf(buf, sizeof(buf), "%s: %u (%.1f avg)", COUNTER_NAMES[i], last, avg);
+		lines.push_back(buf);
+	}
+}
+
+void logSummary(unsigned frames, uint64_t total_ticks) {
+	const double ms_per_tick = 1000.0 / static_cast<double>(SDL_GetPerformanceFrequency());
+
+	Utils::logInfo("Profiler: %-16s %10s %10s %7s", "zone", "total ms", "ms/frame", "share");
+	for (int i = 0; i < ZONE_COUNT; ++i) {
+		if (zone_calls[i] == 0)
+			continue;
+
+		std::string name = std::string(ZONES[i].depth * 2, ' ') + ZONES[i].name;
+		double total_ms = static_cast<double>(zone_ticks[i]) * ms_per_tick;
+		double share = total_ticks > 0 ? 100.0 * static_cast<double>(zone_ticks[i]) / static_cast<double>(total_ticks) : 0;
+		Utils::logInfo("Profiler: %-16s %10.2f %10.4f %6.1f%%", name.c_str(), total_ms, frames > 0 ? total_ms / frames : 0, share);
+	}
+}
+
+bool startTrace(const std::string& filename) {
+#ifdef FLARE_NO_PROFILER
+	Utils::logError("Profiler: Unable to trace to '%s', this build does not include profiler zones.", filename.c_str());
+	return false;
+#else
+	if (tracing)
+		return true;
+
+	trace_buffer.resize(TRACE_BUFFER_SIZE);
+	SDL_AtomicSet(&trace_head, 0);
+	trace_filename = filename;
+	trace_start = SDL_GetPerformanceCounter();
+	main_thread = SDL_ThreadID();
+	tracing = true;
+	enabled = true;
+
+	Utils::logInfo("Profiler: Recording trace to '%s'.", filename.c_str());
+	return true;
+#endif
+}
+
+void stopTrace() {
+	if (!tracing)
+		return;
+
+	tracing = false;
+	enabled = false;
+
+	unsigned head = static_cast<unsigned>(SDL_AtomicGet(&trace_head));
+	unsigned count = std::min(head, TRACE_BUFFER_SIZE);
+	unsigned first = head - count;
+
+	std::ofstream outfile;
+	outfile.open(Filesystem::convertSlashes(trace_filename).c_str(), std::ios::out);
+
+	if (!outfile.is_open()) {
+		Utils::logError("Profiler: Unable to write trace to '%s'.", trace_filename.c_str());
+	}
+	else {
+		const double us_per_tick = 1000000.0 / static_cast<double>(SDL_GetPerformanceFrequency());
+
+		outfile << "{\"traceEvents\":[\n";
+		outfile << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << main_thread << ",\"args\":{\"name\":\"main\"}}";
+
+		char buf[256];
+		for (unsigned i = 0; i < count; ++i) {
+			const TraceEvent& event = trace_buffer[(first + i) & (TRACE_BUFFER_SIZE - 1)];
+
+			// events from before the trace started can't be placed on the timeline
+			if (event.start < trace_start)
+				continue;
+
+			double ts = static_cast<double>(event.start - trace_start) * us_per_tick;
+			double dur = static_cast<double>(event.end - event.start) * us_per_tick;
+			snprintf(buf, sizeof(buf), ",\n{\"name\":\"%s\",\"cat\":\"flare\",\"ph\":\"X\",\"pid\":1,\"tid\":%lu,\"ts\":%.3f,\"dur\":%.3f}", ZONES[event.zone].name, static_cast<unsigned long>(event.thread), ts, dur);
+			outfile << buf;
+		}
+
+		outfile << "\n]}\n";
+
+		if (outfile.bad())
+			Utils::logError("Profiler: Unable to write trace to '%s'.", trace_filename.c_str());
+		else
+			Utils::logInfo("Profiler: Wrote %u events to '%s'.", count, trace_filename.c_str());
+
+		outfile.close();
+	}
+
+	trace_buffer.clear();
+	trace_buffer.shrink_to_fit();
+}
+
+} // namespace Profiler
+
+#ifndef FLARE_NO_PROFILER
+/**
+ * Replacing the global allocation functions is the only way to see every allocation.
+ * They are only counted while the profiler is enabled, so the atomic increment isn't paid otherwise.
+ */
+void* operator new(size_t size) {
+	if (Profiler::enabled)
+		SDL_AtomicAdd(&Profiler::allocations, 1);
+
+	void* ptr = malloc(size > 0 ? size : 1);
+	while (!ptr) {
+		std::new_handler handler = std::get_new_handler();
+		if (!handler)
+			abort();
+		handler();
+		ptr = malloc(size > 0 ? size : 1);
+	}
+	return ptr;
+}
+
+void* operator new[](size_t size) {
+	return operator new(size);
+}
+
+void operator delete(void* ptr) noexcept {
+	free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+	free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+	free(ptr);
+}
+
+void operator delete[](void* ptr, size_t) noexcept {
+	free(ptr);
+}
+#endif
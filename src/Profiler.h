@@ -0,0 +1,130 @@
+/*
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+/**
+ * namespace Profiler
+ *
+ * Measures the time spent in the engine's main subsystems.
+ * Zones are timed by placing PROFILE_ZONE() at the start of a scope, and only while the profiler is enabled.
+ * Finished zones are added to per-zone totals (see --simulate-ticks) and, when tracing,
+ * recorded in a ring buffer that is written out in the Chrome trace format (see --trace).
+ * The last few seconds of frames are also kept, along with a few per-frame counters, for the dev HUD.
+ *
+ * Building with FLARE_NO_PROFILER defined removes the zones entirely.
+ */
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include "CommonIncludes.h"
+
+namespace Profiler {
+	enum {
+		ZONE_INPUT = 0,
+		ZONE_LOGIC,
+		ZONE_MENUS,
+		ZONE_AVATAR,
+		ZONE_ENTITIES,
+		ZONE_HAZARDS,
+		ZONE_LOOT,
+		ZONE_NPCS,
+		ZONE_POWERS,
+		ZONE_MAP,
+		ZONE_QUESTS,
+		ZONE_RENDER,
+		ZONE_RENDER_MAP,
+		ZONE_MAP_SORT,
+		ZONE_MAP_LAYERS,
+		ZONE_MAP_OBJECTS,
+		ZONE_RENDER_MENUS,
+		ZONE_COMMIT,
+		ZONE_COUNT
+	};
+
+	enum {
+		COUNTER_DRAW_CALLS = 0,
+		COUNTER_RENDERABLES,
+		COUNTER_PATH_QUERIES,
+		COUNTER_ENTITIES,
+		COUNTER_ALLOCATIONS,
+		COUNTER_COUNT
+	};
+
+	// number of frames used for the rolling frame statistics
+	const unsigned FRAME_HISTORY = 240;
+
+	extern bool enabled;
+	extern unsigned frame_counters[COUNTER_COUNT];
+
+	void setEnabled(bool enable);
+	void reset(); // clears both the totals and the rolling history
+
+	// called by ProfileZone when a zone ends. Only for the main thread, since the totals aren't locked
+	void endZone(int zone, uint64_t start, uint64_t end);
+
+	// only for the main thread
+	inline void addCount(int counter, unsigned amount = 1) {
+		if (enabled)
+			frame_counters[counter] += amount;
+	}
+
+	// moves the zone times and counters of the current frame into the rolling history
+	void endFrame(uint64_t frame_ticks);
+
+	// average and 99th percentile time in milliseconds over the rolling history. zone == ZONE_COUNT gives the whole frame
+	void getFrameTime(int zone, float* avg_ms, float* p99_ms);
+
+	// average value of a counter over the rolling history, and its value in the last frame
+	void getCounter(int counter, float* avg, unsigned* last);
+
+	// formats the rolling statistics as lines of text, for the dev HUD and console
+	void getReport(std::vector<std::string>& lines);
+
+	// logs the total and per-frame time of every zone that was entered
+	void logSummary(unsigned frames, uint64_t total_ticks);
+
+	// starts recording zones to the ring buffer, enabling the profiler if needed
+	bool startTrace(const std::string& filename);
+
+	// writes the recorded zones to the file given to startTrace() and frees the ring buffer
+	void stopTrace();
+}
+
+class ProfileZone {
+public:
+	explicit ProfileZone(int _zone)
+		: zone(_zone)
+		, start(Profiler::enabled ? SDL_GetPerformanceCounter() : 0) {
+	}
+
+	~ProfileZone() {
+		if (start)
+			Profiler::endZone(zone, start, SDL_GetPerformanceCounter());
+	}
+
+private:
+	int zone;
+	uint64_t start;
+};
+
+#ifdef FLARE_NO_PROFILER
+#define PROFILE_ZONE(zone)
+#else
+#define PROFILE_ZONE_NAME2(line) profile_zone_##line
+#define PROFILE_ZONE_NAME(line) PROFILE_ZONE_NAME2(line)
+#define PROFILE_ZONE(zone) ProfileZone PROFILE_ZONE_NAME(__LINE__)(zone)
+#endif
+
+#endif
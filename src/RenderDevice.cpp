@@ -17,6 +17,8 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 */
 
 #include "EngineSettings.h"
+#include "ImageLoader.h"
+#include "ModManager.h"
 #include "RenderDevice.h"
 #include "Settings.h"
 #include "SharedResources.h"
@@ -24,6 +26,7 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 
 #include <assert.h>
 #include <stdio.h>
+#include <string.h>
 
 /*
  * Image
@@ -45,7 +48,7 @@ void Image::ref() {
 void Image::unref() {
 	--ref_counter;
 	if (ref_counter == 0)
-		delete this;
+		device->releaseImage(this);
 }
 
 uint32_t Image::getRefCount() const {
@@ -171,14 +174,23 @@ RenderDevice::RenderDevice()
 	, destructive_fullscreen(false)
 	, is_initialized(false)
 	, reload_graphics(false)
+	, context_version(0)
 	, ddpi(0)
+	, cache_memory(0)
+	, cache_unused_memory(0)
+	, cache_use_counter(0)
+	, cache_context_released(false)
+	, image_loader(NULL)
 {
 }
 
 RenderDevice::~RenderDevice() {
+	delete image_loader;
 }
 
 int RenderDevice::createContext() {
+	context_version++;
+
 	int status = createContextInternal();
 
 	if (status == -1) {
@@ -218,7 +230,7 @@ void RenderDevice::destroyContext() {
 		Utils::logError("RenderDevice: Image cache still holding these images:");
 		it = cache.begin();
 		while (it != cache.end()) {
-			Utils::logError("%s %d", it->first.c_str(), it->second->getRefCount());
+			Utils::logError("%s %d", it->first.c_str(), it->second.image->getRefCount());
 			++it;
 		}
 	}
@@ -229,39 +241,191 @@ Image * RenderDevice::cacheLookup(const std::string &filename) {
 	IMAGE_CACHE_CONTAINER_ITER it;
 	it = cache.find(filename);
 	if (it != cache.end()) {
-		it->second->ref();
-		return it->second;
+		Image *image = it->second.image;
+		cacheUse(it->second);
+
+		// the caller may need the pixels of an image that is still being loaded
+		if (image_loader)
+			image_loader->finish(image);
+
+		return image;
 	}
 	return NULL;
 }
 
 void RenderDevice::cacheStore(const std::string &filename, Image *image) {
 	if (image == NULL) return;
-	cache[filename] = image;
+
+	IMAGE_CACHE_CONTAINER_ITER it = cache.find(filename);
+	if (it != cache.end()) {
+		if (it->second.unused)
+			delete it->second.image;
+		else
+			cacheRemove(it->second.image);
+	}
+
+	CacheEntry entry;
+	entry.image = image;
+	entry.memory = static_cast<size_t>(image->getWidth()) * static_cast<size_t>(image->getHeight()) * (BITS_PER_PIXEL / 8);
+	entry.category = getCacheCategory(filename);
+	entry.last_used = ++cache_use_counter;
+	entry.unused = false;
+
+	cache[filename] = entry;
+	cache_memory += entry.memory;
 }
 
 void RenderDevice::cacheRemove(Image *image) {
-	IMAGE_CACHE_CONTAINER_ITER it = cache.begin();
-	while (it != cache.end()) {
-		if (it->second == image)
-			break;
-		++it;
-	}
+	IMAGE_CACHE_CONTAINER_ITER it = cacheFind(image);
 
 	if (it != cache.end()) {
+		cache_memory -= it->second.memory;
+		if (it->second.unused)
+			cache_unused_memory -= it->second.memory;
 		cache.erase(it);
 	}
 }
 
+size_t RenderDevice::getCacheMemory() {
+	return cache_memory;
+}
+
+size_t RenderDevice::getCacheMemory(int category) {
+	size_t total = 0;
+	for (IMAGE_CACHE_CONTAINER_ITER it = cache.begin(); it != cache.end(); ++it) {
+		if (it->second.category == category)
+			total += it->second.memory;
+	}
+	return total;
+}
+
+size_t RenderDevice::getCacheUnusedMemory() {
+	return cache_unused_memory;
+}
+
 void RenderDevice::cacheRemoveAll() {
+	if (image_loader)
+		image_loader->cancel();
+
 	IMAGE_CACHE_CONTAINER_ITER it = cache.begin();
 
 	while (it != cache.end()) {
-		cacheRemove(it->second);
+		// images kept for reuse belong to the cache, the rest are only forgotten
+		if (it->second.unused)
+			delete it->second.image;
+		else
+			cacheRemove(it->second.image);
 		it = cache.begin();
 	}
 }
 
+/**
+ * Called before the context is destroyed. The unused images aren't worth recreating, so they are deleted.
+ * The images that are still in use stay in the cache and only release their context resources.
+ */
+void RenderDevice::cacheReleaseContext() {
+	if (image_loader)
+		image_loader->cancel();
+
+	cacheEvict(0);
+
+	for (IMAGE_CACHE_CONTAINER_ITER it = cache.begin(); it != cache.end(); ++it) {
+		releaseImageContext(it->second.image);
+	}
+	cache_context_released = true;
+}
+
+/**
+ * Called once a new context exists, reloads the images kept by cacheReleaseContext() in place
+ */
+void RenderDevice::cacheRestoreContext() {
+	if (!cache_context_released)
+		return;
+
+	for (IMAGE_CACHE_CONTAINER_ITER it = cache.begin(); it != cache.end(); ++it) {
+		restoreImageContext(it->first, it->second.image);
+	}
+	cache_context_released = false;
+}
+
+void RenderDevice::releaseImageContext(Image *) {
+}
+
+void RenderDevice::restoreImageContext(const std::string &, Image *) {
+}
+
+RenderDevice::IMAGE_CACHE_CONTAINER_ITER RenderDevice::cacheFind(Image *image) {
+	IMAGE_CACHE_CONTAINER_ITER it = cache.begin();
+	while (it != cache.end()) {
+		if (it->second.image == image)
+			break;
+		++it;
+	}
+	return it;
+}
+
+/**
+ * Adds a reference for a caller of the cache, taking the image back out of the unused ones
+ */
+void RenderDevice::cacheUse(CacheEntry &entry) {
+	if (entry.unused) {
+		entry.unused = false;
+		cache_unused_memory -= entry.memory;
+	}
+	entry.last_used = ++cache_use_counter;
+	entry.image->ref();
+}
+
+/**
+ * Deletes the least recently used unused images until the cache is comfortably under budget,
+ * so that releasing a whole menu or map doesn't go through the cache for every image.
+ * Images that are still referenced count towards the budget, but can't be evicted.
+ */
+void RenderDevice::cacheEvict(size_t budget) {
+	std::vector<IMAGE_CACHE_CONTAINER_ITER> candidates;
+	for (IMAGE_CACHE_CONTAINER_ITER it = cache.begin(); it != cache.end(); ++it) {
+		if (it->second.unused)
+			candidates.push_back(it);
+	}
+
+	std::sort(candidates.begin(), candidates.end(), compareLastUsed);
+
+	size_t target = budget - budget / 4;
+	for (size_t i = 0; i < candidates.size() && cache_memory > target; ++i) {
+		// removes its own entry from the cache, the other iterators stay valid
+		delete candidates[i]->second.image;
+	}
+}
+
+bool RenderDevice::compareLastUsed(const IMAGE_CACHE_CONTAINER_ITER& a, const IMAGE_CACHE_CONTAINER_ITER& b) {
+	return a->second.last_used < b->second.last_used;
+}
+
+/**
+ * Sorts cached images for the memory totals in the performance overlay, by the
+ * directory they are in
+ */
+int RenderDevice::getCacheCategory(const std::string &filename) {
+	static const char* const PREFIXES[] = {
+		"images/tilesets/",
+		"images/avatar/", "images/enemies/", "images/npcs/", "images/powers/", "images/loot/", "animations/",
+		"images/menus/", "images/icons/", "images/logo/", "images/credits/",
+		"images/portraits/"
+	};
+	static const int CATEGORIES[] = {
+		CACHE_TILES,
+		CACHE_ANIMATIONS, CACHE_ANIMATIONS, CACHE_ANIMATIONS, CACHE_ANIMATIONS, CACHE_ANIMATIONS, CACHE_ANIMATIONS,
+		CACHE_UI, CACHE_UI, CACHE_UI, CACHE_UI,
+		CACHE_PORTRAITS
+	};
+
+	for (size_t i = 0; i < sizeof(PREFIXES) / sizeof(PREFIXES[0]); ++i) {
+		if (filename.compare(0, strlen(PREFIXES[i]), PREFIXES[i]) == 0)
+			return CATEGORIES[i];
+	}
+	return CACHE_OTHER;
+}
+
 bool RenderDevice::localToGlobal(Sprite *r) {
 	m_clip = r->getClip();
 
@@ -316,6 +480,81 @@ bool RenderDevice::reloadGraphics() {
 	return false;
 }
 
+unsigned RenderDevice::getContextVersion() {
+	return context_version;
+}
+
+/**
+ * Creates an image from a surface that was decoded elsewhere, such as on a loading
+ * thread, and stores it in the cache under filename. If the cache already has the
+ * image, that one is returned instead. The surface is not freed.
+ */
+Image *RenderDevice::loadImageFromSurface(const std::string& filename, SDL_Surface *surface) {
+	Image *image = cacheLookup(filename);
+	if (image != NULL) return image;
+
+	image = createImageFromSurface(surface);
+	cacheStore(filename, image);
+	return image;
+}
+
+Image *RenderDevice::loadImageAsync(const std::string& filename, int error_type) {
+	IMAGE_CACHE_CONTAINER_ITER it = cache.find(filename);
+	if (it != cache.end()) {
+		cacheUse(it->second);
+		return it->second.image;
+	}
+
+	// the game can't continue without some images, and a device without pixels loads only the size anyway
+	if (error_type == ERROR_EXIT || !needsPixels())
+		return loadImage(filename, error_type);
+
+	// only the size of a PNG can be read without decoding it
+	std::string path = mods->locate(filename);
+	Point size;
+	if (!ImageLoader::readImageSize(path, size))
+		return loadImage(filename, error_type);
+
+	if (!image_loader)
+		image_loader = new ImageLoader();
+	if (!image_loader->isRunning())
+		return loadImage(filename, error_type);
+
+	Image *image = createImage(size.x, size.y);
+	if (!image)
+		return loadImage(filename, error_type);
+
+	cacheStore(filename, image);
+	image_loader->push(filename, path, image, error_type);
+	return image;
+}
+
+void RenderDevice::uploadImages() {
+	if (image_loader)
+		image_loader->upload();
+}
+
+void RenderDevice::releaseImage(Image *image) {
+	size_t budget = static_cast<size_t>(settings->image_cache_size) * 1024 * 1024;
+
+	IMAGE_CACHE_CONTAINER_ITER it = cacheFind(image);
+	if (it == cache.end() || budget == 0 || it->second.memory > budget) {
+		delete image;
+		return;
+	}
+
+	it->second.unused = true;
+	it->second.last_used = ++cache_use_counter;
+	cache_unused_memory += it->second.memory;
+
+	if (cache_memory > budget)
+		cacheEvict(budget);
+}
+
+void RenderDevice::freeUnusedImages() {
+	cacheEvict(0);
+}
+
 void RenderDevice::freeImage(Image *image) {
 	if (!image) return;
 
@@ -435,3 +674,11 @@ unsigned short RenderDevice::getRefreshRate() {
 	Utils::logInfo("RenderDevice: getRefreshRate() not implemented");
 	return 0;
 }
+
+bool RenderDevice::supportsPremultipliedAlpha() {
+	return false;
+}
+
+bool RenderDevice::needsPixels() {
+	return true;
+}
@@ -26,6 +26,7 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 #include "Utils.h"
 
 class Image;
+class ImageLoader;
 class RenderDevice;
 class FontStyle;
 
@@ -86,8 +87,10 @@ protected:
  * by OpenGL render device this is a texture.
  *
  * Image uses a refrence counter to control when to free the resource, when the
- * last reference is released, the Image is deleted and then removed from cache
- * using RenderDevice::freeImage().
+ * last reference is released, the Image is handed to RenderDevice::releaseImage().
+ * Images from the cache may be kept there for reuse until the cache goes over its
+ * memory budget; other images are deleted and removed from cache using
+ * RenderDevice::freeImage().
  *
  * The caller who instantiates an Image is responsible for release the reference
  * to the image when not used anymore.
@@ -117,6 +120,8 @@ public:
 	virtual void beginPixelBatch();
 	virtual void beginPixelBatch(Rect& bounds);
 	virtual void endPixelBatch();
+	// replaces the pixels in area with the same area of an ARGB8888 surface, without blending
+	virtual void copyFromSurface(SDL_Surface* src, const Rect& area) = 0;
 	virtual Image* resize(int width, int height) = 0;
 
 	class Sprite *createSprite();
@@ -126,6 +131,8 @@ private:
 	virtual ~Image();
 	friend class SDLSoftwareImage;
 	friend class SDLHardwareImage;
+	friend class NullImage;
+	friend class RenderDevice;
 
 private:
 	RenderDevice *device;
@@ -136,7 +143,8 @@ class Renderable {
 public:
 	enum {
 		BLEND_NORMAL = 0,
-		BLEND_ADD = 1
+		BLEND_ADD = 1,
+		BLEND_PREMULTIPLIED = 2 // the image's colors are already multiplied by its alpha (see LayerCompositor)
 	};
 
 	enum {
@@ -200,6 +208,15 @@ public:
 		ERROR_EXIT = 2
 	};
 
+	enum {
+		CACHE_TILES = 0,
+		CACHE_ANIMATIONS = 1,
+		CACHE_UI = 2,
+		CACHE_PORTRAITS = 3,
+		CACHE_OTHER = 4,
+		CACHE_CATEGORY_COUNT = 5
+	};
+
 	static const unsigned char BITS_PER_PIXEL;
 
 	RenderDevice();
@@ -215,12 +232,30 @@ public:
 	/** factory functions for Image */
 	virtual Image *loadImage(const std::string& filename, int error_type) = 0;
 	virtual Image *createImage(int width, int height) = 0;
+	virtual Image *createImageFromSurface(SDL_Surface *surface) = 0;
+	Image *loadImageFromSurface(const std::string& filename, SDL_Surface *surface);
+
+	// returns a blank image of the right size right away, which is filled in by uploadImages() once
+	// it has been decoded. loadImage() of the same file waits for it instead.
+	Image *loadImageAsync(const std::string& filename, int error_type);
+
+	// called once per frame, copies decoded images into their placeholders within a time budget
+	void uploadImages();
+
+	// called by Image::unref() for the last reference. Keeps cached images for reuse while under budget
+	void releaseImage(Image *image);
 	void freeImage(Image *image);
 
+	// deletes the cached images nobody holds a reference to, e.g. when the mods have changed
+	void freeUnusedImages();
+
 	/** Screen operations */
 	virtual int render(Sprite* r) = 0;
 	virtual int render(Renderable& r, Rect& dest) = 0;
 	virtual int renderToImage(Image* src_image, Rect& src, Image* dest_image, Rect& dest) = 0;
+
+	// draws several areas of one image onto another in order, switching to the target only once. The source is multiplied by color_mod, including its alpha
+	virtual int renderToImageBatch(Image* src_image, const std::vector<Rect>& src, Image* dest_image, const std::vector<Rect>& dest, const Color& color_mod) = 0;
 	virtual Image* renderTextToImage(FontStyle* font_style, const std::string& text, const Color& color, bool blended) = 0;
 	virtual void blankScreen() = 0;
 	virtual void commitFrame() = 0;
@@ -234,8 +269,25 @@ public:
 	virtual void setFullscreen(bool enable_fullscreen);
 	virtual unsigned short getRefreshRate();
 
+	// true if Renderable::BLEND_PREMULTIPLIED can be drawn
+	virtual bool supportsPremultipliedAlpha();
+
+	// false if images only keep their size, so decoding their pixels ahead of time would be wasted
+	virtual bool needsPixels();
+
+	// true once after the context was recreated, for holders of images that weren't loaded through the cache
 	bool reloadGraphics();
 
+	// changes every time the context is created, images made before that may no longer be usable
+	unsigned getContextVersion();
+
+	// approximate memory used by the images in the cache, in bytes
+	size_t getCacheMemory();
+	size_t getCacheMemory(int category);
+
+	// memory used by cached images that nobody holds a reference to
+	size_t getCacheUnusedMemory();
+
 protected:
 	/* Compute clipping and global position from local frame. */
 	bool localToGlobal(Sprite *r);
@@ -245,8 +297,14 @@ protected:
 	void cacheStore(const std::string &filename, Image *);
 	void cacheRemove(Image *image);
 	void cacheRemoveAll();
+	void cacheReleaseContext();
+	void cacheRestoreContext();
 	void windowResizeInternal();
 
+	// frees and recreates what an image needs from the current context, such as a texture. Called for cached images only
+	virtual void releaseImageContext(Image *image);
+	virtual void restoreImageContext(const std::string &filename, Image *image);
+
 	/** Context operations */
 	virtual int createContextInternal() = 0;
 	virtual void createContextError() = 0;
@@ -261,6 +319,7 @@ protected:
 
 	bool is_initialized;
 	bool reload_graphics;
+	unsigned context_version;
 
 	float ddpi;
 
@@ -268,10 +327,32 @@ protected:
 	Rect m_dest;
 
 private:
-	typedef std::map<std::string, Image *> IMAGE_CACHE_CONTAINER;
+	class CacheEntry {
+	public:
+		Image *image;
+		size_t memory;
+		int category;
+		unsigned last_used;
+		bool unused; // the image has no references and is only kept for reuse
+	};
+
+	typedef std::map<std::string, CacheEntry> IMAGE_CACHE_CONTAINER;
 	typedef IMAGE_CACHE_CONTAINER::iterator IMAGE_CACHE_CONTAINER_ITER;
 
+	static int getCacheCategory(const std::string &filename);
+	static bool compareLastUsed(const IMAGE_CACHE_CONTAINER_ITER& a, const IMAGE_CACHE_CONTAINER_ITER& b);
+
+	IMAGE_CACHE_CONTAINER_ITER cacheFind(Image *image);
+	void cacheUse(CacheEntry &entry);
+	void cacheEvict(size_t budget);
+
 	IMAGE_CACHE_CONTAINER cache;
+	size_t cache_memory;
+	size_t cache_unused_memory;
+	unsigned cache_use_counter;
+	bool cache_context_released;
+
+	ImageLoader *image_loader;
 
 	virtual void getWindowSize(short unsigned *screen_w, short unsigned *screen_h) = 0;
 };
@@ -31,9 +31,96 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 #include "Settings.h"
 #include "UtilsParsing.h"
 
+// SDL_ttf 2.0.18 added the 32-bit glyph functions, 2.0.14 added kerning lookups by glyph
+#if SDL_VERSIONNUM(SDL_TTF_MAJOR_VERSION, SDL_TTF_MINOR_VERSION, SDL_TTF_PATCHLEVEL) >= SDL_VERSIONNUM(2, 0, 18)
+#define TTF_HAS_GLYPH32
+#endif
+#if SDL_VERSIONNUM(SDL_TTF_MAJOR_VERSION, SDL_TTF_MINOR_VERSION, SDL_TTF_PATCHLEVEL) >= SDL_VERSIONNUM(2, 0, 14)
+#define TTF_HAS_GLYPH_KERNING
+#endif
+
+/**
+ * Returns the code point starting at pos and moves pos to the next one.
+ * Malformed sequences are returned as U+FFFD.
+ */
+static uint32_t decodeUTF8(const std::string& text, size_t& pos) {
+	unsigned char c = static_cast<unsigned char>(text[pos++]);
+	if (c < 0x80)
+		return c;
+
+	size_t extra;
+	uint32_t codepoint;
+	if ((c & 0xe0) == 0xc0) {
+		extra = 1;
+		codepoint = c & 0x1f;
+	}
+	else if ((c & 0xf0) == 0xe0) {
+		extra = 2;
+		codepoint = c & 0x0f;
+	}
+	else if ((c & 0xf8) == 0xf0) {
+		extra = 3;
+		codepoint = c & 0x07;
+	}
+	else {
+		return 0xfffd;
+	}
+
+	for (size_t i = 0; i < extra; ++i) {
+		if (pos >= text.length() || (text[pos] & 0xc0) != 0x80)
+			return 0xfffd;
+		codepoint = (codepoint << 6) | (text[pos++] & 0x3f);
+	}
+
+	return codepoint;
+}
+
+/**
+ * Scripts that rely on combining marks, joining or reordering can't be drawn one glyph at a time.
+ * Text containing them is handed to SDL_ttf as a whole instead.
+ */
+static bool needsShaping(uint32_t codepoint) {
+	return (codepoint >= 0x0300 && codepoint < 0x0370) // combining diacritical marks
+		|| (codepoint >= 0x0590 && codepoint < 0x1100) // Hebrew through Myanmar
+		|| (codepoint >= 0x1780 && codepoint < 0x18b0) // Khmer, Mongolian
+		|| (codepoint >= 0x200c && codepoint < 0x2010) // joiners and direction marks
+		|| (codepoint >= 0xfb1d && codepoint < 0xff00) // presentation forms
+#ifndef TTF_HAS_GLYPH32
+		|| codepoint > 0xffff
+#endif
+		;
+}
+
+SDLGlyph::SDLGlyph()
+	: loaded(false)
+	, rasterized(false)
+	, minx(0)
+	, maxx(0)
+	, advance(0)
+	, page(-1)
+	, src()
+	, offset()
+{
+}
+
+SDLGlyphPage::SDLGlyphPage()
+	: surface(NULL)
+	, cursor()
+	, row_height(0)
+	, version(0)
+{
+}
+
+SDLGlyphAtlas::SDLGlyphAtlas()
+	: context_version(0)
+{
+}
+
 SDLFontStyle::SDLFontStyle()
 	: FontStyle()
 	, ttfont(NULL)
+	, glyphs(256)
+	, use_kerning(false)
 {
 }
 
@@ -84,7 +171,7 @@ SDLFontEngine::SDLFontEngine()
 					style->ptsize = Parse::popFirstInt(infile.val);
 					style->blend = Parse::toBool(Parse::popFirstString(infile.val));
 
-					style->ttfont = TTF_OpenFont(mods->locate("fonts/" + style->path).c_str(), style->ptsize);
+					style->ttfont = TTF_OpenFontRW(mods->openRW(mods->locate("fonts/" + style->path)), 1, style->ptsize);
 					if(style->ttfont == NULL) {
 						Utils::logError("FontEngine: TTF_OpenFont: %s", TTF_GetError());
 					}
@@ -92,6 +179,7 @@ SDLFontEngine::SDLFontEngine()
 						int lineskip = TTF_FontLineSkip(style->ttfont);
 						style->line_height = lineskip;
 						style->font_height = lineskip;
+						style->use_kerning = (TTF_GetFontKerning(style->ttfont) != 0);
 					}
 				}
 			}
@@ -111,6 +199,10 @@ bool SDLFontEngine::isActiveFontValid() {
 	return active_font && active_font->ttfont;
 }
 
+FontStyle* SDLFontEngine::getActiveFont() {
+	return active_font;
+}
+
 int SDLFontEngine::getLineHeight() {
 	if (!isActiveFontValid())
 		return 1;
@@ -132,7 +224,11 @@ int SDLFontEngine::calc_width(const std::string& text) {
 	if (!isActiveFontValid())
 		return 1;
 
-	int w, h;
+	int w = 0;
+	if (layoutText(text, NULL, &w))
+		return w;
+
+	int h;
 	TTF_SizeUTF8(active_font->ttfont, text.c_str(), &w, &h);
 
 	return w;
@@ -220,6 +316,262 @@ void SDLFontEngine::setFont(const std::string& _font) {
 	Utils::logError("FontEngine: Invalid font '%s'. No fallback available.", _font.c_str());
 }
 
+SDLGlyph *SDLFontEngine::getGlyph(uint32_t codepoint) {
+	SDLGlyph *glyph;
+	if (codepoint < active_font->glyphs.size())
+		glyph = &(active_font->glyphs[codepoint]);
+	else
+		glyph = &(active_font->glyphs_extended[codepoint]);
+
+	if (!glyph->loaded) {
+		glyph->loaded = true;
+
+		int miny, maxy;
+#ifdef TTF_HAS_GLYPH32
+		int status = TTF_GlyphMetrics32(active_font->ttfont, codepoint, &glyph->minx, &glyph->maxx, &miny, &maxy, &glyph->advance);
+#else
+		int status = TTF_GlyphMetrics(active_font->ttfont, static_cast<Uint16>(codepoint), &glyph->minx, &glyph->maxx, &miny, &maxy, &glyph->advance);
+#endif
+		if (status != 0) {
+			glyph->minx = 0;
+			glyph->maxx = 0;
+			glyph->advance = 0;
+		}
+	}
+
+	return glyph;
+}
+
+int SDLFontEngine::getKerning(uint32_t prev_codepoint, uint32_t codepoint) {
+	if (!active_font->use_kerning)
+		return 0;
+
+	uint64_t key = (static_cast<uint64_t>(prev_codepoint) << 32) | codepoint;
+	std::map<uint64_t, int>::iterator it = active_font->kerning.find(key);
+	if (it != active_font->kerning.end())
+		return it->second;
+
+	int kerning = 0;
+#if defined(TTF_HAS_GLYPH32)
+	kerning = TTF_GetFontKerningSizeGlyphs32(active_font->ttfont, prev_codepoint, codepoint);
+#elif defined(TTF_HAS_GLYPH_KERNING)
+	kerning = TTF_GetFontKerningSizeGlyphs(active_font->ttfont, static_cast<Uint16>(prev_codepoint), static_cast<Uint16>(codepoint));
+#endif
+
+	active_font->kerning[key] = kerning;
+	return kerning;
+}
+
+/**
+ * Places the glyphs of a single line of text the same way SDL_ttf does, using the cached metrics.
+ * Glyph positions are relative to the left edge of the text. Either output can be NULL.
+ * Returns false if the text can't be handled glyph by glyph (see needsShaping()).
+ */
+bool SDLFontEngine::layoutText(const std::string& text, std::vector<GlyphPosition> *positions, int *width) {
+	if (positions)
+		positions->clear();
+
+	int pen_x = 0;
+	int min_x = 0;
+	int max_x = 0;
+	uint32_t prev_codepoint = 0;
+
+	size_t pos = 0;
+	while (pos < text.length()) {
+		uint32_t codepoint = decodeUTF8(text, pos);
+		if (needsShaping(codepoint))
+			return false;
+
+		SDLGlyph *glyph = getGlyph(codepoint);
+
+		if (prev_codepoint != 0)
+			pen_x += getKerning(prev_codepoint, codepoint);
+
+		min_x = std::min(min_x, pen_x + glyph->minx);
+		max_x = std::max(max_x, pen_x + std::max(glyph->advance, glyph->maxx));
+
+		if (positions) {
+			GlyphPosition glyph_pos;
+			glyph_pos.codepoint = codepoint;
+			glyph_pos.glyph = glyph;
+			glyph_pos.x = pen_x;
+			positions->push_back(glyph_pos);
+		}
+
+		pen_x += glyph->advance;
+		prev_codepoint = codepoint;
+	}
+
+	if (positions) {
+		// glyphs that reach left of the starting position push the whole line to the right
+		for (size_t i = 0; i < positions->size(); ++i) {
+			(*positions)[i].x -= min_x;
+		}
+	}
+
+	if (width)
+		*width = max_x - min_x;
+
+	return true;
+}
+
+/**
+ * Renders a glyph in white and copies its visible pixels into the atlas.
+ */
+void SDLFontEngine::rasterizeGlyph(uint32_t codepoint, SDLGlyph *glyph) {
+	glyph->rasterized = true;
+	glyph->page = -1;
+
+	Color white(255, 255, 255);
+	SDL_Surface *cleanup;
+#ifdef TTF_HAS_GLYPH32
+	if (active_font->blend)
+		cleanup = TTF_RenderGlyph32_Blended(active_font->ttfont, codepoint, white);
+	else
+		cleanup = TTF_RenderGlyph32_Solid(active_font->ttfont, codepoint, white);
+#else
+	if (active_font->blend)
+		cleanup = TTF_RenderGlyph_Blended(active_font->ttfont, static_cast<Uint16>(codepoint), white);
+	else
+		cleanup = TTF_RenderGlyph_Solid(active_font->ttfont, static_cast<Uint16>(codepoint), white);
+#endif
+	if (!cleanup)
+		return;
+
+	SDL_Surface *rendered = SDL_ConvertSurfaceFormat(cleanup, SDL_PIXELFORMAT_ARGB8888, 0);
+	SDL_FreeSurface(cleanup);
+	if (!rendered)
+		return;
+
+	// only the visible part of the glyph is stored
+	int left = rendered->w;
+	int right = -1;
+	int top = rendered->h;
+	int bottom = -1;
+
+	SDL_LockSurface(rendered);
+	for (int y = 0; y < rendered->h; ++y) {
+		const Uint32 *row = reinterpret_cast<const Uint32 *>(static_cast<Uint8 *>(rendered->pixels) + y * rendered->pitch);
+		for (int x = 0; x < rendered->w; ++x) {
+			if (row[x] >> 24) {
+				left = std::min(left, x);
+				right = std::max(right, x);
+				top = std::min(top, y);
+				bottom = std::max(bottom, y);
+			}
+		}
+	}
+	SDL_UnlockSurface(rendered);
+
+	if (right < left) {
+		SDL_FreeSurface(rendered);
+		return;
+	}
+
+	SDL_Rect src;
+	src.x = left;
+	src.y = top;
+	src.w = right - left + 1;
+	src.h = bottom - top + 1;
+
+	// glyphs are packed in rows, with a pixel of space around them so that filtering doesn't pick up their neighbours
+	SDLGlyphPage *page = (active_font->pages.empty() ? NULL : &(active_font->pages.back()));
+	if (page && page->cursor.x + src.w > page->surface->w) {
+		page->cursor.x = 0;
+		page->cursor.y += page->row_height + 1;
+		page->row_height = 0;
+	}
+	if (!page || page->cursor.y + src.h > page->surface->h) {
+		int page_size = GLYPH_PAGE_SIZE;
+		page_size = std::max(page_size, std::max(src.w, src.h));
+
+		SDLGlyphPage new_page;
+		new_page.surface = SDL_CreateRGBSurface(0, page_size, page_size, 32, 0x00ff0000, 0x0000ff00, 0x000000ff, 0xff000000);
+		if (!new_page.surface) {
+			Utils::logError("SDLFontEngine: Unable to create glyph atlas page: %s", SDL_GetError());
+			SDL_FreeSurface(rendered);
+			return;
+		}
+		// transparent white, so that filtering at the glyph edges doesn't blend in black
+		SDL_FillRect(new_page.surface, NULL, 0x00ffffff);
+
+		active_font->pages.push_back(new_page);
+		page = &(active_font->pages.back());
+	}
+
+	SDL_Rect dest;
+	dest.x = page->cursor.x;
+	dest.y = page->cursor.y;
+	dest.w = src.w;
+	dest.h = src.h;
+
+	SDL_SetSurfaceBlendMode(rendered, SDL_BLENDMODE_NONE);
+	SDL_BlitSurface(rendered, &src, page->surface, &dest);
+	SDL_FreeSurface(rendered);
+
+	glyph->page = static_cast<int>(active_font->pages.size()) - 1;
+	glyph->src = Rect(page->cursor.x, page->cursor.y, src.w, src.h);
+	// SDL_ttf shifts the glyph right when it extends left of the pen position
+	glyph->offset.x = std::min(0, glyph->minx) + src.x;
+	glyph->offset.y = src.y;
+
+	page->cursor.x += src.w + 1;
+	page->row_height = std::max(page->row_height, src.h);
+	page->version++;
+}
+
+/**
+ * Returns the atlas pages, updating the ones that have new glyphs
+ */
+SDLGlyphAtlas *SDLFontEngine::getGlyphAtlas() {
+	SDLGlyphAtlas *atlas = &(active_font->atlas);
+
+	// images made for a previous render context can't be drawn anymore
+	if (atlas->context_version != render_device->getContextVersion()) {
+		for (size_t i = 0; i < atlas->sprites.size(); ++i) {
+			delete atlas->sprites[i];
+		}
+		atlas->sprites.clear();
+		atlas->versions.clear();
+		atlas->context_version = render_device->getContextVersion();
+	}
+
+	const std::vector<SDLGlyphPage>& pages = active_font->pages;
+	atlas->sprites.resize(pages.size(), NULL);
+	atlas->versions.resize(pages.size(), 0);
+
+	for (size_t i = 0; i < pages.size(); ++i) {
+		if (atlas->sprites[i] && atlas->versions[i] == pages[i].version)
+			continue;
+
+		Image *graphics = render_device->createImageFromSurface(pages[i].surface);
+
+		delete atlas->sprites[i];
+		atlas->sprites[i] = NULL;
+
+		if (graphics) {
+			atlas->sprites[i] = graphics->createSprite();
+			graphics->unref();
+		}
+		atlas->versions[i] = pages[i].version;
+	}
+
+	return atlas;
+}
+
+void SDLFontEngine::clearGlyphAtlas(SDLFontStyle *style) {
+	for (size_t i = 0; i < style->atlas.sprites.size(); ++i) {
+		delete style->atlas.sprites[i];
+	}
+	style->atlas.sprites.clear();
+	style->atlas.versions.clear();
+
+	for (size_t i = 0; i < style->pages.size(); ++i) {
+		SDL_FreeSurface(style->pages[i].surface);
+	}
+	style->pages.clear();
+}
+
 /**
  * Render the given text at (x,y) on the target image.
  * Justify is left, right, or center
@@ -228,9 +580,82 @@ void SDLFontEngine::renderInternal(const std::string& text, int x, int y, int ju
 	if (!isActiveFontValid() || text.empty())
 		return;
 
+	Rect dest_rect = position(text, x, y, justify);
+
+	if (!layoutText(text, &glyph_positions, NULL)) {
+		renderLegacy(text, dest_rect, target, color);
+		return;
+	}
+
+	if (active_font->pages.empty()) {
+		// most text is plain ASCII, so put all of it on the first page in one go
+		for (uint32_t codepoint = 33; codepoint < 127; ++codepoint) {
+			SDLGlyph *glyph = getGlyph(codepoint);
+			if (!glyph->rasterized)
+				rasterizeGlyph(codepoint, glyph);
+		}
+	}
+
+	for (size_t i = 0; i < glyph_positions.size(); ++i) {
+		if (!glyph_positions[i].glyph->rasterized)
+			rasterizeGlyph(glyph_positions[i].codepoint, glyph_positions[i].glyph);
+	}
+
+	SDLGlyphAtlas *atlas = getGlyphAtlas();
+
+	// Render text into target
+	// We render the same thing twice because blending with itself produces visually clearer text, especially on noisy backgrounds
+	// Glyphs drawn into an image are batched for as long as they come from the same atlas page, so that the
+	// render target is only switched once for most strings.
+	Sprite *batch_sprite = NULL;
+	batch_src.clear();
+	batch_dest.clear();
+
+	for (int pass = 0; pass < 2; ++pass) {
+		for (size_t i = 0; i < glyph_positions.size(); ++i) {
+			const SDLGlyph *glyph = glyph_positions[i].glyph;
+			if (glyph->page < 0)
+				continue;
+
+			Sprite *glyph_sprite = atlas->sprites[glyph->page];
+			if (!glyph_sprite)
+				continue;
+
+			Rect src = glyph->src;
+			Rect dest(dest_rect.x + glyph_positions[i].x + glyph->offset.x, dest_rect.y + glyph->offset.y, src.w, src.h);
+
+			if (target) {
+				if (glyph_sprite != batch_sprite && !batch_src.empty()) {
+					render_device->renderToImageBatch(batch_sprite->getGraphics(), batch_src, target, batch_dest, color);
+					batch_src.clear();
+					batch_dest.clear();
+				}
+				batch_sprite = glyph_sprite;
+				batch_src.push_back(src);
+				batch_dest.push_back(dest);
+			}
+			else {
+				// no target, so just render to the screen
+				glyph_sprite->color_mod = Color(color.r, color.g, color.b);
+				glyph_sprite->alpha_mod = color.a;
+				glyph_sprite->setClipFromRect(src);
+				glyph_sprite->setDestFromRect(dest);
+				render_device->render(glyph_sprite);
+			}
+		}
+	}
+
+	if (!batch_src.empty())
+		render_device->renderToImageBatch(batch_sprite->getGraphics(), batch_src, target, batch_dest, color);
+}
+
+/**
+ * Renders the whole string with SDL_ttf, for text that the glyph atlas can't handle
+ */
+void SDLFontEngine::renderLegacy(const std::string& text, const Rect& dest_rect, Image *target, const Color& color) {
 	Image *graphics;
 
-	Rect dest_rect = position(text, x, y, justify);
+	Rect dest = dest_rect;
 
 	// Render text into target
 	// We render the same thing twice because blending with itself produces visually clearer text, especially on noisy backgrounds
@@ -240,14 +665,14 @@ void SDLFontEngine::renderInternal(const std::string& text, int x, int y, int ju
 			Rect clip;
 			clip.w = graphics->getWidth();
 			clip.h = graphics->getHeight();
-			render_device->renderToImage(graphics, clip, target, dest_rect);
-			render_device->renderToImage(graphics, clip, target, dest_rect);
+			render_device->renderToImage(graphics, clip, target, dest);
+			render_device->renderToImage(graphics, clip, target, dest);
 		}
 		else {
 			// no target, so just render to the screen
 			Sprite* temp_sprite = graphics->createSprite();
 			if (temp_sprite) {
-				temp_sprite->setDestFromRect(dest_rect);
+				temp_sprite->setDestFromRect(dest);
 				render_device->render(temp_sprite);
 				render_device->render(temp_sprite);
 				delete temp_sprite;
@@ -260,7 +685,9 @@ void SDLFontEngine::renderInternal(const std::string& text, int x, int y, int ju
 }
 
 SDLFontEngine::~SDLFontEngine() {
-	for (unsigned int i=0; i<font_styles.size(); ++i) TTF_CloseFont(font_styles[i].ttfont);
+	for (unsigned int i=0; i<font_styles.size(); ++i) {
+		clearGlyphAtlas(&font_styles[i]);
+		TTF_CloseFont(font_styles[i].ttfont);
+	}
 	TTF_Quit();
 }
-
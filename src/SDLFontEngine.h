@@ -23,12 +23,66 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 #include "FontEngine.h"
 #include <SDL_ttf.h>
 
+/**
+ * Metrics and atlas location of a single glyph
+ */
+class SDLGlyph {
+public:
+	SDLGlyph();
+
+	bool loaded;
+	bool rasterized;
+
+	int minx;
+	int maxx;
+	int advance;
+
+	// location of the glyph's pixels in the atlas. page is -1 for glyphs with nothing to draw (e.g. spaces)
+	int page;
+	Rect src;
+	Point offset; // relative to the pen position at the top of the line
+};
+
+/**
+ * A page of the glyph atlas. Glyphs are rasterized once in white and packed into rows.
+ */
+class SDLGlyphPage {
+public:
+	SDLGlyphPage();
+
+	SDL_Surface *surface;
+	Point cursor;
+	int row_height;
+	unsigned version; // increases whenever a glyph is added
+};
+
+/**
+ * The glyph atlas pages as images. They stay white, the text color is applied when drawing.
+ */
+class SDLGlyphAtlas {
+public:
+	SDLGlyphAtlas();
+
+	unsigned context_version;
+	std::vector<Sprite *> sprites; // one per page
+	std::vector<unsigned> versions;
+};
+
 class SDLFontStyle : public FontStyle {
 public:
 	SDLFontStyle();
 	~SDLFontStyle() {};
 
 	TTF_Font *ttfont;
+
+	// glyphs for the first 256 code points are looked up directly, everything else goes through the map
+	std::vector<SDLGlyph> glyphs;
+	std::map<uint32_t, SDLGlyph> glyphs_extended;
+	std::map<uint64_t, int> kerning;
+	bool use_kerning;
+
+	std::vector<SDLGlyphPage> pages;
+	SDLGlyphAtlas atlas;
 };
 
 /**
@@ -40,12 +94,36 @@ public:
 
 class SDLFontEngine : public FontEngine {
 private:
+	class GlyphPosition {
+	public:
+		uint32_t codepoint;
+		SDLGlyph *glyph;
+		int x;
+	};
+
+	static const int GLYPH_PAGE_SIZE = 256;
+
 	bool isActiveFontValid();
 
+	SDLGlyph *getGlyph(uint32_t codepoint);
+	int getKerning(uint32_t prev_codepoint, uint32_t codepoint);
+	bool layoutText(const std::string& text, std::vector<GlyphPosition> *positions, int *width);
+	void rasterizeGlyph(uint32_t codepoint, SDLGlyph *glyph);
+	SDLGlyphAtlas *getGlyphAtlas();
+	void clearGlyphAtlas(SDLFontStyle *style);
+	void renderLegacy(const std::string& text, const Rect& dest_rect, Image *target, const Color& color);
+
 	std::vector<SDLFontStyle> font_styles;
 	SDLFontStyle *active_font;
 
+	std::vector<GlyphPosition> glyph_positions;
+
+	// glyphs waiting to be drawn into an image from the same atlas page
+	std::vector<Rect> batch_src;
+	std::vector<Rect> batch_dest;
+
 protected:
+	FontStyle* getActiveFont();
 	void renderInternal(const std::string& text, int x, int y, int justify, Image *target, const Color& color);
 
 public:
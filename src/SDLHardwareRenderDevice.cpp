@@ -32,6 +32,7 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 #include "MessageEngine.h"
 #include "ModManager.h"
 #include "Platform.h"
+#include "Profiler.h"
 #include "SharedResources.h"
 #include "Settings.h"
 
@@ -224,6 +225,34 @@ void SDLHardwareImage::endPixelBatch() {
 	pixel_batch_type = PIXEL_BATCH_NONE;
 }
 
+/**
+ * Replaces the pixels in area with those of src, without blending
+ */
+void SDLHardwareImage::copyFromSurface(SDL_Surface* src, const Rect& area) {
+	if (!surface || !src) return;
+	if (area.x < 0 || area.y < 0 || area.w <= 0 || area.h <= 0) return;
+	if (area.x + area.w > src->w || area.y + area.h > src->h) return;
+	if (area.x + area.w > getWidth() || area.y + area.h > getHeight()) return;
+
+	Uint32 format;
+	if (SDL_QueryTexture(surface, &format, NULL, NULL, NULL) != 0)
+		return;
+
+	SDL_Rect dest(area);
+	const Uint8* pixels = static_cast<const Uint8*>(src->pixels) + area.y * src->pitch + area.x * src->format->BytesPerPixel;
+
+	if (format == src->format->format) {
+		SDL_UpdateTexture(surface, &dest, pixels, src->pitch);
+	}
+	else {
+		// the renderer picked a different layout for this texture, so convert just the area being replaced
+		int pitch = area.w * SDL_BYTESPERPIXEL(format);
+		std::vector<Uint8> converted(static_cast<size_t>(pitch) * area.h);
+		if (SDL_ConvertPixels(area.w, area.h, src->format->format, pixels, src->pitch, format, &converted[0], pitch) == 0)
+			SDL_UpdateTexture(surface, &dest, &converted[0], pitch);
+	}
+}
+
 Image* SDLHardwareImage::resize(int width, int height) {
 	if(!surface || width <= 0 || height <= 0)
 		return NULL;
@@ -257,6 +286,8 @@ SDLHardwareRenderDevice::SDLHardwareRenderDevice()
 	, titlebar_icon(NULL)
 	, title(NULL)
 	, background_color(0,0,0,255)
+	, blend_premultiplied(SDL_BLENDMODE_BLEND)
+	, premultiplied_alpha(false)
 {
 	Utils::logInfo("Using Render Device: SDLHardwareRenderDevice (hardware, SDL 2, %s)", SDL_GetCurrentVideoDriver());
 
@@ -371,6 +402,17 @@ int SDLHardwareRenderDevice::createContextInternal() {
 			SDL_GetRendererInfo(renderer, &renderer_info);
 			Utils::logInfo("RenderDevice: Renderer driver is '%s'.", renderer_info.name);
 
+			premultiplied_alpha = false;
+#if SDL_VERSION_ATLEAST(2, 0, 6)
+			// not every renderer supports custom blend modes, so try it out on a small texture
+			blend_premultiplied = SDL_ComposeCustomBlendMode(SDL_BLENDFACTOR_ONE, SDL_BLENDFACTOR_ONE_MINUS_SRC_ALPHA, SDL_BLENDOPERATION_ADD, SDL_BLENDFACTOR_ONE, SDL_BLENDFACTOR_ONE_MINUS_SRC_ALPHA, SDL_BLENDOPERATION_ADD);
+			SDL_Texture *test_texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STATIC, 1, 1);
+			if (test_texture) {
+				premultiplied_alpha = (SDL_SetTextureBlendMode(test_texture, blend_premultiplied) == 0);
+				SDL_DestroyTexture(test_texture);
+			}
+#endif
+
 #if SDL_VERSION_ATLEAST(2, 0, 4)
 			SDL_GetDisplayDPI(0, &ddpi, 0, 0);
 			Utils::logInfo("RenderDevice: Display DPI is %f", ddpi);
@@ -394,6 +436,9 @@ int SDLHardwareRenderDevice::createContextInternal() {
 	}
 
 	if (is_initialized) {
+		// the textures of the images still in use went away with the previous renderer
+		cacheRestoreContext();
+
 		// update title bar text and icon
 		updateTitleBar();
 
@@ -421,6 +466,8 @@ void SDLHardwareRenderDevice::createContextError() {
 }
 
 int SDLHardwareRenderDevice::render(Renderable& r, Rect& dest) {
+	Profiler::addCount(Profiler::COUNTER_DRAW_CALLS);
+
 	dest.w = r.src.w;
 	dest.h = r.src.h;
     SDL_Rect src = r.src;
@@ -429,14 +476,26 @@ int SDLHardwareRenderDevice::render(Renderable& r, Rect& dest) {
 
 	SDL_Texture *surface = static_cast<SDLHardwareImage *>(r.image)->surface;
 
+	Color color_mod = r.color_mod;
+
 	if (r.blend_mode == Renderable::BLEND_ADD) {
 		SDL_SetTextureBlendMode(surface, SDL_BLENDMODE_ADD);
 	}
+	else if (r.blend_mode == Renderable::BLEND_PREMULTIPLIED && premultiplied_alpha) {
+		SDL_SetTextureBlendMode(surface, blend_premultiplied);
+
+		// the alpha mod only scales the alpha channel, but the colors carry the alpha too
+		if (r.alpha_mod != 255) {
+			color_mod.r = static_cast<Uint8>((color_mod.r * r.alpha_mod) / 255);
+			color_mod.g = static_cast<Uint8>((color_mod.g * r.alpha_mod) / 255);
+			color_mod.b = static_cast<Uint8>((color_mod.b * r.alpha_mod) / 255);
+		}
+	}
 	else { // Renderable::BLEND_NORMAL
 		SDL_SetTextureBlendMode(surface, SDL_BLENDMODE_BLEND);
 	}
 
-	SDL_SetTextureColorMod(surface, r.color_mod.r, r.color_mod.g, r.color_mod.b);
+	SDL_SetTextureColorMod(surface, color_mod.r, color_mod.g, color_mod.b);
 	SDL_SetTextureAlphaMod(surface, r.alpha_mod);
 
 	return SDL_RenderCopy(renderer, surface, &src, &_dest);
@@ -450,6 +509,8 @@ int SDLHardwareRenderDevice::render(Sprite *r) {
 		return -1;
 	}
 
+	Profiler::addCount(Profiler::COUNTER_DRAW_CALLS);
+
 	// negative x and y clip causes weird stretching
 	// adjust for that here
 	if (m_clip.x < 0) {
@@ -489,8 +550,38 @@ int SDLHardwareRenderDevice::renderToImage(Image* src_image, Rect& src, Image* d
     SDL_Rect _src = src;
     SDL_Rect _dest = dest;
 
+	// draw the source as it is, not with the modifiers it was last rendered with
+	SDL_Texture *src_texture = static_cast<SDLHardwareImage *>(src_image)->surface;
+	SDL_SetTextureBlendMode(src_texture, SDL_BLENDMODE_BLEND);
+	SDL_SetTextureColorMod(src_texture, 255, 255, 255);
+	SDL_SetTextureAlphaMod(src_texture, 255);
+
 	SDL_SetTextureBlendMode(static_cast<SDLHardwareImage *>(dest_image)->surface, SDL_BLENDMODE_BLEND);
-	SDL_RenderCopy(renderer, static_cast<SDLHardwareImage *>(src_image)->surface, &_src, &_dest);
+	SDL_RenderCopy(renderer, src_texture, &_src, &_dest);
+	SDL_SetRenderTarget(renderer, NULL);
+	return 0;
+}
+
+int SDLHardwareRenderDevice::renderToImageBatch(Image* src_image, const std::vector<Rect>& src, Image* dest_image, const std::vector<Rect>& dest, const Color& color_mod) {
+	if (!src_image || !dest_image)
+		return -1;
+
+	if (SDL_SetRenderTarget(renderer, static_cast<SDLHardwareImage *>(dest_image)->surface) != 0)
+		return -1;
+
+	SDL_Texture *src_texture = static_cast<SDLHardwareImage *>(src_image)->surface;
+	SDL_SetTextureBlendMode(src_texture, SDL_BLENDMODE_BLEND);
+	SDL_SetTextureColorMod(src_texture, color_mod.r, color_mod.g, color_mod.b);
+	SDL_SetTextureAlphaMod(src_texture, color_mod.a);
+
+	SDL_SetTextureBlendMode(static_cast<SDLHardwareImage *>(dest_image)->surface, SDL_BLENDMODE_BLEND);
+	for (size_t i = 0; i < src.size() && i < dest.size(); ++i) {
+		SDL_Rect _src = src[i];
+		SDL_Rect _dest = dest[i];
+		_dest.w = _src.w;
+		_dest.h = _src.h;
+		SDL_RenderCopy(renderer, src_texture, &_src, &_dest);
+	}
 	SDL_SetRenderTarget(renderer, NULL);
 	return 0;
 }
@@ -556,8 +647,8 @@ void SDLHardwareRenderDevice::commitFrame() {
 void SDLHardwareRenderDevice::destroyContext() {
 	resetGamma();
 
-	// we need to free all loaded graphics as they may be tied to the current context
-	RenderDevice::cacheRemoveAll();
+	// textures are tied to the renderer, so the cached images that are still in use are reloaded with the next one
+	RenderDevice::cacheReleaseContext();
 	reload_graphics = true;
 
 	if (icons) {
@@ -613,6 +704,25 @@ Image *SDLHardwareRenderDevice::createImage(int width, int height) {
 	return image;
 }
 
+/**
+ * Uploads a copy of the surface's pixels to a new texture
+ */
+Image *SDLHardwareRenderDevice::createImageFromSurface(SDL_Surface *surface) {
+	if (!surface)
+		return NULL;
+
+	SDLHardwareImage *image = new SDLHardwareImage(this, renderer);
+
+	image->surface = SDL_CreateTextureFromSurface(renderer, surface);
+	if (image->surface == NULL) {
+		Utils::logError("SDLHardwareRenderDevice: SDL_CreateTextureFromSurface failed: %s", SDL_GetError());
+		delete image;
+		return NULL;
+	}
+
+	return image;
+}
+
 void SDLHardwareRenderDevice::setGamma(float g) {
 	Uint16 ramp[256];
 	SDL_CalculateGammaRamp(g, ramp);
@@ -632,12 +742,29 @@ void SDLHardwareRenderDevice::updateTitleBar() {
 	if (!window) return;
 
 	title = Utils::strdup(msg->get(eset->misc.window_title));
-	titlebar_icon = IMG_Load(mods->locate("images/logo/icon.png").c_str());
+	titlebar_icon = IMG_Load_RW(mods->openRW(mods->locate("images/logo/icon.png")), 1);
 
 	if (title) SDL_SetWindowTitle(window, title);
 	if (titlebar_icon) SDL_SetWindowIcon(window, titlebar_icon);
 }
 
+void SDLHardwareRenderDevice::releaseImageContext(Image *image) {
+	SDLHardwareImage *hw_image = static_cast<SDLHardwareImage *>(image);
+	if (hw_image->surface) {
+		SDL_DestroyTexture(hw_image->surface);
+		hw_image->surface = NULL;
+	}
+}
+
+void SDLHardwareRenderDevice::restoreImageContext(const std::string &filename, Image *image) {
+	SDLHardwareImage *hw_image = static_cast<SDLHardwareImage *>(image);
+	hw_image->renderer = renderer;
+	hw_image->surface = IMG_LoadTexture_RW(renderer, mods->openRW(mods->locate(filename)), 1);
+
+	if (hw_image->surface == NULL)
+		Utils::logError("SDLHardwareRenderDevice: Couldn't reload image: '%s'. %s", filename.c_str(), IMG_GetError());
+}
+
 Image *SDLHardwareRenderDevice::loadImage(const std::string& filename, int error_type) {
 	// lookup image in cache
 	Image *img;
@@ -648,7 +775,7 @@ Image *SDLHardwareRenderDevice::loadImage(const std::string& filename, int error
 	SDLHardwareImage *image = new SDLHardwareImage(this, renderer);
 	if (!image) return NULL;
 
-	image->surface = IMG_LoadTexture(renderer, mods->locate(filename).c_str());
+	image->surface = IMG_LoadTexture_RW(renderer, mods->openRW(mods->locate(filename)), 1);
 
 	if(image->surface == NULL) {
 		delete image;
@@ -730,3 +857,7 @@ unsigned short SDLHardwareRenderDevice::getRefreshRate() {
 	return static_cast<unsigned short>(mode.refresh_rate);
 }
 
+bool SDLHardwareRenderDevice::supportsPremultipliedAlpha() {
+	return premultiplied_alpha;
+}
+
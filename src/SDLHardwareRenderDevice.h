@@ -49,6 +49,7 @@ public:
 	void beginPixelBatch();
 	void beginPixelBatch(Rect& bounds);
 	void endPixelBatch();
+	void copyFromSurface(SDL_Surface* src, const Rect& area);
 	Image* resize(int width, int height);
 
 	SDL_Renderer *renderer;
@@ -77,6 +78,7 @@ public:
 	virtual int render(Renderable& r, Rect& dest);
 	virtual int render(Sprite* r);
 	virtual int renderToImage(Image* src_image, Rect& src, Image* dest_image, Rect& dest);
+	virtual int renderToImageBatch(Image* src_image, const std::vector<Rect>& src, Image* dest_image, const std::vector<Rect>& dest, const Color& color_mod);
 
 	Image *renderTextToImage(FontStyle* font_style, const std::string& text, const Color& color, bool blended);
 	void drawPixel(int x, int y, const Color& color);
@@ -89,16 +91,20 @@ public:
 	void setBackgroundColor(Color color);
 	void setFullscreen(bool enable_fullscreen);
 	Image *createImage(int width, int height);
+	Image *createImageFromSurface(SDL_Surface *surface);
 	void setGamma(float g);
 	void resetGamma();
 	void updateTitleBar();
 	unsigned short getRefreshRate();
+	bool supportsPremultipliedAlpha();
 
 	Image* loadImage(const std::string& filename, int error_type);
 
 protected:
 	int createContextInternal();
 	void createContextError();
+	void releaseImageContext(Image *image);
+	void restoreImageContext(const std::string &filename, Image *image);
 
 private:
 	void getWindowSize(short unsigned *screen_w, short unsigned *screen_h);
@@ -110,6 +116,10 @@ private:
 	char* title;
 	Color background_color;
 
+	// custom blend mode for Renderable::BLEND_PREMULTIPLIED, if the renderer has one
+	SDL_BlendMode blend_premultiplied;
+	bool premultiplied_alpha;
+
 	/* Stores the system gamma levels so they can be restored later */
 	uint16_t gamma_r[256];
 	uint16_t gamma_g[256];
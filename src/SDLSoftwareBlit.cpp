@@ -0,0 +1,515 @@
+/*
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+/**
+ * namespace SoftwareBlit
+ */
+
+#include "SDLSoftwareBlit.h"
+
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define FLARE_BLIT_X86
+#include <emmintrin.h>
+#include <immintrin.h>
+#if defined(__GNUC__) || defined(__clang__)
+#define FLARE_BLIT_TARGET_SSE2 __attribute__((target("sse2")))
+#define FLARE_BLIT_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define FLARE_BLIT_TARGET_SSE2
+#define FLARE_BLIT_TARGET_AVX2
+#endif
+#endif
+
+namespace SoftwareBlit {
+
+int current_isa = -1;
+
+/**
+ * Pixels are 0xAARRGGBB, so in memory (little-endian) the channel order is B, G, R, A.
+ * Modulation factors are stored in that order as well.
+ */
+struct Modulation {
+	uint16_t f[4];
+
+	Modulation(const Color& color_mod, uint8_t alpha_mod) {
+		f[0] = color_mod.b;
+		f[1] = color_mod.g;
+		f[2] = color_mod.r;
+		f[3] = alpha_mod;
+	}
+};
+
+// (a * b) / 255, rounded. Exact for all 8-bit inputs.
+inline uint32_t mulDiv255(uint32_t a, uint32_t b) {
+	uint32_t t = a * b + 128;
+	return (t + (t >> 8)) >> 8;
+}
+
+void blitRowScalar(uint32_t* dst, const uint32_t* src, int count, int mode, const Modulation& mod) {
+	for (int i = 0; i < count; ++i) {
+		uint32_t s = src[i];
+		uint32_t sa = s >> 24;
+
+		if (mode != MODE_COPY && sa == 0)
+			continue;
+
+		uint32_t sb = mulDiv255(s & 0xff, mod.f[0]);
+		uint32_t sg = mulDiv255((s >> 8) & 0xff, mod.f[1]);
+		uint32_t sr = mulDiv255((s >> 16) & 0xff, mod.f[2]);
+		sa = mulDiv255(sa, mod.f[3]);
+
+		if (mode == MODE_COPY) {
+			dst[i] = (sa << 24) | (sr << 16) | (sg << 8) | sb;
+			continue;
+		}
+
+		uint32_t d = dst[i];
+		uint32_t db = d & 0xff;
+		uint32_t dg = (d >> 8) & 0xff;
+		uint32_t dr = (d >> 16) & 0xff;
+		uint32_t da = d >> 24;
+
+		if (mode == MODE_ADD) {
+			db = std::min(db + mulDiv255(sb, sa), 255u);
+			dg = std::min(dg + mulDiv255(sg, sa), 255u);
+			dr = std::min(dr + mulDiv255(sr, sa), 255u);
+		}
+		else if (mode == MODE_PREMULTIPLIED) {
+			// the colors already carry the source alpha, but not the alpha mod
+			uint32_t inv = 255 - sa;
+			db = std::min(mulDiv255(sb, mod.f[3]) + mulDiv255(db, inv), 255u);
+			dg = std::min(mulDiv255(sg, mod.f[3]) + mulDiv255(dg, inv), 255u);
+			dr = std::min(mulDiv255(sr, mod.f[3]) + mulDiv255(dr, inv), 255u);
+			da = std::min(sa + mulDiv255(da, inv), 255u);
+		}
+		else {
+			uint32_t inv = 255 - sa;
+			db = std::min(mulDiv255(sb, sa) + mulDiv255(db, inv), 255u);
+			dg = std::min(mulDiv255(sg, sa) + mulDiv255(dg, inv), 255u);
+			dr = std::min(mulDiv255(sr, sa) + mulDiv255(dr, inv), 255u);
+			da = std::min(sa + mulDiv255(da, inv), 255u);
+		}
+
+		dst[i] = (da << 24) | (dr << 16) | (dg << 8) | db;
+	}
+}
+
+#ifdef FLARE_BLIT_X86
+
+FLARE_BLIT_TARGET_SSE2
+inline __m128i mulDiv255SSE2(__m128i a, __m128i b) {
+	__m128i t = _mm_add_epi16(_mm_mullo_epi16(a, b), _mm_set1_epi16(128));
+	return _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+}
+
+/**
+ * Works on four pixels at a time, with each channel widened to 16 bits.
+ * Blocks where every source pixel is fully transparent are skipped when blending.
+ */
+FLARE_BLIT_TARGET_SSE2
+void blitRowSSE2(uint32_t* dst, const uint32_t* src, int count, int mode, const Modulation& mod) {
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i full = _mm_set1_epi16(255);
+	const __m128i alpha_lanes = _mm_set_epi16(-1, 0, 0, 0, -1, 0, 0, 0);
+	const __m128i alpha_bytes = _mm_set1_epi32(static_cast<int>(0xff000000));
+	const __m128i factor = _mm_set_epi16(
+		static_cast<short>(mod.f[3]), static_cast<short>(mod.f[2]), static_cast<short>(mod.f[1]), static_cast<short>(mod.f[0]),
+		static_cast<short>(mod.f[3]), static_cast<short>(mod.f[2]), static_cast<short>(mod.f[1]), static_cast<short>(mod.f[0])
+	);
+
+	int i = 0;
+	for (; i + 4 <= count; i += 4) {
+		__m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+
+		if (mode != MODE_COPY && _mm_movemask_epi8(_mm_cmpeq_epi32(_mm_and_si128(s, alpha_bytes), zero)) == 0xffff)
+			continue;
+
+		__m128i s_lo = mulDiv255SSE2(_mm_unpacklo_epi8(s, zero), factor);
+		__m128i s_hi = mulDiv255SSE2(_mm_unpackhi_epi8(s, zero), factor);
+
+		__m128i out;
+		if (mode == MODE_COPY) {
+			out = _mm_packus_epi16(s_lo, s_hi);
+		}
+		else {
+			// broadcast each pixel's alpha to its four lanes
+			__m128i a_lo = _mm_shufflehi_epi16(_mm_shufflelo_epi16(s_lo, 0xff), 0xff);
+			__m128i a_hi = _mm_shufflehi_epi16(_mm_shufflelo_epi16(s_hi, 0xff), 0xff);
+			__m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dst + i));
+
+			if (mode == MODE_ADD) {
+				// destination alpha is left untouched
+				a_lo = _mm_andnot_si128(alpha_lanes, a_lo);
+				a_hi = _mm_andnot_si128(alpha_lanes, a_hi);
+				out = _mm_packus_epi16(mulDiv255SSE2(s_lo, a_lo), mulDiv255SSE2(s_hi, a_hi));
+				out = _mm_adds_epu8(out, d);
+			}
+			else {
+				__m128i d_lo = _mm_unpacklo_epi8(d, zero);
+				__m128i d_hi = _mm_unpackhi_epi8(d, zero);
+				__m128i inv_lo = _mm_sub_epi16(full, a_lo);
+				__m128i inv_hi = _mm_sub_epi16(full, a_hi);
+				// the source alpha channel is multiplied by 255 instead of by itself
+				a_lo = _mm_or_si128(_mm_andnot_si128(alpha_lanes, a_lo), _mm_and_si128(alpha_lanes, full));
+				a_hi = _mm_or_si128(_mm_andnot_si128(alpha_lanes, a_hi), _mm_and_si128(alpha_lanes, full));
+				__m128i o_lo = _mm_add_epi16(mulDiv255SSE2(s_lo, a_lo), mulDiv255SSE2(d_lo, inv_lo));
+				__m128i o_hi = _mm_add_epi16(mulDiv255SSE2(s_hi, a_hi), mulDiv255SSE2(d_hi, inv_hi));
+				out = _mm_packus_epi16(o_lo, o_hi);
+			}
+		}
+
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), out);
+	}
+
+	if (i < count)
+		blitRowScalar(dst + i, src + i, count - i, mode, mod);
+}
+
+FLARE_BLIT_TARGET_AVX2
+inline __m256i mulDiv255AVX2(__m256i a, __m256i b) {
+	__m256i t = _mm256_add_epi16(_mm256_mullo_epi16(a, b), _mm256_set1_epi16(128));
+	return _mm256_srli_epi16(_mm256_add_epi16(t, _mm256_srli_epi16(t, 8)), 8);
+}
+
+/**
+ * Same as blitRowSSE2(), but eight pixels at a time.
+ * The unpack/pack instructions work within 128-bit lanes, so pixel order is preserved.
+ */
+FLARE_BLIT_TARGET_AVX2
+void blitRowAVX2(uint32_t* dst, const uint32_t* src, int count, int mode, const Modulation& mod) {
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i full = _mm256_set1_epi16(255);
+	const __m256i alpha_lanes = _mm256_set_epi16(-1, 0, 0, 0, -1, 0, 0, 0, -1, 0, 0, 0, -1, 0, 0, 0);
+	const __m256i alpha_bytes = _mm256_set1_epi32(static_cast<int>(0xff000000));
+	const __m256i factor = _mm256_set1_epi64x(
+		static_cast<long long>(
+			static_cast<uint64_t>(mod.f[0]) |
+			(static_cast<uint64_t>(mod.f[1]) << 16) |
+			(static_cast<uint64_t>(mod.f[2]) << 32) |
+			(static_cast<uint64_t>(mod.f[3]) << 48)
+		)
+	);
+
+	int i = 0;
+	for (; i + 8 <= count; i += 8) {
+		__m256i s = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+
+		if (mode != MODE_COPY && _mm256_testz_si256(s, alpha_bytes))
+			continue;
+
+		__m256i s_lo = mulDiv255AVX2(_mm256_unpacklo_epi8(s, zero), factor);
+		__m256i s_hi = mulDiv255AVX2(_mm256_unpackhi_epi8(s, zero), factor);
+
+		__m256i out;
+		if (mode == MODE_COPY) {
+			out = _mm256_packus_epi16(s_lo, s_hi);
+		}
+		else {
+			__m256i a_lo = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(s_lo, 0xff), 0xff);
+			__m256i a_hi = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(s_hi, 0xff), 0xff);
+			__m256i d = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(dst + i));
+
+			if (mode == MODE_ADD) {
+				a_lo = _mm256_andnot_si256(alpha_lanes, a_lo);
+				a_hi = _mm256_andnot_si256(alpha_lanes, a_hi);
+				out = _mm256_packus_epi16(mulDiv255AVX2(s_lo, a_lo), mulDiv255AVX2(s_hi, a_hi));
+				out = _mm256_adds_epu8(out, d);
+			}
+			else {
+				__m256i d_lo = _mm256_unpacklo_epi8(d, zero);
+				__m256i d_hi = _mm256_unpackhi_epi8(d, zero);
+				__m256i inv_lo = _mm256_sub_epi16(full, a_lo);
+				__m256i inv_hi = _mm256_sub_epi16(full, a_hi);
+				a_lo = _mm256_or_si256(_mm256_andnot_si256(alpha_lanes, a_lo), _mm256_and_si256(alpha_lanes, full));
+				a_hi = _mm256_or_si256(_mm256_andnot_si256(alpha_lanes, a_hi), _mm256_and_si256(alpha_lanes, full));
+				__m256i o_lo = _mm256_add_epi16(mulDiv255AVX2(s_lo, a_lo), mulDiv255AVX2(d_lo, inv_lo));
+				__m256i o_hi = _mm256_add_epi16(mulDiv255AVX2(s_hi, a_hi), mulDiv255AVX2(d_hi, inv_hi));
+				out = _mm256_packus_epi16(o_lo, o_hi);
+			}
+		}
+
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), out);
+	}
+
+	if (i < count)
+		blitRowSSE2(dst + i, src + i, count - i, mode, mod);
+}
+
+#endif // FLARE_BLIT_X86
+
+int getBestISA() {
+#ifdef FLARE_BLIT_X86
+#if SDL_VERSION_ATLEAST(2, 0, 2)
+	if (SDL_HasAVX2())
+		return ISA_AVX2;
+#endif
+	if (SDL_HasSSE2())
+		return ISA_SSE2;
+#endif
+	return ISA_SCALAR;
+}
+
+void setISA(int isa) {
+	current_isa = std::max(static_cast<int>(ISA_SCALAR), std::min(isa, getBestISA()));
+}
+
+int getISA() {
+	if (current_isa == -1)
+		current_isa = getBestISA();
+	return current_isa;
+}
+
+bool isSupported(SDL_Surface* src, SDL_Surface* dst) {
+	if (!src || !dst)
+		return false;
+	if (src->format->format != SDL_PIXELFORMAT_ARGB8888 || dst->format->format != SDL_PIXELFORMAT_ARGB8888)
+		return false;
+	// RLE-accelerated surfaces don't expose their pixels directly
+	if (SDL_MUSTLOCK(src) || SDL_MUSTLOCK(dst))
+		return false;
+	return true;
+}
+
+bool isOpaque(SDL_Surface* surface) {
+	if (!surface || surface->format->format != SDL_PIXELFORMAT_ARGB8888 || SDL_MUSTLOCK(surface))
+		return false;
+
+	for (int y = 0; y < surface->h; ++y) {
+		const uint32_t* row = reinterpret_cast<const uint32_t*>(static_cast<const uint8_t*>(surface->pixels) + y * surface->pitch);
+		uint32_t alpha = 0xff000000;
+		for (int x = 0; x < surface->w; ++x) {
+			alpha &= row[x];
+		}
+		if (alpha != 0xff000000)
+			return false;
+	}
+	return true;
+}
+
+void blitRow(uint32_t* dst, const uint32_t* src, int count, int mode, const Color& color_mod, uint8_t alpha_mod) {
+	Modulation mod(color_mod, alpha_mod);
+
+	// plain copies don't need any per-pixel work
+	if (mode == MODE_COPY && color_mod.r == 255 && color_mod.g == 255 && color_mod.b == 255 && alpha_mod == 255) {
+		memcpy(dst, src, count * sizeof(uint32_t));
+		return;
+	}
+
+	// only used for a few baked images per frame, so there's no SIMD version
+	if (mode == MODE_PREMULTIPLIED) {
+		blitRowScalar(dst, src, count, mode, mod);
+		return;
+	}
+
+	switch (getISA()) {
+#ifdef FLARE_BLIT_X86
+		case ISA_AVX2:
+			blitRowAVX2(dst, src, count, mode, mod);
+			return;
+		case ISA_SSE2:
+			blitRowSSE2(dst, src, count, mode, mod);
+			return;
+#endif
+		default:
+			blitRowScalar(dst, src, count, mode, mod);
+			return;
+	}
+}
+
+int blit(SDL_Surface* src, const SDL_Rect* src_rect, SDL_Surface* dst, SDL_Rect* dst_rect, int mode, const Color& color_mod, uint8_t alpha_mod) {
+	return blitClipped(src, src_rect, dst, dst_rect, dst->clip_rect, mode, color_mod, alpha_mod);
+}
+
+int blitClipped(SDL_Surface* src, const SDL_Rect* src_rect, SDL_Surface* dst, SDL_Rect* dst_rect, const SDL_Rect& clip, int mode, const Color& color_mod, uint8_t alpha_mod) {
+	// clip the source rect to the source surface, then clip against the clip rect
+	// this follows the same steps as SDL_UpperBlit()
+	int src_x = src_rect->x;
+	int src_y = src_rect->y;
+	int w = src_rect->w;
+	int h = src_rect->h;
+	int dst_x = dst_rect->x;
+	int dst_y = dst_rect->y;
+
+	if (src_x < 0) {
+		w += src_x;
+		dst_x -= src_x;
+		src_x = 0;
+	}
+	w = std::min(w, src->w - src_x);
+
+	if (src_y < 0) {
+		h += src_y;
+		dst_y -= src_y;
+		src_y = 0;
+	}
+	h = std::min(h, src->h - src_y);
+
+	int delta = clip.x - dst_x;
+	if (delta > 0) {
+		w -= delta;
+		dst_x += delta;
+		src_x += delta;
+	}
+	delta = dst_x + w - clip.x - clip.w;
+	if (delta > 0)
+		w -= delta;
+
+	delta = clip.y - dst_y;
+	if (delta > 0) {
+		h -= delta;
+		dst_y += delta;
+		src_y += delta;
+	}
+	delta = dst_y + h - clip.y - clip.h;
+	if (delta > 0)
+		h -= delta;
+
+	dst_rect->x = dst_x;
+	dst_rect->y = dst_y;
+
+	if (w <= 0 || h <= 0) {
+		dst_rect->w = dst_rect->h = 0;
+		return 0;
+	}
+
+	dst_rect->w = w;
+	dst_rect->h = h;
+
+	const uint8_t* src_row = static_cast<const uint8_t*>(src->pixels) + src_y * src->pitch + src_x * 4;
+	uint8_t* dst_row = static_cast<uint8_t*>(dst->pixels) + dst_y * dst->pitch + dst_x * 4;
+
+	for (int y = 0; y < h; ++y) {
+		blitRow(reinterpret_cast<uint32_t*>(dst_row), reinterpret_cast<const uint32_t*>(src_row), w, mode, color_mod, alpha_mod);
+		src_row += src->pitch;
+		dst_row += dst->pitch;
+	}
+
+	return 0;
+}
+
+/**
+ * Blits a 128x128 sprite (with a mix of transparent, translucent and opaque pixels)
+ * and a 64x32 opaque tile all over a 1280x720 frame, once with SDL_BlitSurface()
+ * and once with each instruction set this CPU supports.
+ */
+void benchmark() {
+	const int FRAME_W = 1280;
+	const int FRAME_H = 720;
+	const int ITERATIONS = 2000;
+
+	const char* isa_names[] = {"scalar", "sse2", "avx2"};
+
+	SDL_Surface* frame = SDL_CreateRGBSurfaceWithFormat(0, FRAME_W, FRAME_H, 32, SDL_PIXELFORMAT_ARGB8888);
+	SDL_Surface* sprite = SDL_CreateRGBSurfaceWithFormat(0, 128, 128, 32, SDL_PIXELFORMAT_ARGB8888);
+	SDL_Surface* tile = SDL_CreateRGBSurfaceWithFormat(0, 64, 32, 32, SDL_PIXELFORMAT_ARGB8888);
+
+	if (!frame || !sprite || !tile) {
+		Utils::logError("SoftwareBlit: Unable to create benchmark surfaces: %s", SDL_GetError());
+		SDL_FreeSurface(frame);
+		SDL_FreeSurface(sprite);
+		SDL_FreeSurface(tile);
+		return;
+	}
+
+	uint32_t seed = 12345;
+	for (int y = 0; y < sprite->h; ++y) {
+		uint32_t* row = reinterpret_cast<uint32_t*>(static_cast<uint8_t*>(sprite->pixels) + y * sprite->pitch);
+		for (int x = 0; x < sprite->w; ++x) {
+			seed = seed * 1103515245 + 12345;
+			// roughly a third of the pixels each are transparent, translucent and opaque
+			uint32_t alpha = (x + y < 80) ? 0 : ((x * y) % 3 == 0 ? 0x80 : 0xff);
+			row[x] = (alpha << 24) | ((seed >> 8) & 0xffffff);
+		}
+	}
+	for (int y = 0; y < tile->h; ++y) {
+		uint32_t* row = reinterpret_cast<uint32_t*>(static_cast<uint8_t*>(tile->pixels) + y * tile->pitch);
+		for (int x = 0; x < tile->w; ++x) {
+			seed = seed * 1103515245 + 12345;
+			row[x] = 0xff000000 | ((seed >> 8) & 0xffffff);
+		}
+	}
+
+	struct BenchCase {
+		const char* name;
+		SDL_Surface* src;
+		int mode;
+		Color color_mod;
+		uint8_t alpha_mod;
+	};
+
+	BenchCase cases[] = {
+		{"opaque copy", tile, MODE_COPY, Color(255, 255, 255), 255},
+		{"alpha blend", sprite, MODE_BLEND, Color(255, 255, 255), 255},
+		{"additive", sprite, MODE_ADD, Color(255, 255, 255), 255},
+		{"color mod", sprite, MODE_BLEND, Color(255, 128, 64), 255},
+		{"alpha mod", sprite, MODE_BLEND, Color(255, 255, 255), 128}
+	};
+
+	const int old_isa = getISA();
+	const int best_isa = getBestISA();
+	const double freq = static_cast<double>(SDL_GetPerformanceFrequency());
+
+	Utils::logInfo("SoftwareBlit: %d blits per case, best instruction set: %s", ITERATIONS, isa_names[best_isa]);
+
+	for (size_t c = 0; c < sizeof(cases) / sizeof(cases[0]); ++c) {
+		const BenchCase& bc = cases[c];
+		SDL_Rect src_rect = {0, 0, bc.src->w, bc.src->h};
+		const double megapixels = static_cast<double>(ITERATIONS) * bc.src->w * bc.src->h / 1000000.0;
+
+		// SDL_BLENDMODE_NONE is SDL's own fast path for opaque sources
+		SDL_BlendMode sdl_blend = SDL_BLENDMODE_BLEND;
+		if (bc.mode == MODE_COPY)
+			sdl_blend = SDL_BLENDMODE_NONE;
+		else if (bc.mode == MODE_ADD)
+			sdl_blend = SDL_BLENDMODE_ADD;
+		SDL_SetSurfaceBlendMode(bc.src, sdl_blend);
+		SDL_SetSurfaceColorMod(bc.src, bc.color_mod.r, bc.color_mod.g, bc.color_mod.b);
+		SDL_SetSurfaceAlphaMod(bc.src, bc.alpha_mod);
+
+		double sdl_seconds = 0;
+		for (int isa = -1; isa <= best_isa; ++isa) {
+			if (isa >= 0)
+				setISA(isa);
+
+			Uint64 start = SDL_GetPerformanceCounter();
+			for (int i = 0; i < ITERATIONS; ++i) {
+				SDL_Rect dst_rect = {(i * 97) % (FRAME_W - bc.src->w), (i * 61) % (FRAME_H - bc.src->h), 0, 0};
+				if (isa == -1)
+					SDL_BlitSurface(bc.src, &src_rect, frame, &dst_rect);
+				else
+					blit(bc.src, &src_rect, frame, &dst_rect, bc.mode, bc.color_mod, bc.alpha_mod);
+			}
+			double seconds = static_cast<double>(SDL_GetPerformanceCounter() - start) / freq;
+
+			if (isa == -1) {
+				sdl_seconds = seconds;
+				Utils::logInfo("SoftwareBlit: %-12s %-7s %8.1f Mpx/s", bc.name, "sdl", megapixels / seconds);
+			}
+			else {
+				Utils::logInfo("SoftwareBlit: %-12s %-7s %8.1f Mpx/s (%.2fx)", bc.name, isa_names[isa], megapixels / seconds, sdl_seconds / seconds);
+			}
+		}
+	}
+
+	setISA(old_isa);
+
+	SDL_FreeSurface(frame);
+	SDL_FreeSurface(sprite);
+	SDL_FreeSurface(tile);
+}
+
+} // namespace SoftwareBlit
@@ -0,0 +1,75 @@
+/*
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+/**
+ * namespace SoftwareBlit
+ *
+ * Blitting kernels for SDLSoftwareRenderDevice.
+ * These replace SDL_BlitSurface() for the ARGB8888 -> ARGB8888 case that the
+ * software renderer uses for every loaded image. Color and alpha modulation
+ * are folded into the same pass. The SSE2/AVX2 paths are picked at runtime;
+ * other CPUs use the scalar kernels.
+ */
+
+#ifndef SDL_SOFTWARE_BLIT_H
+#define SDL_SOFTWARE_BLIT_H
+
+#include "CommonIncludes.h"
+#include "Utils.h"
+
+namespace SoftwareBlit {
+	enum {
+		MODE_COPY = 0, // dst = src (used for opaque sources and SDL_BLENDMODE_NONE)
+		MODE_BLEND = 1, // SDL_BLENDMODE_BLEND
+		MODE_ADD = 2, // SDL_BLENDMODE_ADD
+		MODE_PREMULTIPLIED = 3 // like MODE_BLEND, for sources whose colors are already multiplied by their alpha
+	};
+
+	enum {
+		ISA_SCALAR = 0,
+		ISA_SSE2 = 1,
+		ISA_AVX2 = 2
+	};
+
+	// returns the best instruction set supported by this CPU
+	int getBestISA();
+
+	// overrides the instruction set used by blit(); clamped to getBestISA()
+	void setISA(int isa);
+	int getISA();
+
+	// true if the kernels can handle blitting from src to dst
+	bool isSupported(SDL_Surface* src, SDL_Surface* dst);
+
+	// true if every pixel of the surface has an alpha of 255
+	bool isOpaque(SDL_Surface* surface);
+
+	/**
+	 * Drop-in replacement for SDL_BlitSurface(), including clipping against the destination's clip rect.
+	 * dst_rect is updated to the final blit rectangle. Both surfaces must pass isSupported().
+	 */
+	int blit(SDL_Surface* src, const SDL_Rect* src_rect, SDL_Surface* dst, SDL_Rect* dst_rect, int mode, const Color& color_mod, uint8_t alpha_mod);
+
+	// same as blit(), but clips against the given rect instead of the destination's clip rect
+	int blitClipped(SDL_Surface* src, const SDL_Rect* src_rect, SDL_Surface* dst, SDL_Rect* dst_rect, const SDL_Rect& clip, int mode, const Color& color_mod, uint8_t alpha_mod);
+
+	// blends a single row of pixels
+	void blitRow(uint32_t* dst, const uint32_t* src, int count, int mode, const Color& color_mod, uint8_t alpha_mod);
+
+	// times each kernel against SDL_BlitSurface() and logs the results (see the --benchmark-blit command line option)
+	void benchmark();
+}
+
+#endif
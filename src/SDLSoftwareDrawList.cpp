@@ -0,0 +1,231 @@
+/*
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+/**
+ * class SDLSoftwareDrawList
+ */
+
+#include "RenderDevice.h"
+#include "SDLSoftwareBlit.h"
+#include "SDLSoftwareDrawList.h"
+
+namespace {
+	// upper limit for the size of the worker pool
+	const int MAX_THREADS = 16;
+
+	// each thread gets several bands, so that a band full of expensive blits doesn't hold up the others
+	const int BANDS_PER_THREAD = 4;
+	const int MIN_BAND_HEIGHT = 16;
+}
+
+SDLSoftwareDrawList::SDLSoftwareDrawList()
+	: threads_started(false)
+	, mutex(NULL)
+	, cond_start(NULL)
+	, cond_done(NULL)
+	, generation(0)
+	, active_workers(0)
+	, quit(false)
+	, target(NULL)
+	, band_count(0)
+	, band_height(0)
+{
+	SDL_AtomicSet(&next_band, 0);
+}
+
+SDLSoftwareDrawList::~SDLSoftwareDrawList() {
+	clear();
+	stopThreads();
+}
+
+void SDLSoftwareDrawList::add(Image* image, SDL_Surface* surface, const SDL_Rect& src, const SDL_Rect& dest, int mode, const Color& color_mod, uint8_t alpha_mod) {
+	Command cmd;
+	cmd.image = image;
+	cmd.surface = surface;
+	cmd.src = src;
+	cmd.dest = dest;
+	cmd.mode = mode;
+	cmd.color_mod = color_mod;
+	cmd.alpha_mod = alpha_mod;
+
+	image->ref();
+	commands.push_back(cmd);
+}
+
+void SDLSoftwareDrawList::flush(SDL_Surface* _target) {
+	if (commands.empty())
+		return;
+
+	if (!threads_started)
+		startThreads();
+
+	target = _target;
+
+	int thread_count = static_cast<int>(threads.size()) + 1;
+	band_count = std::max(1, std::min(thread_count * BANDS_PER_THREAD, target->h / MIN_BAND_HEIGHT));
+	band_height = (target->h + band_count - 1) / band_count;
+	SDL_AtomicSet(&next_band, 0);
+
+	if (threads.empty()) {
+		executeBands();
+	}
+	else {
+		SDL_LockMutex(mutex);
+		active_workers = static_cast<int>(threads.size());
+		++generation;
+		SDL_CondBroadcast(cond_start);
+		SDL_UnlockMutex(mutex);
+
+		// the main thread works on bands too
+		executeBands();
+
+		SDL_LockMutex(mutex);
+		while (active_workers > 0) {
+			SDL_CondWait(cond_done, mutex);
+		}
+		SDL_UnlockMutex(mutex);
+	}
+
+	target = NULL;
+	clear();
+}
+
+void SDLSoftwareDrawList::clear() {
+	for (size_t i = 0; i < commands.size(); ++i) {
+		commands[i].image->unref();
+	}
+	commands.clear();
+}
+
+void SDLSoftwareDrawList::startThreads() {
+	threads_started = true;
+
+	// make sure the kernels are picked before any worker calls them
+	SoftwareBlit::getISA();
+
+	int thread_count = std::min(SDL_GetCPUCount(), MAX_THREADS) - 1;
+	if (thread_count <= 0)
+		return;
+
+	mutex = SDL_CreateMutex();
+	cond_start = SDL_CreateCond();
+	cond_done = SDL_CreateCond();
+	if (!mutex || !cond_start || !cond_done) {
+		Utils::logError("SDLSoftwareDrawList: Unable to create worker pool, drawing on the main thread. %s", SDL_GetError());
+		stopThreads();
+		threads_started = true;
+		return;
+	}
+
+	quit = false;
+
+	// workers start from generation 0, so a flush made before one of them gets to wait isn't missed
+	generation = 0;
+
+	for (int i = 0; i < thread_count; ++i) {
+		SDL_Thread* thread = SDL_CreateThread(threadFunction, "render_worker", this);
+		if (!thread) {
+			Utils::logError("SDLSoftwareDrawList: Unable to create worker thread. %s", SDL_GetError());
+			break;
+		}
+		threads.push_back(thread);
+	}
+
+	Utils::logInfo("SDLSoftwareDrawList: Using %d render threads.", static_cast<int>(threads.size()) + 1);
+}
+
+void SDLSoftwareDrawList::stopThreads() {
+	if (!threads.empty()) {
+		SDL_LockMutex(mutex);
+		quit = true;
+		SDL_CondBroadcast(cond_start);
+		SDL_UnlockMutex(mutex);
+
+		for (size_t i = 0; i < threads.size(); ++i) {
+			SDL_WaitThread(threads[i], NULL);
+		}
+		threads.clear();
+	}
+
+	if (cond_done) SDL_DestroyCond(cond_done);
+	if (cond_start) SDL_DestroyCond(cond_start);
+	if (mutex) SDL_DestroyMutex(mutex);
+	cond_done = NULL;
+	cond_start = NULL;
+	mutex = NULL;
+
+	threads_started = false;
+}
+
+int SDLSoftwareDrawList::threadFunction(void* data) {
+	static_cast<SDLSoftwareDrawList*>(data)->workerLoop();
+	return 0;
+}
+
+void SDLSoftwareDrawList::workerLoop() {
+	unsigned seen_generation = 0;
+
+	SDL_LockMutex(mutex);
+	while (true) {
+		while (!quit && generation == seen_generation) {
+			SDL_CondWait(cond_start, mutex);
+		}
+		if (quit)
+			break;
+
+		seen_generation = generation;
+		SDL_UnlockMutex(mutex);
+
+		executeBands();
+
+		SDL_LockMutex(mutex);
+		--active_workers;
+		if (active_workers == 0)
+			SDL_CondSignal(cond_done);
+	}
+	SDL_UnlockMutex(mutex);
+}
+
+void SDLSoftwareDrawList::executeBands() {
+	int band = SDL_AtomicAdd(&next_band, 1);
+	while (band < band_count) {
+		executeBand(band);
+		band = SDL_AtomicAdd(&next_band, 1);
+	}
+}
+
+void SDLSoftwareDrawList::executeBand(int band) {
+	const SDL_Rect& target_clip = target->clip_rect;
+
+	SDL_Rect clip;
+	clip.x = target_clip.x;
+	clip.w = target_clip.w;
+	clip.y = std::max(band * band_height, target_clip.y);
+	clip.h = std::min((band + 1) * band_height, target_clip.y + target_clip.h) - clip.y;
+
+	if (clip.h <= 0)
+		return;
+
+	for (size_t i = 0; i < commands.size(); ++i) {
+		const Command& cmd = commands[i];
+
+		// skip commands that don't touch this band before doing any clipping work
+		if (cmd.dest.y >= clip.y + clip.h || cmd.dest.y + cmd.src.h <= clip.y)
+			continue;
+
+		SDL_Rect dest = cmd.dest;
+		SoftwareBlit::blitClipped(cmd.surface, &cmd.src, target, &dest, clip, cmd.mode, cmd.color_mod, cmd.alpha_mod);
+	}
+}
@@ -0,0 +1,87 @@
+/*
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+/**
+ * class SDLSoftwareDrawList
+ *
+ * Records the blits of a frame for SDLSoftwareRenderDevice, in order.
+ * When flushed, the target surface is split into horizontal bands and a pool
+ * of worker threads replays the whole list once per band, clipped to that band.
+ * Since every band sees the commands in the same order, the result is identical
+ * to drawing them one after another.
+ */
+
+#ifndef SDL_SOFTWARE_DRAW_LIST_H
+#define SDL_SOFTWARE_DRAW_LIST_H
+
+#include "CommonIncludes.h"
+#include "Utils.h"
+
+class SDLSoftwareDrawList {
+public:
+	SDLSoftwareDrawList();
+	~SDLSoftwareDrawList();
+
+	// queued images are referenced until the list is flushed
+	void add(Image* image, SDL_Surface* surface, const SDL_Rect& src, const SDL_Rect& dest, int mode, const Color& color_mod, uint8_t alpha_mod);
+
+	// draws all queued commands to the target and empties the list
+	void flush(SDL_Surface* target);
+
+	// empties the list without drawing anything
+	void clear();
+
+	bool empty() const { return commands.empty(); }
+
+	void stopThreads();
+
+private:
+	class Command {
+	public:
+		Image* image;
+		SDL_Surface* surface;
+		SDL_Rect src;
+		SDL_Rect dest;
+		int mode;
+		Color color_mod;
+		uint8_t alpha_mod;
+	};
+
+	static int threadFunction(void* data);
+
+	void startThreads();
+	void workerLoop();
+	void executeBands();
+	void executeBand(int band);
+
+	std::vector<Command> commands;
+
+	std::vector<SDL_Thread*> threads;
+	bool threads_started;
+	SDL_mutex* mutex;
+	SDL_cond* cond_start;
+	SDL_cond* cond_done;
+	unsigned generation;
+	int active_workers;
+	bool quit;
+
+	// state of the flush in progress, shared with the workers
+	SDL_Surface* target;
+	SDL_atomic_t next_band;
+	int band_count;
+	int band_height;
+};
+
+#endif // SDL_SOFTWARE_DRAW_LIST_H
@@ -33,15 +33,18 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 #include "MessageEngine.h"
 #include "ModManager.h"
 #include "Platform.h"
+#include "Profiler.h"
 #include "SharedResources.h"
 #include "Settings.h"
 
+#include "SDLSoftwareBlit.h"
 #include "SDLSoftwareRenderDevice.h"
 #include "SDLFontEngine.h"
 
 SDLSoftwareImage::SDLSoftwareImage(RenderDevice *_device)
 	: Image(_device)
-	, surface(NULL) {
+	, surface(NULL)
+	, opaque(false) {
 }
 
 SDLSoftwareImage::~SDLSoftwareImage() {
@@ -60,7 +63,10 @@ int SDLSoftwareImage::getHeight() const {
 void SDLSoftwareImage::fillWithColor(const Color& color) {
 	if (!surface) return;
 
+	static_cast<SDLSoftwareRenderDevice *>(device)->flushDrawList();
+
 	SDL_FillRect(surface, NULL, MapRGBA(color.r, color.g, color.b, color.a));
+	opaque = (color.a == 255);
 }
 
 /*
@@ -76,8 +82,13 @@ void SDLSoftwareImage::drawPixel(int x, int y, const Color& color) {
 	if (x < 0 || y < 0 || x >= getWidth() || y >= getHeight())
 		return;
 
+	static_cast<SDLSoftwareRenderDevice *>(device)->flushDrawList();
+
 	Uint32 pixel = MapRGBA(color.r, color.g, color.b, color.a);
 
+	if (color.a != 255)
+		opaque = false;
+
 	int bpp = surface->format->BytesPerPixel;
 	/* Here p is the address to the pixel we want to set */
 	Uint8 *p = static_cast<Uint8*>(surface->pixels) + y * surface->pitch + x * bpp;
@@ -150,6 +161,28 @@ Uint32 SDLSoftwareImage::MapRGBA(Uint8 r, Uint8 g, Uint8 b, Uint8 a) {
 	return SDL_MapRGBA(surface->format, r, g, b, a);
 }
 
+/**
+ * Replaces the pixels in area with those of src, without blending
+ */
+void SDLSoftwareImage::copyFromSurface(SDL_Surface* src, const Rect& area) {
+	if (!surface || !src) return;
+
+	static_cast<SDLSoftwareRenderDevice *>(device)->flushDrawList();
+
+	SDL_BlendMode blend_mode;
+	SDL_GetSurfaceBlendMode(src, &blend_mode);
+	SDL_SetSurfaceBlendMode(src, SDL_BLENDMODE_NONE);
+
+	SDL_Rect src_rect(area);
+	SDL_Rect dest_rect(area);
+	SDL_BlitSurface(src, &src_rect, surface, &dest_rect);
+
+	SDL_SetSurfaceBlendMode(src, blend_mode);
+
+	// the new pixels may be transparent
+	opaque = false;
+}
+
 /**
  * Resizes an image
  * Deletes the original image and returns a pointer to the resized version
@@ -170,6 +203,7 @@ Image* SDLSoftwareImage::resize(int width, int height) {
 
 		if (scaled->surface) {
 			SDL_BlitScaled(surface, NULL, scaled->surface, NULL);
+			scaled->opaque = opaque;
 
 			// delete the old image and return the new one
 			this->unref();
@@ -354,10 +388,28 @@ void SDLSoftwareRenderDevice::createContextError() {
 }
 
 int SDLSoftwareRenderDevice::render(Renderable& r, Rect& dest) {
+	Profiler::addCount(Profiler::COUNTER_DRAW_CALLS);
+
 	SDL_Rect src = r.src;
 	SDL_Rect _dest = dest;
 
-	SDL_Surface *surface = static_cast<SDLSoftwareImage *>(r.image)->surface;
+	SDLSoftwareImage *image = static_cast<SDLSoftwareImage *>(r.image);
+	SDL_Surface *surface = image->surface;
+
+	if (SoftwareBlit::isSupported(surface, screen)) {
+		int mode = SoftwareBlit::MODE_BLEND;
+		if (r.blend_mode == Renderable::BLEND_ADD)
+			mode = SoftwareBlit::MODE_ADD;
+		else if (r.blend_mode == Renderable::BLEND_PREMULTIPLIED)
+			mode = SoftwareBlit::MODE_PREMULTIPLIED;
+		else if (image->opaque && r.alpha_mod == 255)
+			mode = SoftwareBlit::MODE_COPY;
+
+		draw_list.add(image, surface, src, _dest, mode, r.color_mod, r.alpha_mod);
+		return 0;
+	}
+
+	flushDrawList();
 
 	if (r.blend_mode == Renderable::BLEND_ADD) {
 		SDL_SetSurfaceBlendMode(surface, SDL_BLENDMODE_ADD);
@@ -381,10 +433,30 @@ int SDLSoftwareRenderDevice::render(Sprite *r) {
 		return -1;
 	}
 
+	Profiler::addCount(Profiler::COUNTER_DRAW_CALLS);
+
 	SDL_Rect src = m_clip;
 	SDL_Rect dest = m_dest;
 
-	SDL_Surface *surface = static_cast<SDLSoftwareImage *>(r->getGraphics())->surface;
+	SDLSoftwareImage *image = static_cast<SDLSoftwareImage *>(r->getGraphics());
+	SDL_Surface *surface = image->surface;
+
+	SDL_BlendMode blend_mode = SDL_BLENDMODE_BLEND;
+	SDL_GetSurfaceBlendMode(surface, &blend_mode);
+
+	if (SoftwareBlit::isSupported(surface, screen) && blend_mode != SDL_BLENDMODE_MOD) {
+		int mode = SoftwareBlit::MODE_BLEND;
+		if (blend_mode == SDL_BLENDMODE_ADD)
+			mode = SoftwareBlit::MODE_ADD;
+		else if (blend_mode == SDL_BLENDMODE_NONE || (image->opaque && r->alpha_mod == 255))
+			mode = SoftwareBlit::MODE_COPY;
+
+		draw_list.add(image, surface, src, dest, mode, r->color_mod, r->alpha_mod);
+		return 0;
+	}
+
+	flushDrawList();
+
 	SDL_SetSurfaceColorMod(surface, r->color_mod.r, r->color_mod.g, r->color_mod.b);
 	SDL_SetSurfaceAlphaMod(surface, r->alpha_mod);
 
@@ -397,10 +469,41 @@ int SDLSoftwareRenderDevice::renderToImage(Image* src_image, Rect& src, Image* d
 	SDL_Rect _src = src;
 	SDL_Rect _dest = dest;
 
-	return SDL_BlitSurface(static_cast<SDLSoftwareImage *>(src_image)->surface, &_src,
+	flushDrawList();
+
+	static_cast<SDLSoftwareImage *>(dest_image)->opaque = false;
+
+	// draw the source as it is, not with the modifiers it was last rendered with
+	SDL_Surface *src_surface = static_cast<SDLSoftwareImage *>(src_image)->surface;
+	SDL_SetSurfaceColorMod(src_surface, 255, 255, 255);
+	SDL_SetSurfaceAlphaMod(src_surface, 255);
+
+	return SDL_BlitSurface(src_surface, &_src,
 						   static_cast<SDLSoftwareImage *>(dest_image)->surface, &_dest);
 }
 
+int SDLSoftwareRenderDevice::renderToImageBatch(Image* src_image, const std::vector<Rect>& src, Image* dest_image, const std::vector<Rect>& dest, const Color& color_mod) {
+	if (!src_image || !dest_image) return -1;
+
+	flushDrawList();
+
+	static_cast<SDLSoftwareImage *>(dest_image)->opaque = false;
+
+	SDL_Surface *src_surface = static_cast<SDLSoftwareImage *>(src_image)->surface;
+	SDL_Surface *dest_surface = static_cast<SDLSoftwareImage *>(dest_image)->surface;
+	SDL_SetSurfaceColorMod(src_surface, color_mod.r, color_mod.g, color_mod.b);
+	SDL_SetSurfaceAlphaMod(src_surface, color_mod.a);
+
+	int ret = 0;
+	for (size_t i = 0; i < src.size() && i < dest.size(); ++i) {
+		SDL_Rect _src = src[i];
+		SDL_Rect _dest = dest[i];
+		if (SDL_BlitSurface(src_surface, &_src, dest_surface, &_dest) != 0)
+			ret = -1;
+	}
+	return ret;
+}
+
 Image* SDLSoftwareRenderDevice::renderTextToImage(FontStyle* font_style, const std::string& text, const Color& color, bool blended) {
 	SDLSoftwareImage *image = new SDLSoftwareImage(this);
 	if (!image) return NULL;
@@ -420,6 +523,8 @@ Image* SDLSoftwareRenderDevice::renderTextToImage(FontStyle* font_style, const s
 }
 
 void SDLSoftwareRenderDevice::drawPixel(int x, int y, const Color& color) {
+	flushDrawList();
+
 	Uint32 pixel = MapRGBA(color.r, color.g, color.b, color.a);
 
 	int bpp = screen->format->BytesPerPixel;
@@ -501,11 +606,16 @@ void SDLSoftwareRenderDevice::drawRectangle(const Point& p0, const Point& p1, co
 }
 
 void SDLSoftwareRenderDevice::blankScreen() {
+	// anything still queued would be painted over anyway
+	draw_list.clear();
+
 	SDL_FillRect(screen, NULL, background_color);
 	return;
 }
 
 void SDLSoftwareRenderDevice::commitFrame() {
+	flushDrawList();
+
 	SDL_UpdateTexture(texture, NULL, screen->pixels, screen->pitch);
 	SDL_RenderClear(renderer);
 	SDL_RenderCopy(renderer, texture, NULL, NULL);
@@ -518,8 +628,10 @@ void SDLSoftwareRenderDevice::commitFrame() {
 void SDLSoftwareRenderDevice::destroyContext() {
 	resetGamma();
 
-	// we need to free all loaded graphics as they may be tied to the current context
-	RenderDevice::cacheRemoveAll();
+	draw_list.clear();
+	draw_list.stopThreads();
+
+	// images are plain surfaces that don't depend on the window, so the cache is kept as it is
 	reload_graphics = true;
 
 	if (icons) {
@@ -592,6 +704,26 @@ Image *SDLSoftwareRenderDevice::createImage(int width, int height) {
 	return image;
 }
 
+/**
+ * Makes a copy of the surface in the format used by all other images
+ */
+Image *SDLSoftwareRenderDevice::createImageFromSurface(SDL_Surface *surface) {
+	if (!surface)
+		return NULL;
+
+	SDLSoftwareImage *image = new SDLSoftwareImage(this);
+
+	image->surface = SDL_ConvertSurfaceFormat(surface, SDL_PIXELFORMAT_ARGB8888, 0);
+	if (image->surface == NULL) {
+		Utils::logError("SDLSoftwareRenderDevice: SDL_ConvertSurfaceFormat failed: %s", SDL_GetError());
+		delete image;
+		return NULL;
+	}
+	image->opaque = SoftwareBlit::isOpaque(image->surface);
+
+	return image;
+}
+
 void SDLSoftwareRenderDevice::setGamma(float g) {
 	Uint16 ramp[256];
 	SDL_CalculateGammaRamp(g, ramp);
@@ -609,7 +741,7 @@ void SDLSoftwareRenderDevice::updateTitleBar() {
 	if (!window) return;
 
 	title = Utils::strdup(msg->get(eset->misc.window_title));
-	titlebar_icon = IMG_Load(mods->locate("images/logo/icon.png").c_str());
+	titlebar_icon = IMG_Load_RW(mods->openRW(mods->locate("images/logo/icon.png")), 1);
 
 	if (title) SDL_SetWindowTitle(window, title);
 	if (titlebar_icon) SDL_SetWindowIcon(window, titlebar_icon);
@@ -624,7 +756,7 @@ Image *SDLSoftwareRenderDevice::loadImage(const std::string& filename, int error
 	// load image
 	SDLSoftwareImage *image;
 	image = NULL;
-	SDL_Surface *cleanup = IMG_Load(mods->locate(filename).c_str());
+	SDL_Surface *cleanup = IMG_Load_RW(mods->openRW(mods->locate(filename)), 1);
 	if(!cleanup) {
 		if (error_type != ERROR_NONE)
 			Utils::logError("SDLSoftwareRenderDevice: Couldn't load image: '%s'. %s", filename.c_str(), IMG_GetError());
@@ -641,6 +773,7 @@ Image *SDLSoftwareRenderDevice::loadImage(const std::string& filename, int error
 		image = new SDLSoftwareImage(this);
 		image->surface = SDL_ConvertSurfaceFormat(cleanup, SDL_PIXELFORMAT_ARGB8888, 0);
 		SDL_FreeSurface(cleanup);
+		image->opaque = SoftwareBlit::isOpaque(image->surface);
 	}
 
 	// store image to cache
@@ -660,6 +793,8 @@ void SDLSoftwareRenderDevice::windowResize() {
 
 	SDL_RenderSetLogicalSize(renderer, settings->view_w, settings->view_h);
 
+	draw_list.clear();
+
 	if (texture) SDL_DestroyTexture(texture);
 	if (screen) SDL_FreeSurface(screen);
 
@@ -713,3 +848,10 @@ unsigned short SDLSoftwareRenderDevice::getRefreshRate() {
 	return static_cast<unsigned short>(mode.refresh_rate);
 }
 
+/**
+ * Only the SoftwareBlit kernels know how to draw premultiplied images
+ */
+bool SDLSoftwareRenderDevice::supportsPremultipliedAlpha() {
+	return screen && screen->format->format == SDL_PIXELFORMAT_ARGB8888 && !SDL_MUSTLOCK(screen);
+}
+
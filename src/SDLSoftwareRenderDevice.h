@@ -22,11 +22,14 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 #define SDLSOFTWARERENDERDEVICE_H
 
 #include "RenderDevice.h"
+#include "SDLSoftwareDrawList.h"
 
 /** Provide rendering device using SDL_BlitSurface backend.
  *
  * Provide an SDL_BlitSurface implementation for renderning a Renderable to
- * the screen.  Simply dispatches rendering to SDL_BlitSurface().
+ * the screen.  ARGB8888 surfaces are queued in a SDLSoftwareDrawList and drawn
+ * with the kernels in SoftwareBlit, split across threads; anything else is
+ * dispatched to SDL_BlitSurface() after the queue has been flushed.
  *
  * As this is for the FLARE engine, the implementation uses the engine's
  * global settings context, which is included by the interface.
@@ -49,10 +52,14 @@ public:
 	void fillWithColor(const Color& color);
 	void drawPixel(int x, int y, const Color& color);
 	void drawLine(int x0, int y0, int x1, int y1, const Color& color);
+	void copyFromSurface(SDL_Surface* src, const Rect& area);
 	Image* resize(int width, int height);
 
 	SDL_Surface *surface;
 
+	// true if every pixel is known to be fully opaque, which lets render() copy rows instead of blending them
+	bool opaque;
+
 private:
 	Uint32 MapRGBA(Uint8 r, Uint8 g, Uint8 b, Uint8 a);
 };
@@ -65,6 +72,7 @@ public:
 	virtual int render(Renderable& r, Rect& dest);
 	virtual int render(Sprite* r);
 	virtual int renderToImage(Image* src_image, Rect& src, Image* dest_image, Rect& dest);
+	virtual int renderToImageBatch(Image* src_image, const std::vector<Rect>& src, Image* dest_image, const std::vector<Rect>& dest, const Color& color_mod);
 
 	Image* renderTextToImage(FontStyle* font_style, const std::string& text, const Color& color, bool blended);
 	void drawPixel(int x, int y, const Color& color);
@@ -77,13 +85,21 @@ public:
 	void setBackgroundColor(Color color);
 	void setFullscreen(bool enable_fullscreen);
 	Image *createImage(int width, int height);
+	Image *createImageFromSurface(SDL_Surface *surface);
 	void setGamma(float g);
 	void resetGamma();
 	void updateTitleBar();
 	unsigned short getRefreshRate();
+	bool supportsPremultipliedAlpha();
 
 	Image* loadImage(const std::string& filename, int error_type);
 
+	// draws any queued blits; needed before the screen or a queued image is modified directly
+	void flushDrawList() {
+		if (!draw_list.empty())
+			draw_list.flush(screen);
+	}
+
 protected:
 	int createContextInternal();
 	void createContextError();
@@ -100,6 +116,8 @@ private:
 	char* title;
 	uint32_t background_color;
 
+	SDLSoftwareDrawList draw_list;
+
 	/* Stores the system gamma levels so they can be restored later */
 	uint16_t gamma_r[256];
 	uint16_t gamma_g[256];
@@ -62,7 +62,8 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 #include "Version.h"
 
 SaveLoad::SaveLoad()
-	: game_slot(0) {
+	: disable_saving(false)
+	, game_slot(0) {
 }
 
 SaveLoad::~SaveLoad() {
@@ -73,7 +74,7 @@ SaveLoad::~SaveLoad() {
  */
 void SaveLoad::saveGame() {
 
-	if (game_slot <= 0) return;
+	if (game_slot <= 0 || disable_saving) return;
 
 	// if needed, create the save file structure
 	Utils::createSaveDir(game_slot);
@@ -431,7 +432,7 @@ void SaveLoad::loadGame() {
 			}
 			else if (infile.key == "spawn") {
 				mapr->teleport_mapname = Parse::popFirstString(infile.val);
-				if (mapr->teleport_mapname != "" && Filesystem::fileExists(mods->locate(mapr->teleport_mapname))) {
+				if (mapr->teleport_mapname != "" && !mods->locate(mapr->teleport_mapname).empty()) {
 					mapr->teleport_destination.x = static_cast<float>(Parse::popFirstInt(infile.val)) + 0.5f;
 					mapr->teleport_destination.y = static_cast<float>(Parse::popFirstInt(infile.val)) + 0.5f;
 					mapr->teleportation = true;
@@ -687,6 +688,8 @@ void SaveLoad::loadPowerTree() {
 }
 
 void SaveLoad::saveFOW() {
+	if (disable_saving) return;
+
 	std::ofstream outfile;
 	std::stringstream ss;
 
@@ -43,6 +43,9 @@ public:
 	void loadStash();
 	void saveFOW();
 
+	// used by the --simulate-ticks mode, so that benchmark runs don't touch the player's saves
+	bool disable_saving;
+
 private:
 	void applyPlayerData();
 	void loadPowerTree();
@@ -63,7 +63,7 @@ Settings::Settings()
 	, soft_reset(false)
 	, safe_video(false)
 {
-	config.resize(50);
+	config.resize(53);
 	setConfigDefault(0,  "move_type_dimissed",  &typeid(move_type_dimissed),  "0",            &move_type_dimissed,  "One time flag for initial movement type dialog | 0 = show dialog, 1 = no dialog");
 	setConfigDefault(1,  "fullscreen",          &typeid(fullscreen),          "0",            &fullscreen,          "Fullscreen mode | 0 = disable, 1 = enable");
 	setConfigDefault(2,  "resolution_w",        &typeid(screen_w),            "640",          &screen_w,            "Window size");
@@ -114,6 +114,9 @@ Settings::Settings()
 	setConfigDefault(47, "dev_cmd_1",           &typeid(dev_cmd_1),           "toggle_fps",    &dev_cmd_1,           "Custom developer console shortcut command");
 	setConfigDefault(48, "dev_cmd_2",           &typeid(dev_cmd_2),           "toggle_devhud", &dev_cmd_2,           "Custom developer console shortcut command");
 	setConfigDefault(49, "dev_cmd_3",           &typeid(dev_cmd_3),           "toggle_hud",    &dev_cmd_3,           "Custom developer console shortcut command");
+	setConfigDefault(50, "frame_interpolation", &typeid(frame_interpolation), "1",            &frame_interpolation, "Render at the display's refresh rate when it is higher than max_fps, smoothing movement between logic frames | 0 = disable, 1 = enable");
+	setConfigDefault(51, "composite_layers",    &typeid(composite_layers),    "1",            &composite_layers,    "Draw the equipment layers of characters as a single baked image per animation frame | 0 = disable, 1 = enable");
+	setConfigDefault(52, "image_cache_size",    &typeid(image_cache_size),    "256",          &image_cache_size,    "Memory budget for loaded images, in MiB. Images that are no longer in use are kept for reuse until it is reached | 0 = don't keep unused images");
 }
 
 void Settings::setConfigDefault(size_t index, const std::string& name, const std::type_info *type, const std::string& default_val, void *storage, const std::string& comment) {
@@ -80,6 +80,9 @@ public:
 	float gamma;
 	bool parallax_layers;
 	unsigned short max_render_size;
+	bool frame_interpolation;
+	bool composite_layers;
+	unsigned short image_cache_size;
 
 	// Audio Settings
 	unsigned short music_volume;
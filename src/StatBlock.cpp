@@ -608,7 +608,7 @@ bool StatBlock::isNPCStat(FileParser *infile) {
 void StatBlock::load(const std::string& filename) {
 	// @CLASS StatBlock: Enemies|Description of enemies in enemies/
 	FileParser infile;
-	if (!infile.open(filename, FileParser::MOD_FILE, FileParser::ERROR_NORMAL))
+	if (!infile.open(filename, FileParser::MOD_FILE, FileParser::ERROR_NORMAL, FileParser::USE_CACHE))
 		return;
 
 	bool clear_loot = true;
@@ -1294,7 +1294,7 @@ void StatBlock::loadHeroStats() {
 	// Redefine numbers from config file if present
 	FileParser infile;
 	// @CLASS StatBlock: Hero stats|Description of engine/stats.txt
-	if (infile.open("engine/stats.txt", FileParser::MOD_FILE, FileParser::ERROR_NORMAL)) {
+	if (infile.open("engine/stats.txt", FileParser::MOD_FILE, FileParser::ERROR_NORMAL, FileParser::USE_CACHE)) {
 		while (infile.next()) {
 			int value = Parse::toInt(infile.val);
 
@@ -1332,7 +1332,7 @@ void StatBlock::loadHeroStats() {
 void StatBlock::loadHeroSFX() {
 	// load the paths to base sound effects
 	FileParser infile;
-	if (infile.open("engine/avatar/"+gfx_base+".txt", FileParser::MOD_FILE, FileParser::ERROR_NONE)) {
+	if (infile.open("engine/avatar/"+gfx_base+".txt", FileParser::MOD_FILE, FileParser::ERROR_NONE, FileParser::USE_CACHE)) {
 		while(infile.next()) {
 			loadSfxStat(&infile);
 		}
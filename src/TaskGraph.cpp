@@ -0,0 +1,179 @@
+/*
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+/**
+ * class TaskGraph
+ */
+
+#include "TaskGraph.h"
+#include "Utils.h"
+
+TaskGraph::TaskGraph()
+	: tasks_left(0)
+	, tasks_running(0)
+	, quit(false)
+	, mutex(NULL)
+	, cond(NULL)
+{
+}
+
+TaskGraph::~TaskGraph() {
+}
+
+size_t TaskGraph::add(const std::string& name, TaskFunction function, void* data, int thread) {
+	Task task;
+	task.name = name;
+	task.function = function;
+	task.data = data;
+	task.thread = thread;
+	tasks.push_back(task);
+	return tasks.size() - 1;
+}
+
+void TaskGraph::addDependency(size_t task, size_t dependency) {
+	if (task >= tasks.size() || dependency >= tasks.size() || task == dependency)
+		return;
+
+	tasks[dependency].dependents.push_back(task);
+	tasks[task].dependency_count++;
+}
+
+void TaskGraph::run() {
+	if (tasks.empty())
+		return;
+
+	Uint32 start_ticks = SDL_GetTicks();
+
+	tasks_left = tasks.size();
+	tasks_running = 0;
+	quit = false;
+
+	std::vector<SDL_Thread*> threads;
+
+	mutex = SDL_CreateMutex();
+	cond = SDL_CreateCond();
+	if (mutex && cond) {
+		int worker_tasks = 0;
+		for (size_t i = 0; i < tasks.size(); ++i) {
+			if (tasks[i].thread == ANY_THREAD)
+				worker_tasks++;
+		}
+
+		int thread_count = std::min(std::min(SDL_GetCPUCount(), MAX_THREADS) - 1, worker_tasks);
+		for (int i = 0; i < thread_count; ++i) {
+			SDL_Thread* thread = SDL_CreateThread(threadFunction, "load_worker", this);
+			if (!thread) {
+				Utils::logError("TaskGraph: Unable to create worker thread. %s", SDL_GetError());
+				break;
+			}
+			threads.push_back(thread);
+		}
+	}
+	else {
+		Utils::logError("TaskGraph: Unable to create worker pool, loading on the main thread. %s", SDL_GetError());
+	}
+
+	// the main thread runs MAIN_THREAD tasks, and helps with the others while it waits for them
+	SDL_LockMutex(mutex);
+	while (tasks_left > 0) {
+		size_t index = 0;
+		if (takeTask(true, index)) {
+			SDL_UnlockMutex(mutex);
+			runTask(index);
+			SDL_LockMutex(mutex);
+		}
+		else if (tasks_running == 0) {
+			// nothing is running and nothing can start, so there is a dependency cycle
+			for (size_t i = 0; i < tasks.size(); ++i) {
+				if (!tasks[i].started)
+					Utils::logError("TaskGraph: Task '%s' can't run, its dependencies never finish.", tasks[i].name.c_str());
+			}
+			break;
+		}
+		else {
+			SDL_CondWait(cond, mutex);
+		}
+	}
+	quit = true;
+	SDL_CondBroadcast(cond);
+	SDL_UnlockMutex(mutex);
+
+	for (size_t i = 0; i < threads.size(); ++i) {
+		SDL_WaitThread(threads[i], NULL);
+	}
+
+	if (cond) SDL_DestroyCond(cond);
+	if (mutex) SDL_DestroyMutex(mutex);
+	cond = NULL;
+	mutex = NULL;
+
+	Utils::logInfo("TaskGraph: Ran %u tasks on %u threads in %u ms.", static_cast<unsigned>(tasks.size()), static_cast<unsigned>(threads.size()) + 1, SDL_GetTicks() - start_ticks);
+
+	tasks.clear();
+}
+
+int TaskGraph::threadFunction(void* data) {
+	static_cast<TaskGraph*>(data)->workerLoop();
+	return 0;
+}
+
+void TaskGraph::workerLoop() {
+	SDL_LockMutex(mutex);
+	while (!quit) {
+		size_t index = 0;
+		if (takeTask(false, index)) {
+			SDL_UnlockMutex(mutex);
+			runTask(index);
+			SDL_LockMutex(mutex);
+		}
+		else {
+			SDL_CondWait(cond, mutex);
+		}
+	}
+	SDL_UnlockMutex(mutex);
+}
+
+/**
+ * Picks a task whose dependencies have finished. The mutex must be locked.
+ * The main thread prefers the tasks that only it can run.
+ */
+bool TaskGraph::takeTask(bool main_thread, size_t& index) {
+	for (int pass = (main_thread ? 0 : 1); pass < 2; ++pass) {
+		int thread = (pass == 0 ? MAIN_THREAD : ANY_THREAD);
+		for (size_t i = 0; i < tasks.size(); ++i) {
+			if (!tasks[i].started && tasks[i].dependency_count == 0 && tasks[i].thread == thread) {
+				tasks[i].started = true;
+				tasks_running++;
+				index = i;
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+void TaskGraph::runTask(size_t index) {
+	if (tasks[index].function)
+		tasks[index].function(tasks[index].data);
+
+	SDL_LockMutex(mutex);
+	for (size_t i = 0; i < tasks[index].dependents.size(); ++i) {
+		tasks[tasks[index].dependents[i]].dependency_count--;
+	}
+	tasks_running--;
+	tasks_left--;
+	SDL_CondBroadcast(cond);
+	SDL_UnlockMutex(mutex);
+}
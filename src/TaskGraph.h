@@ -0,0 +1,83 @@
+/*
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+/**
+ * class TaskGraph
+ *
+ * Runs a set of loading tasks on a pool of worker threads. A task starts once all
+ * of its dependencies have finished. Tasks that create SDL objects (textures, sounds)
+ * are marked MAIN_THREAD and are run by the thread that calls run(), which also
+ * helps with the other tasks while it waits.
+ */
+
+#ifndef TASK_GRAPH_H
+#define TASK_GRAPH_H
+
+#include "CommonIncludes.h"
+
+class TaskGraph {
+public:
+	typedef void (*TaskFunction)(void* data);
+
+	enum {
+		ANY_THREAD = 0,
+		MAIN_THREAD = 1
+	};
+
+	static const int MAX_THREADS = 8;
+
+	TaskGraph();
+	~TaskGraph();
+
+	size_t add(const std::string& name, TaskFunction function, void* data, int thread = ANY_THREAD);
+	void addDependency(size_t task, size_t dependency);
+
+	// blocks until every task has finished
+	void run();
+
+private:
+	class Task {
+	public:
+		Task()
+			: function(NULL)
+			, data(NULL)
+			, thread(ANY_THREAD)
+			, dependency_count(0)
+			, started(false)
+		{}
+		std::string name;
+		TaskFunction function;
+		void* data;
+		int thread;
+		std::vector<size_t> dependents;
+		unsigned dependency_count; // dependencies that haven't finished yet
+		bool started;
+	};
+
+	static int threadFunction(void* data);
+	void workerLoop();
+	bool takeTask(bool main_thread, size_t& index);
+	void runTask(size_t index);
+
+	std::vector<Task> tasks;
+	size_t tasks_left;
+	size_t tasks_running;
+	bool quit;
+
+	SDL_mutex* mutex;
+	SDL_cond* cond;
+};
+
+#endif
@@ -0,0 +1,146 @@
+/*
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+/**
+ * class TextCache
+ */
+
+#include "RenderDevice.h"
+#include "SharedResources.h"
+#include "TextCache.h"
+
+TextCacheKey::TextCacheKey(const std::string& _font_style, const std::string& _text, const Color& _color, bool _shadowed, int _width)
+	: font_style(_font_style)
+	, text(_text)
+	, color(0)
+	, shadowed(_shadowed)
+	, width(_width)
+{
+	Color c = _color;
+	color = c.encodeRGBA();
+}
+
+bool TextCacheKey::operator<(const TextCacheKey& other) const {
+	if (color != other.color)
+		return color < other.color;
+	if (width != other.width)
+		return width < other.width;
+	if (shadowed != other.shadowed)
+		return shadowed < other.shadowed;
+	if (font_style != other.font_style)
+		return font_style < other.font_style;
+	return text < other.text;
+}
+
+TextCache::TextCache()
+	: memory(0)
+	, use_counter(0)
+	, context_version(0)
+{
+}
+
+TextCache::~TextCache() {
+	clear();
+}
+
+Image* TextCache::lookup(const TextCacheKey& key) {
+	checkContext();
+
+	ENTRY_CONTAINER_ITER it = entries.find(key);
+	if (it == entries.end())
+		return NULL;
+
+	it->second.last_used = ++use_counter;
+	it->second.image->ref();
+	return it->second.image;
+}
+
+void TextCache::store(const TextCacheKey& key, Image* image) {
+	if (!image)
+		return;
+
+	checkContext();
+
+	ENTRY_CONTAINER_ITER it = entries.find(key);
+	if (it != entries.end()) {
+		memory -= it->second.memory;
+		it->second.image->unref();
+		entries.erase(it);
+	}
+
+	Entry entry;
+	entry.image = image;
+	entry.memory = static_cast<size_t>(image->getWidth()) * static_cast<size_t>(image->getHeight()) * (RenderDevice::BITS_PER_PIXEL / 8);
+	entry.last_used = ++use_counter;
+
+	image->ref();
+	entries[key] = entry;
+	memory += entry.memory;
+
+	if (memory > MEMORY_BUDGET)
+		evict();
+}
+
+void TextCache::clear() {
+	for (ENTRY_CONTAINER_ITER it = entries.begin(); it != entries.end(); ++it) {
+		it->second.image->unref();
+	}
+	entries.clear();
+	memory = 0;
+}
+
+size_t TextCache::getMemory() {
+	return memory;
+}
+
+size_t TextCache::getSize() {
+	return entries.size();
+}
+
+/**
+ * Images made for a previous render context can't be drawn anymore
+ */
+void TextCache::checkContext() {
+	if (context_version != render_device->getContextVersion()) {
+		clear();
+		context_version = render_device->getContextVersion();
+	}
+}
+
+/**
+ * Releases the least recently used images until the cache is comfortably under budget,
+ * so that a busy frame doesn't have to do this again for every new string.
+ * Images still referenced elsewhere (e.g. by a visible label) are kept, since releasing them wouldn't free anything.
+ */
+void TextCache::evict() {
+	std::vector<ENTRY_CONTAINER_ITER> candidates;
+	for (ENTRY_CONTAINER_ITER it = entries.begin(); it != entries.end(); ++it) {
+		if (it->second.image->getRefCount() <= 1)
+			candidates.push_back(it);
+	}
+
+	std::sort(candidates.begin(), candidates.end(), compareLastUsed);
+
+	size_t target = MEMORY_BUDGET - MEMORY_BUDGET / 4;
+	for (size_t i = 0; i < candidates.size() && memory > target; ++i) {
+		memory -= candidates[i]->second.memory;
+		candidates[i]->second.image->unref();
+		entries.erase(candidates[i]);
+	}
+}
+
+bool TextCache::compareLastUsed(const ENTRY_CONTAINER_ITER& a, const ENTRY_CONTAINER_ITER& b) {
+	return a->second.last_used < b->second.last_used;
+}
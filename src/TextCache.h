@@ -0,0 +1,83 @@
+/*
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+/**
+ * class TextCache
+ *
+ * Keeps images of recently rendered strings so that text which shows up over and over
+ * (damage numbers, item names, button labels) is only rendered once.
+ * When the images go over the memory budget, the least recently used ones
+ * that nobody else holds a reference to are released.
+ */
+
+#ifndef TEXT_CACHE_H
+#define TEXT_CACHE_H
+
+#include "CommonIncludes.h"
+#include "Utils.h"
+
+class TextCacheKey {
+public:
+	TextCacheKey(const std::string& _font_style, const std::string& _text, const Color& _color, bool _shadowed, int _width);
+	bool operator<(const TextCacheKey& other) const;
+
+	std::string font_style;
+	std::string text;
+	uint32_t color;
+	bool shadowed;
+	int width;
+};
+
+class TextCache {
+public:
+	static const size_t MEMORY_BUDGET = 16 * 1024 * 1024;
+
+	TextCache();
+	~TextCache();
+
+	// returns a new reference to the image, or NULL if it isn't cached
+	Image* lookup(const TextCacheKey& key);
+
+	// the cache takes its own reference to the image
+	void store(const TextCacheKey& key, Image* image);
+
+	void clear();
+
+	size_t getMemory();
+	size_t getSize();
+
+private:
+	class Entry {
+	public:
+		Image* image;
+		size_t memory;
+		unsigned last_used;
+	};
+
+	typedef std::map<TextCacheKey, Entry> ENTRY_CONTAINER;
+	typedef ENTRY_CONTAINER::iterator ENTRY_CONTAINER_ITER;
+
+	static bool compareLastUsed(const ENTRY_CONTAINER_ITER& a, const ENTRY_CONTAINER_ITER& b);
+
+	void checkContext();
+	void evict();
+
+	ENTRY_CONTAINER entries;
+	size_t memory;
+	unsigned use_counter;
+	unsigned context_version;
+};
+
+#endif // TEXT_CACHE_H
@@ -473,9 +473,8 @@ void Utils::logInfo(const char* format, ...) {
 	else if (LOG_FILE_CREATED) {
 		FILE *log_file = fopen(LOG_PATH.c_str(), "a");
 		if (log_file) {
-			fprintf(log_file, "INFO: ");
-			fprintf(log_file, "%s", file_buf);
-			fprintf(log_file, "\n");
+			// one call per line, so lines logged from worker threads don't get mixed up
+			fprintf(log_file, "INFO: %s\n", file_buf);
 			fclose(log_file);
 		}
 	}
@@ -500,9 +499,7 @@ void Utils::logError(const char* format, ...) {
 	else if (LOG_FILE_CREATED) {
 		FILE *log_file = fopen(LOG_PATH.c_str(), "a");
 		if (log_file) {
-			fprintf(log_file, "ERROR: ");
-			fprintf(log_file, "%s", file_buf);
-			fprintf(log_file, "\n");
+			fprintf(log_file, "ERROR: %s\n", file_buf);
 			fclose(log_file);
 		}
 	}
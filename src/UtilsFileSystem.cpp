@@ -116,6 +116,52 @@ int Filesystem::getDirList(const std::string &dir, std::vector<std::string> &dir
 	return 0;
 }
 
+/**
+ * Splits the entries of a directory into file names and directory names
+ * This reads the directory once and needs one stat() per entry
+ */
+int Filesystem::getDirContents(const std::string &dir, std::vector<std::string> &files, std::vector<std::string> &dirs) {
+	DIR *dp;
+	struct dirent *dirp;
+	struct stat st;
+
+	std::string clean_dir = convertSlashes(dir);
+	if((dp = opendir(clean_dir.c_str())) == NULL) {
+		return errno;
+	}
+
+	while ((dirp = readdir(dp)) != NULL) {
+		//	do not use dirp->d_type, it's not portable
+		std::string name = std::string(dirp->d_name);
+		if (name == "." || name == "..")
+			continue;
+
+		std::string path = convertSlashes(clean_dir + "/" + name);
+		if (stat(path.c_str(), &st) == -1)
+			continue;
+
+		if (S_ISDIR(st.st_mode))
+			dirs.push_back(name);
+		else
+			files.push_back(name);
+	}
+	closedir(dp);
+	return 0;
+}
+
+/**
+ * Gets the size and modification time of a file, used to tell if it has changed
+ */
+bool Filesystem::getFileStamp(const std::string &path, uint64_t &size, int64_t &mtime) {
+	struct stat st;
+	if (stat(convertSlashes(path).c_str(), &st) != 0 || S_ISDIR(st.st_mode))
+		return false;
+
+	size = static_cast<uint64_t>(st.st_size);
+	mtime = static_cast<int64_t>(st.st_mtime);
+	return true;
+}
+
 bool Filesystem::isDirectory(const std::string &path, bool show_error) {
 	std::string clean_path = convertSlashes(path);
 	struct stat st;
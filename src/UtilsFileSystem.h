@@ -25,6 +25,7 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 #ifndef UTILS_FILE_SYSTEM_H
 #define UTILS_FILE_SYSTEM_H
 
+#include <stdint.h>
 #include <string>
 
 namespace Filesystem {
@@ -33,8 +34,10 @@ namespace Filesystem {
 	bool fileExists(const std::string &filename);
 	int getFileList(const std::string &dir, const std::string &ext, std::vector<std::string> &files);
 	int getDirList(const std::string &dir, std::vector<std::string> &dirs);
+	int getDirContents(const std::string &dir, std::vector<std::string> &files, std::vector<std::string> &dirs);
 
 	bool isDirectory(const std::string &path, bool show_error = true);
+	bool getFileStamp(const std::string &path, uint64_t &size, int64_t &mtime);
 
 	bool removeFile(const std::string &file);
 	bool removeDir(const std::string &dir);
@@ -26,33 +26,113 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 #include "UtilsParsing.h"
 #include "WidgetLabel.h"
 
+#include <cctype>
+#include <charconv>
 #include <cstdlib>
 #include <math.h>
+#include <type_traits>
 #include <typeinfo>
 
+static const char* WHITESPACE = " \f\n\r\t\v";
+
+/**
+ * Reads a number from the start of s the same way that "stream >> value" would,
+ * skipping leading whitespace and ignoring anything after the number.
+ * Unlike a stringstream, this doesn't allocate.
+ *
+ * @return the number of characters used, or 0 if there is no number
+ */
+template <typename T>
+static size_t parseNumber(std::string_view s, T& value) {
+	size_t start = 0;
+	while (start < s.length() && isspace(static_cast<unsigned char>(s[start])))
+		++start;
+
+	// from_chars() doesn't accept a leading '+'
+	size_t pos = start;
+	if (pos + 1 < s.length() && s[pos] == '+' && s[pos+1] != '-')
+		++pos;
+
+	// streams wrap negative numbers around for unsigned types
+	bool negate = false;
+	if constexpr (std::is_unsigned<T>::value) {
+		if (pos == start && pos < s.length() && s[pos] == '-') {
+			negate = true;
+			++pos;
+		}
+	}
+
+#if defined(__cpp_lib_to_chars)
+	std::from_chars_result result = std::from_chars(s.data() + pos, s.data() + s.length(), value);
+	if (result.ec != std::errc())
+		return 0;
+	size_t end = static_cast<size_t>(result.ptr - s.data());
+#else
+	size_t end;
+	if constexpr (std::is_floating_point<T>::value) {
+		// from_chars() for floating point types isn't available everywhere yet
+		std::istringstream stream{std::string(s.substr(pos))};
+		if (!(stream >> value))
+			return 0;
+		end = stream.eof() ? s.length() : pos + static_cast<size_t>(stream.tellg());
+	}
+	else {
+		std::from_chars_result result = std::from_chars(s.data() + pos, s.data() + s.length(), value);
+		if (result.ec != std::errc())
+			return 0;
+		end = static_cast<size_t>(result.ptr - s.data());
+	}
+#endif
+
+	if (negate)
+		value = static_cast<T>(0 - value);
+
+	return end;
+}
+
+/**
+ * Finds the end of the first value in a list, as used by popFirstString()
+ */
+static size_t findSeparator(const std::string& s, char separator) {
+	if (separator == 0)
+		return s.find_first_of(",;");
+
+	return s.find(separator);
+}
+
 std::string Parse::trim(const std::string& s, const std::string& delimiters) {
-	std::string tmp = s;
-	tmp.erase(tmp.find_last_not_of(delimiters) + 1); // trim right side
-	return tmp.erase(0, tmp.find_first_not_of(delimiters)); // trim left side
+	size_t first = s.find_first_not_of(delimiters);
+	if (first == std::string::npos)
+		return "";
+	return s.substr(first, s.find_last_not_of(delimiters) - first + 1);
+}
+
+/**
+ * Same as trim() with the default delimiters, but returns a view into s instead of a copy
+ */
+std::string_view Parse::trimView(std::string_view s) {
+	size_t first = s.find_first_not_of(WHITESPACE);
+	if (first == std::string_view::npos)
+		return std::string_view();
+	return s.substr(first, s.find_last_not_of(WHITESPACE) - first + 1);
 }
 
-std::string Parse::getSectionTitle(const std::string& s) {
+std::string_view Parse::getSectionTitle(std::string_view s) {
 	size_t bracket = s.find_first_of(']');
-	if (bracket == std::string::npos) return ""; // not found
+	if (bracket == std::string_view::npos) return std::string_view(); // not found
 	return s.substr(1, bracket-1);
 }
 
-void Parse::getKeyPair(const std::string& s, std::string &key, std::string &val) {
+void Parse::getKeyPair(std::string_view s, std::string &key, std::string &val) {
 	size_t separator = s.find_first_of('=');
-	if (separator == std::string::npos) {
-		key = "";
-		val = "";
+	if (separator == std::string_view::npos) {
+		key.clear();
+		val.clear();
 		return; // not found
 	}
-	key = s.substr(0, separator);
-	val = s.substr(separator+1, s.length());
-	key = trim(key);
-	val = trim(val);
+	// assign() reuses the existing buffers, so a parser that keeps its key/val around rarely allocates here
+	key.assign(trimView(s.substr(0, separator)));
+	val.assign(trimView(s.substr(separator+1)));
 }
 
 // strip carriage return if exists
@@ -65,7 +145,7 @@ std::string Parse::stripCarriageReturn(const std::string& line) {
 	return line;
 }
 
-std::string Parse::getLine(std::ifstream &infile) {
+std::string Parse::getLine(std::istream &infile) {
 	std::string line;
 	// This is the standard way to check whether a read failed.
 	if (!getline(infile, line))
@@ -152,39 +232,39 @@ std::string Parse::toString(const std::type_info & type, void * value) {
 	return stream.str();
 }
 
-int Parse::toInt(const std::string& s, int default_value) {
+int Parse::toInt(std::string_view s, int default_value) {
 	int result;
-	if (!(std::stringstream(s) >> result))
+	if (parseNumber(s, result) == 0)
 		result = default_value;
 	return result;
 }
 
-float Parse::toFloat(const std::string& s, float default_value) {
+float Parse::toFloat(std::string_view s, float default_value) {
 	float result;
-	if (!(std::stringstream(s) >> result))
+	if (parseNumber(s, result) == 0)
 		result = default_value;
 	return result;
 }
 
-unsigned long Parse::toUnsignedLong(const std::string& s, unsigned long  default_value) {
+unsigned long Parse::toUnsignedLong(std::string_view s, unsigned long  default_value) {
 	unsigned long result;
-	if (!(std::stringstream(s) >> result))
+	if (parseNumber(s, result) == 0)
 		result = default_value;
 	return result;
 }
 
-size_t Parse::toSizeT(const std::string& s, size_t default_value) {
+size_t Parse::toSizeT(std::string_view s, size_t default_value) {
 	size_t result;
-	if (!(std::stringstream(s) >> result))
+	if (parseNumber(s, result) == 0)
 		result = default_value;
 	return result;
 }
 
-ItemID Parse::toItemID(const std::string& s, ItemID default_value) {
+ItemID Parse::toItemID(std::string_view s, ItemID default_value) {
 	return Parse::toSizeT(s, default_value);
 }
 
-PowerID Parse::toPowerID(const std::string& s, PowerID default_value) {
+PowerID Parse::toPowerID(std::string_view s, PowerID default_value) {
 	return Parse::toSizeT(s, default_value);
 }
 
@@ -241,11 +321,17 @@ Color Parse::toRGBA(std::string value) {
  */
 int Parse::toDuration(const std::string& s) {
 	int val = 0;
-	std::string suffix = "";
-	std::stringstream ss;
-	ss.str(s);
-	ss >> val;
-	ss >> suffix;
+	std::string_view view(s);
+	size_t suffix_pos = parseNumber(view, val);
+
+	// the suffix is the next word after the number
+	std::string_view suffix;
+	if (suffix_pos > 0) {
+		suffix = view.substr(suffix_pos);
+		size_t suffix_start = suffix.find_first_not_of(WHITESPACE);
+		suffix = (suffix_start == std::string_view::npos) ? std::string_view() : suffix.substr(suffix_start);
+		suffix = suffix.substr(0, suffix.find_first_of(WHITESPACE));
+	}
 
 	if (val == 0)
 		return val;
@@ -337,28 +423,15 @@ int Parse::toAlignment(const std::string &s, int default_value) {
 }
 
 std::string Parse::popFirstString(std::string &s, char separator) {
-	std::string outs = "";
-	size_t seppos;
-
-	if (separator == 0) {
-		seppos = s.find_first_of(',');
-		size_t alt_seppos = s.find_first_of(';');
-
-		if (alt_seppos != std::string::npos && alt_seppos < seppos) {
-			seppos = alt_seppos; // return the first ',' or ';'
-		}
-	}
-	else {
-		seppos = s.find_first_of(separator);
-	}
+	std::string outs;
+	size_t seppos = findSeparator(s, separator);
 
 	if (seppos == std::string::npos) {
-		outs = s;
-		s = "";
+		outs.swap(s);
 	}
 	else {
-		outs = s.substr(0, seppos);
-		s = s.substr(seppos+1, s.length());
+		outs.assign(s, 0, seppos);
+		s.erase(0, seppos+1);
 	}
 	return outs;
 }
@@ -370,11 +443,17 @@ std::string Parse::popFirstString(std::string &s, char separator) {
  * This is basically a really lazy "split" replacement
  */
 int Parse::popFirstInt(std::string &s, char separator) {
-	return Parse::toInt(popFirstString(s, separator));
+	size_t seppos = findSeparator(s, separator);
+	int result = Parse::toInt(std::string_view(s).substr(0, seppos));
+	s.erase(0, (seppos == std::string::npos) ? seppos : seppos+1);
+	return result;
 }
 
 float Parse::popFirstFloat(std::string &s, char separator) {
-	return Parse::toFloat(popFirstString(s, separator));
+	size_t seppos = findSeparator(s, separator);
+	float result = Parse::toFloat(std::string_view(s).substr(0, seppos));
+	s.erase(0, (seppos == std::string::npos) ? seppos : seppos+1);
+	return result;
 }
 
 LabelInfo Parse::popLabelInfo(std::string val) {
@@ -425,11 +504,11 @@ ItemStack Parse::toItemQuantityPair(std::string value, bool* check_pair) {
 	return r;
 }
 
-bool Parse::skipLine(const std::string& line) {
+bool Parse::skipLine(std::string_view line) {
 	if (line.length() == 0)
 		return true;
 
-	if (line.at(0) == '#')
+	if (line[0] == '#')
 		return true;
 
 	return false;
@@ -23,6 +23,7 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 #include "Utils.h"
 
 #include <string>
+#include <string_view>
 #include <typeinfo>
 
 class ItemStack;
@@ -30,20 +31,21 @@ class LabelInfo;
 
 namespace Parse {
 	std::string trim(const std::string& s, const std::string& delimiters = " \f\n\r\t\v");
+	std::string_view trimView(std::string_view s);
 
-	std::string getSectionTitle(const std::string& s);
-	void getKeyPair(const std::string& s, std::string& key, std::string& val);
+	std::string_view getSectionTitle(std::string_view s);
+	void getKeyPair(std::string_view s, std::string& key, std::string& val);
 	std::string stripCarriageReturn(const std::string& line);
-	std::string getLine(std::ifstream& infile);
+	std::string getLine(std::istream& infile);
 	bool tryParseValue(const std::type_info & type, const std::string & value, void * output);
 
 	std::string toString(const std::type_info & type, void * value);
-	int toInt(const std::string& s, int default_value = 0);
-	float toFloat(const std::string &s, float default_value = 0.0);
-	unsigned long toUnsignedLong(const std::string& s, unsigned long default_value = 0);
-	size_t toSizeT(const std::string& s, size_t default_value = 0);
-	ItemID toItemID(const std::string& s, ItemID default_value = 0);
-	PowerID toPowerID(const std::string& s, PowerID default_value = 0);
+	int toInt(std::string_view s, int default_value = 0);
+	float toFloat(std::string_view s, float default_value = 0.0);
+	unsigned long toUnsignedLong(std::string_view s, unsigned long default_value = 0);
+	size_t toSizeT(std::string_view s, size_t default_value = 0);
+	ItemID toItemID(std::string_view s, ItemID default_value = 0);
+	PowerID toPowerID(std::string_view s, PowerID default_value = 0);
 	bool toBool(std::string value);
 
 	Point toPoint(std::string value);
@@ -62,7 +64,7 @@ namespace Parse {
 
 	ItemStack toItemQuantityPair(std::string value, bool* check_pair = NULL);
 
-	bool skipLine(const std::string& line);
+	bool skipLine(std::string_view line);
 }
 
 #endif
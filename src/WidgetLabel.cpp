@@ -241,10 +241,10 @@ void WidgetLabel::recacheTextSprite() {
 		bounds.w = font->calc_width(temp_text);
 	}
 
-	image = render_device->createImage(bounds.w, bounds.h);
+	// labels with the same text share a single image
+	image = font->renderToCachedImage(font_style, temp_text, color, true, 0);
 	if (!image) return;
 
-	font->renderShadowed(temp_text, 0, 0, FontEngine::JUSTIFY_LEFT, image, 0, color);
 	label = image->createSprite();
 	image->unref();
 }
@@ -53,13 +53,15 @@ void WidgetLog::setPos(int offset_x, int offset_y) {
 	scroll_box->setPos(offset_x, offset_y);
 }
 
+std::string WidgetLog::getFontStyle(int style) {
+	if (style == FONT_BOLD)
+		return "font_bold";
+	else
+		return "font_regular";
+}
+
 void WidgetLog::setFont(int style) {
-	if (style == FONT_BOLD) {
-		font->setFont("font_bold");
-	}
-	else {
-		font->setFont("font_regular");
-	}
+	font->setFont(getFontStyle(style));
 	line_height = font->getLineHeight();
 	paragraph_spacing = line_height/2;
 }
@@ -104,7 +106,15 @@ void WidgetLog::refresh() {
 			render_target->drawLine(padding, y2, padding + content_width - 1, y2, font->getColor(FontEngine::COLOR_WIDGET_DISABLED));
 			y2 += paragraph_spacing;
 		}
-		font->renderShadowed(messages[i-1], padding, y2, FontEngine::JUSTIFY_LEFT, render_target, content_width, colors[i-1]);
+
+		// messages are rendered once and then copied, since the whole log is redrawn every time one is added
+		Image* message_image = font->renderToCachedImage(getFontStyle(styles[i-1]), messages[i-1], colors[i-1], true, content_width);
+		if (message_image) {
+			Rect src(0, 0, message_image->getWidth(), message_image->getHeight());
+			Rect dest(padding, y2, src.w, src.h);
+			render_device->renderToImage(message_image, src, render_target, dest);
+			message_image->unref();
+		}
 		y2 += size.y+paragraph_spacing;
 
 	}
@@ -30,6 +30,7 @@ class WidgetScrollBox;
 class WidgetLog : public Widget {
 private:
 	void refresh();
+	std::string getFontStyle(int style);
 	void setFont(int style);
 
 	WidgetScrollBox *scroll_box;
@@ -163,10 +163,17 @@ bool WidgetTooltip::createBuffer(TooltipData &tip) {
 	}
 
 	// concat multi-line tooltip, used in determining total display size
+	size_t fulltext_length = tip.lines.size();
+	for (unsigned int i=0; i<tip.lines.size(); i++) {
+		fulltext_length += tip.lines[i].length();
+	}
+
 	std::string fulltext;
+	fulltext.reserve(fulltext_length);
 	fulltext = tip.lines[0];
 	for (unsigned int i=1; i<tip.lines.size(); i++) {
-		fulltext = fulltext + "\n" + tip.lines[i];
+		fulltext += '\n';
+		fulltext += tip.lines[i];
 	}
 
 	font->setFont("font_regular");
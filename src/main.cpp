@@ -29,12 +29,18 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 #include "CombatText.h"
 #include "DeviceList.h"
 #include "EngineSettings.h"
+#include "FramePacer.h"
 #include "GameSwitcher.h"
 #include "InputState.h"
+#include "MapBinary.h"
+#include "MapManifest.h"
 #include "MessageEngine.h"
 #include "ModManager.h"
+#include "ModPack.h"
+#include "Profiler.h"
 #include "RenderDevice.h"
 #include "SaveLoad.h"
+#include "SDLSoftwareBlit.h"
 #include "SDLFontEngine.h"
 #include "Settings.h"
 #include "SharedResources.h"
@@ -50,8 +56,28 @@ GameSwitcher *gswitch;
 
 class CmdLineArgs {
 public:
+	CmdLineArgs()
+		: simulate_ticks(0)
+		, render_interval(0)
+		, seed(0)
+		, has_seed(false)
+		, convert_maps(false)
+		, map_manifests(false) {
+	}
+
 	std::string render_device_name;
 	std::vector<std::string> mod_list;
+
+	// used by --simulate-ticks
+	int simulate_ticks;
+	int render_interval;
+	unsigned seed;
+	bool has_seed;
+
+	std::string trace_filename;
+
+	bool convert_maps;
+	bool map_manifests;
 };
 
 #define PLATFORM_CPP_INCLUDE
@@ -95,7 +121,15 @@ static void init(const CmdLineArgs& cmd_line_args) {
 	Utils::logInfo("main: PATH_DATA = '%s'", settings->path_data.c_str());
 
 	// SDL Inits
-	if ( SDL_Init (SDL_INIT_VIDEO | SDL_INIT_AUDIO | SDL_INIT_GAMECONTROLLER) < 0 ) {
+	Uint32 sdl_init_flags = SDL_INIT_VIDEO | SDL_INIT_GAMECONTROLLER;
+	if (settings->audio)
+		sdl_init_flags |= SDL_INIT_AUDIO;
+
+	// the null renderer doesn't need a display, so don't require one (unless the user picked a video driver)
+	if (cmd_line_args.render_device_name == "null")
+		SDL_setenv("SDL_VIDEODRIVER", "dummy", 0);
+
+	if ( SDL_Init (sdl_init_flags) < 0 ) {
 		Utils::logError("main: Could not initialize SDL: %s", SDL_GetError());
 		Utils::logErrorDialog("main: Could not initialize SDL: %s", SDL_GetError());
 		Utils::Exit(1);
@@ -168,6 +202,24 @@ static void init(const CmdLineArgs& cmd_line_args) {
 	gswitch = new GameSwitcher();
 }
 
+/**
+ * Writes binary copies of the text maps for --convert-maps and their manifests for
+ * --map-manifests, without starting the game.
+ */
+static void convertMaps(const CmdLineArgs& cmd_line_args) {
+	platform.setPaths();
+
+	mods = new ModManager(&(cmd_line_args.mod_list));
+	if (cmd_line_args.convert_maps)
+		MapBinary::convertMods();
+	if (cmd_line_args.map_manifests)
+		MapManifest::writeMods();
+
+	delete mods;
+	mods = NULL;
+	ModPack::closeAll();
+}
+
 static float getSecondsElapsed(uint64_t prev_ticks, uint64_t now_ticks) {
 	return (static_cast<float>(now_ticks - prev_ticks) / static_cast<float>(SDL_GetPerformanceFrequency()));
 }
@@ -176,6 +228,18 @@ static void mainLoop () {
 	bool done = false;
 
 	float seconds_per_frame = 1.f/static_cast<float>(settings->max_frames_per_sec);
+	const uint64_t ticks_per_frame = FramePacer::secondsToTicks(seconds_per_frame);
+
+	// the pacer may wake up slightly before a deadline, which shouldn't cause a logic frame to be skipped
+	const uint64_t logic_tolerance = ticks_per_frame / 4;
+
+	FramePacer frame_pacer;
+
+	// the display's refresh rate is queried again when the context changes, and once a second in
+	// case the window was moved to another display
+	unsigned short refresh_rate = 0;
+	unsigned refresh_rate_context = 0;
+	uint64_t refresh_rate_ticks = 0;
 
 	uint64_t prev_ticks = SDL_GetPerformanceCounter();
 	uint64_t logic_ticks = SDL_GetPerformanceCounter();
@@ -184,10 +248,28 @@ static void mainLoop () {
 
 	while ( !done ) {
 		int loops = 0;
+
+		// When the display refreshes faster than the game logic runs, render at the display's rate
+		// and draw each frame in between the last two logic frames.
+		float seconds_per_render = seconds_per_frame;
+		bool interpolate = false;
+		if (settings->frame_interpolation) {
+			uint64_t query_ticks = SDL_GetPerformanceCounter();
+			if (refresh_rate_context != render_device->getContextVersion() || query_ticks - refresh_rate_ticks >= SDL_GetPerformanceFrequency()) {
+				refresh_rate = render_device->getRefreshRate();
+				refresh_rate_context = render_device->getContextVersion();
+				refresh_rate_ticks = query_ticks;
+			}
+			if (refresh_rate > settings->max_frames_per_sec) {
+				seconds_per_render = 1.f/static_cast<float>(refresh_rate);
+				interpolate = true;
+			}
+		}
+
 		// 1. Handle timing and frame limiting
 		uint64_t now_ticks = SDL_GetPerformanceCounter();
 
-		while (now_ticks >= logic_ticks && loops < settings->max_frames_per_sec) {
+		while (now_ticks + logic_tolerance >= logic_ticks && loops < settings->max_frames_per_sec) {
 			// Frames where data loading happens (GameState switching and map loading)
 			// take a long time, so our loop here will think that the game "lagged" and
 			// try to compensate. To prevent this compensation, we mark those frames as
@@ -198,8 +280,11 @@ static void mainLoop () {
 			}
 
 			// 2. Handle input
-			SDL_PumpEvents();
-			inpt->handle();
+			{
+				PROFILE_ZONE(Profiler::ZONE_INPUT);
+				SDL_PumpEvents();
+				inpt->handle();
+			}
 
 			// 3. Skip game logic when minimized
 			// *except* if the player closes the window when minimized. We then continue with the logic to properly exit
@@ -207,7 +292,10 @@ static void mainLoop () {
 				break;
 
 			// 4. Update Game Logic
-			gswitch->logic();
+			{
+				PROFILE_ZONE(Profiler::ZONE_LOGIC);
+				gswitch->logic();
+			}
 			inpt->resetScroll();
 
 			// 5. Check for exit conditions
@@ -215,7 +303,7 @@ static void mainLoop () {
 			// Input done means the user closes the window.
 			done = gswitch->done || inpt->done;
 
-			logic_ticks += static_cast<uint64_t>(seconds_per_frame * static_cast<float>(SDL_GetPerformanceFrequency()));
+			logic_ticks += ticks_per_frame;
 			loops++;
 
 			// When the app is minimized, no logic gets processed.
@@ -229,28 +317,46 @@ static void mainLoop () {
 
 			// don't skip frames if the game is paused
 			if (gswitch->isPaused()) {
-				logic_ticks = now_ticks;
+				logic_ticks = std::max(logic_ticks, now_ticks);
 				break;
 			}
 		}
 
 		// 6. Render the game
 		if (!inpt->window_minimized) {
-			render_device->blankScreen();
-			gswitch->render();
+			float interpolation = 1;
+			if (interpolate) {
+				uint64_t render_ticks = SDL_GetPerformanceCounter();
+				if (logic_ticks > render_ticks)
+					interpolation = std::max(1.f - static_cast<float>(logic_ticks - render_ticks) / static_cast<float>(ticks_per_frame), 0.f);
+			}
+			gswitch->setRenderInterpolation(interpolation);
+
+			{
+				PROFILE_ZONE(Profiler::ZONE_RENDER);
+				render_device->uploadImages();
+				render_device->blankScreen();
+				gswitch->render();
+
+				// display the FPS counter
+				if (last_fps != -1) {
+					gswitch->showFPS(last_fps);
+				}
+			}
 
-			// display the FPS counter
-			if (last_fps != -1) {
-				gswitch->showFPS(last_fps);
+			{
+				PROFILE_ZONE(Profiler::ZONE_COMMIT);
+				render_device->commitFrame();
 			}
 
-			render_device->commitFrame();
+			if (Profiler::enabled)
+				Profiler::endFrame(SDL_GetPerformanceCounter() - now_ticks);
 
 			// calculate the FPS
 			// if the frame completed quickly, we estimate the delay here
 			float fps_delay;
-			if (getSecondsElapsed(prev_ticks, SDL_GetPerformanceCounter()) < seconds_per_frame) {
-				fps_delay = seconds_per_frame;
+			if (getSecondsElapsed(prev_ticks, SDL_GetPerformanceCounter()) < seconds_per_render) {
+				fps_delay = seconds_per_render;
 			} else {
 				fps_delay = getSecondsElapsed(prev_ticks, SDL_GetPerformanceCounter());
 			}
@@ -262,18 +368,101 @@ static void mainLoop () {
 		}
 
 		// delay quick frames
-		// thanks to David Gow: https://davidgow.net/handmadepenguin/ch18.html
-		if (getSecondsElapsed(prev_ticks, SDL_GetPerformanceCounter()) < seconds_per_frame) {
-			int32_t delay_ms = static_cast<int32_t>((seconds_per_frame - getSecondsElapsed(prev_ticks, SDL_GetPerformanceCounter())) * 1000.f);
-			if (delay_ms > 0) {
-				SDL_Delay(delay_ms);
+		// When rendering at the display's rate with vsync, presenting the frame has normally already waited for the
+		// display, so the deadline is set a little early to not lose time on top of that. If the driver ignores vsync,
+		// the frame comes in well under the refresh period and the pacer still keeps the loop from spinning.
+		float seconds_to_wait = seconds_per_render;
+		if (interpolate && settings->vsync && !inpt->window_minimized)
+			seconds_to_wait *= 0.9f;
+		frame_pacer.waitUntil(prev_ticks + FramePacer::secondsToTicks(seconds_to_wait));
+		prev_ticks = SDL_GetPerformanceCounter();
+	}
+}
+
+/**
+ * Runs the game logic as fast as possible for a fixed number of ticks, then logs how long it took.
+ * Useful for profiling and for checking that changes to the logic are deterministic (see --seed).
+ */
+static void simulationLoop(const CmdLineArgs& cmd_line_args) {
+	// simulated runs should never overwrite the player's saves
+	save_load->disable_saving = true;
+
+	// advance through the title and loading screens until the game is running
+	// normally, --load-slot is used to get there without any input
+	const int MAX_WARMUP_TICKS = 10 * settings->max_frames_per_sec;
+	int warmup_ticks = 0;
+	while (!gswitch->isPlaying() && !gswitch->done && !inpt->done && warmup_ticks < MAX_WARMUP_TICKS) {
+		if (!gswitch->isLoadingFrame()) {
+			SDL_PumpEvents();
+			inpt->handle();
+			gswitch->logic();
+			inpt->resetScroll();
+		}
+		render_device->blankScreen();
+		gswitch->render();
+		render_device->commitFrame();
+		warmup_ticks++;
+	}
+
+	if (!gswitch->isPlaying()) {
+		Utils::logError("main: Simulation could not reach gameplay. Use --load-slot to choose a saved game.");
+		return;
+	}
+
+	Utils::logInfo("main: Simulating %d ticks...", cmd_line_args.simulate_ticks);
+
+	Profiler::reset();
+	Profiler::setEnabled(true);
+
+	int ticks = 0;
+	unsigned rendered_frames = 0;
+	uint64_t start_ticks = SDL_GetPerformanceCounter();
+
+	while (ticks < cmd_line_args.simulate_ticks && !gswitch->done && !inpt->done) {
+		// map loading frames still have to be consumed, but they don't count as simulated ticks
+		if (gswitch->isLoadingFrame()) {
+			render_device->blankScreen();
+			gswitch->render();
+			render_device->commitFrame();
+			continue;
+		}
+
+		{
+			PROFILE_ZONE(Profiler::ZONE_INPUT);
+			SDL_PumpEvents();
+			inpt->handle();
+		}
+		{
+			PROFILE_ZONE(Profiler::ZONE_LOGIC);
+			gswitch->logic();
+		}
+		inpt->resetScroll();
+		ticks++;
+
+		// done every tick, so decoded images don't pile up when frames are rarely (or never) rendered
+		render_device->uploadImages();
+
+		if (cmd_line_args.render_interval > 0 && ticks % cmd_line_args.render_interval == 0) {
+			{
+				PROFILE_ZONE(Profiler::ZONE_RENDER);
+				render_device->blankScreen();
+				gswitch->render();
 			}
-			while (getSecondsElapsed(prev_ticks, SDL_GetPerformanceCounter()) < seconds_per_frame) {
-				// Waiting...
+			{
+				PROFILE_ZONE(Profiler::ZONE_COMMIT);
+				render_device->commitFrame();
 			}
+			rendered_frames++;
 		}
-		prev_ticks = SDL_GetPerformanceCounter();
 	}
+
+	uint64_t total_ticks = SDL_GetPerformanceCounter() - start_ticks;
+	Profiler::setEnabled(false);
+
+	float seconds = getSecondsElapsed(0, total_ticks);
+	float ticks_per_sec = seconds > 0 ? static_cast<float>(ticks) / seconds : 0;
+	Utils::logInfo("main: Simulated %d ticks (%u rendered) in %.3f seconds: %.1f ticks/s, %.1fx real time.", ticks, rendered_frames, seconds, ticks_per_sec, ticks_per_sec / static_cast<float>(settings->max_frames_per_sec));
+	Profiler::logSummary(static_cast<unsigned>(ticks), total_ticks);
 }
 
 static void cleanup() {
@@ -295,6 +484,9 @@ static void cleanup() {
 		render_device->destroyContext();
 	delete render_device;
 
+	// fonts, sounds and images may have been reading from the mapped packs until now
+	ModPack::closeAll();
+
 	SDL_Quit();
 }
 
@@ -413,6 +605,29 @@ int main(int argc, char *argv[]) {
 		else if (arg == "safe-video") {
 			settings->safe_video = true;
 		}
+		else if (arg == "simulate-ticks") {
+			cmd_line_args.simulate_ticks = std::max(Parse::toInt(parseArgValue(arg_full)), 0);
+		}
+		else if (arg == "render-every") {
+			cmd_line_args.render_interval = std::max(Parse::toInt(parseArgValue(arg_full)), 0);
+		}
+		else if (arg == "seed") {
+			cmd_line_args.seed = static_cast<unsigned>(Parse::toUnsignedLong(parseArgValue(arg_full)));
+			cmd_line_args.has_seed = true;
+		}
+		else if (arg == "trace") {
+			cmd_line_args.trace_filename = parseArgValue(arg_full);
+		}
+		else if (arg == "convert-maps") {
+			cmd_line_args.convert_maps = true;
+		}
+		else if (arg == "map-manifests") {
+			cmd_line_args.map_manifests = true;
+		}
+		else if (arg == "benchmark-blit") {
+			SoftwareBlit::benchmark();
+			done = true;
+		}
 		else if (arg == "help") {
 			Utils::logInfo("Command line options:\n\
 --help                   Prints this message.\n\
@@ -420,13 +635,34 @@ int main(int argc, char *argv[]) {
 --data-path=<PATH>       Specifies an exact path to look for mod data.\n\
 --debug-event            Prints verbose hardware input information.\n\
 --renderer=<RENDERER>    Specifies the rendering backend to use.\n\
-                         The default is 'sdl'.\n\
+                         The default is 'sdl'. 'null' runs without a\n\
+                         display and draws nothing.\n\
 --no-audio               Disables sound effects and music.\n\
 --mods=<MOD>,...         Starts the game with only these mods enabled.\n\
 --load-slot=<SLOT>       Loads a save slot by numerical index.\n\
 --load-script=<SCRIPT>   Execute's a script upon loading a saved game.\n\
                          The script path is mod-relative.\n\
---safe-video             Launches with the minimum video settings.");
+--safe-video             Launches with the minimum video settings.\n\
+--simulate-ticks=<N>     Runs N ticks of game logic as fast as possible,\n\
+                         then prints the tick rate and the time spent in\n\
+                         each subsystem, and exits. Combine with\n\
+                         --load-slot. Saving is disabled.\n\
+--render-every=<K>       Renders every Kth tick while simulating. The\n\
+                         default is 0, which never renders.\n\
+--seed=<SEED>            Seeds the random number generator with a fixed\n\
+                         value for repeatable runs.\n\
+--trace=<FILE>           Records the time spent in each subsystem and\n\
+                         writes it to FILE on exit, in the Chrome trace\n\
+                         format (chrome://tracing or ui.perfetto.dev).\n\
+--convert-maps           Writes a binary copy of each map in the enabled\n\
+                         mods next to the text map, which loads faster.\n\
+                         Combine with --mods. Exits when done.\n\
+--map-manifests          Writes a list of the images each map in the\n\
+                         enabled mods needs next to the text map, so\n\
+                         they can be loaded in parallel. Combine with\n\
+                         --mods. Exits when done.\n\
+--benchmark-blit         Compares the software renderer's blitting\n\
+                         kernels with SDL_BlitSurface() and exits.");
 			done = true;
 		}
 		else {
@@ -434,9 +670,17 @@ int main(int argc, char *argv[]) {
 		}
 	}
 
+	if (!done && (cmd_line_args.convert_maps || cmd_line_args.map_manifests)) {
+		convertMaps(cmd_line_args);
+		done = true;
+	}
+
 soft_reset:
 	if (!done) {
-		srand(static_cast<unsigned int>(time(NULL)));
+		if (cmd_line_args.has_seed)
+			srand(cmd_line_args.seed);
+		else
+			srand(static_cast<unsigned int>(time(NULL)));
 #ifdef __EMSCRIPTEN__
 		platform.FSInit();
 		emscripten_set_main_loop(EmscriptenMainLoop, settings->max_frames_per_sec, 1);
@@ -446,7 +690,18 @@ soft_reset:
 		if (debug_event)
 			inpt->enableEventLog();
 
-		mainLoop();
+		if (!cmd_line_args.trace_filename.empty())
+			Profiler::startTrace(cmd_line_args.trace_filename);
+
+		if (cmd_line_args.simulate_ticks > 0) {
+			simulationLoop(cmd_line_args);
+			settings->soft_reset = false;
+		}
+		else {
+			mainLoop();
+		}
+
+		Profiler::stopTrace();
 #endif
 
 		if (gswitch)